@@ -1,6 +1,7 @@
 ; Tests ACI instruction
 ; Conditions: Carry flag should be set before running aci instruction
 ; Expected Results: reg a = 57h(87)
+; EXPECT: A=57H CY=0 Z=0 S=0
 MVI A, 14H
 CMC ; Complementary carry
 ACI 42h
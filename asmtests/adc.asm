@@ -1,5 +1,6 @@
 ; Test ADC Instruction
 ; Expected result: reg a = 80h(128)
+; EXPECT: A=80H S=1 Z=0 AC=1 CY=0
 MVI C, 3DH
 MVI A, 42H
 CMC ; Complementary carry
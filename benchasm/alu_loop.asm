@@ -0,0 +1,23 @@
+; Tight ALU loop over register operands
+; 64 x 255 iterations of eight register ALU instructions
+MVI B, 35H
+MVI E, 5AH
+MVI H, C3H
+MVI L, 0FH
+MVI D, 40H
+OUTER:
+MVI C, FFH
+INNER:
+ADD B
+XRA E
+ADC H
+ANA L
+ORA B
+SUB E
+SBB L
+CMP H
+DCR C
+JNZ INNER
+DCR D
+JNZ OUTER
+HLT
@@ -0,0 +1,33 @@
+; BCD arithmetic
+; Adds the packed BCD number 12345679 to a 4 byte accumulator at 3010H 8192 times
+LXI SP, F000H
+LXI H, 3020H
+MVI M, 79H
+INX H
+MVI M, 56H
+INX H
+MVI M, 34H
+INX H
+MVI M, 12H
+LXI B, 2000H
+LOOP:
+LXI D, 3020H
+LXI H, 3010H
+PUSH B
+MVI C, 04H
+ORA A
+DIGITS:
+LDAX D
+ADC M
+DAA
+MOV M, A
+INX D
+INX H
+DCR C
+JNZ DIGITS
+POP B
+DCX B
+MOV A, B
+ORA C
+JNZ LOOP
+HLT
@@ -0,0 +1,44 @@
+; Bubble sort
+; Sorts 64 pseudo random bytes at 4000H, refilled and sorted 16 times
+LXI SP, F000H
+MVI A, 10H
+STA 3000H
+MVI E, 01H
+PASS:
+LXI H, 4000H
+MVI C, 40H
+FILL:
+MOV A, E
+ADD A
+ADD A
+ADD E
+ADI 11H
+MOV E, A
+MOV M, A
+INX H
+DCR C
+JNZ FILL
+MVI D, 3FH
+OUTER:
+LXI H, 4000H
+MOV C, D
+INNER:
+MOV B, M
+INX H
+MOV A, M
+CMP B
+JNC NOSWAP
+MOV M, B
+DCX H
+MOV M, A
+INX H
+NOSWAP:
+DCR C
+JNZ INNER
+DCR D
+JNZ OUTER
+LDA 3000H
+DCR A
+STA 3000H
+JNZ PASS
+HLT
@@ -0,0 +1,45 @@
+; CRC-16/CCITT (polynomial 1021H, initial value FFFFH)
+; Computed a bit at a time over a 1 KiB block at 4000H, 16 times
+; The result is stored at 3002H
+LXI SP, F000H
+LXI H, 4000H
+LXI B, 0400H
+FILL:
+MOV M, L
+INX H
+DCX B
+MOV A, B
+ORA C
+JNZ FILL
+MVI A, 10H
+STA 3000H
+PASS:
+LXI D, 4000H
+LXI H, FFFFH
+BYTE:
+LDAX D
+XRA H
+MOV H, A
+MVI C, 08H
+BIT:
+DAD H
+JNC NEXT
+MOV A, H
+XRI 10H
+MOV H, A
+MOV A, L
+XRI 21H
+MOV L, A
+NEXT:
+DCR C
+JNZ BIT
+INX D
+MOV A, D
+CPI 44H
+JNZ BYTE
+SHLD 3002H
+LDA 3000H
+DCR A
+STA 3000H
+JNZ PASS
+HLT
@@ -0,0 +1,32 @@
+; Memory copy
+; Fills a 1 KiB block at 4000H and copies it to 6000H 64 times
+LXI SP, F000H
+LXI H, 4000H
+LXI B, 0400H
+FILL:
+MOV M, L
+INX H
+DCX B
+MOV A, B
+ORA C
+JNZ FILL
+MVI A, 40H
+STA 3000H
+PASS:
+LXI H, 4000H
+LXI D, 6000H
+LXI B, 0400H
+COPY:
+MOV A, M
+STAX D
+INX H
+INX D
+DCX B
+MOV A, B
+ORA C
+JNZ COPY
+LDA 3000H
+DCR A
+STA 3000H
+JNZ PASS
+HLT
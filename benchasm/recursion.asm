@@ -0,0 +1,31 @@
+; Call heavy recursion
+; Naive recursive fibonacci, fib(20) computed 8 times and stored at 3000H
+LXI SP, F000H
+MVI B, 08H
+REP:
+MVI A, 14H
+CALL FIB
+DCR B
+JNZ REP
+XCHG
+SHLD 3000H
+HLT
+; Returns fib(A) in DE
+FIB:
+CPI 02H
+JNC RECURSE
+MOV E, A
+MVI D, 00H
+RET
+RECURSE:
+DCR A
+PUSH PSW
+CALL FIB
+POP PSW
+PUSH D
+DCR A
+CALL FIB
+POP H
+DAD D
+XCHG
+RET
@@ -10,7 +10,7 @@ SET INCLUDE_DIRS=/I..\thirdparty\glfw\include /I..\thirdparty\imgui\backends /I.
 SET SRC_FILES=..\src\*.cpp ..\thirdparty\imgui\backends\imgui_impl_glfw.cpp ..\thirdparty\imgui\backends\imgui_impl_opengl3.cpp ..\thirdparty\imgui\imgui*.cpp 
 SET MAIN_FILE=..\src\main.cpp
 
-SET CFLAGS=/EHsc /MD /Zi /nologo /Fe"lib8085test" 
+SET CFLAGS=/std:c++17 /EHsc /MD /Zi /nologo /Fe"lib8085test" 
 
 pushd .
 mkdir build
@@ -0,0 +1,26 @@
+@ECHO OFF
+
+SET LIB_DIRS=
+
+SET LIBS=
+
+SET INCLUDE_DIRS=
+
+SET SRC_FILES=..\src\assembler.cpp ..\src\assembler_util.cpp ..\src\expression.cpp ..\src\diagnostics.cpp ..\src\object.cpp ..\src\lib8085.cpp ..\src\memory_pool.cpp
+SET MAIN_FILE=..\src\bench\main.cpp
+
+SET CFLAGS=/std:c++17 /EHsc /MD /O2 /Zi /nologo /Fe"retro85b"
+
+SET WORKLOADS=..\benchasm\alu_loop.asm ..\benchasm\memcpy.asm ..\benchasm\bubble_sort.asm ..\benchasm\crc16.asm ..\benchasm\bcd.asm ..\benchasm\recursion.asm
+
+pushd .
+mkdir build
+cd build
+
+cl %SRC_FILES% %MAIN_FILE% %INCLUDE_DIRS% %CFLAGS% /link %LIB_DIRS% %LIBS%
+
+if ERRORLEVEL 1 GOTO EXIT
+call retro85b.exe %WORKLOADS%
+
+:EXIT
+popd
@@ -7,10 +7,10 @@ SET LIBS=
 
 SET INCLUDE_DIRS=
 
-SET SRC_FILES=..\src\assembler.cpp ..\src\assembler_util.cpp ..\src\lib8085.cpp
+SET SRC_FILES=..\src\assembler.cpp ..\src\assembler_util.cpp ..\src\expression.cpp ..\src\diagnostics.cpp ..\src\object.cpp ..\src\linker.cpp ..\src\build_cache.cpp ..\src\lib8085.cpp ..\src\input_log.cpp ..\src\savestate.cpp ..\src\memory_pool.cpp ..\src\sweep.cpp ..\src\state_field.cpp ..\src\test_runner.cpp ..\src\reference_cpu.cpp ..\src\differential.cpp ..\src\instruction_sweep.cpp ..\src\source_map.cpp ..\src\profiler.cpp ..\src\call_graph.cpp ..\src\coverage.cpp ..\src\trace.cpp
 SET MAIN_FILE=..\src\cli\main.cpp
 
-SET CFLAGS=/EHsc /MD /Zi /nologo /Fe"retro85a"
+SET CFLAGS=/std:c++17 /EHsc /MD /Zi /nologo /Fe"retro85a"
 
 pushd .
 mkdir build
@@ -21,6 +21,8 @@ cl %SRC_FILES% %MAIN_FILE% %INCLUDE_DIRS% %CFLAGS% /link %LIB_DIRS% %LIBS%
 if ERRORLEVEL 1 GOTO EXIT
 call retro85a.exe -a exampleasm/hello.asm
 call retro85a.exe -d exampleasm/hello.asm.retro85
+call retro85a.exe -t ..\asmtests\aci.asm ..\asmtests\adc.asm
+call retro85a.exe -e
 
 :EXIT
 popd
@@ -0,0 +1,44 @@
+@ECHO OFF
+
+REM Needs clang-cl from the LLVM toolchain, libFuzzer isn't available with cl
+
+SET LIB_DIRS=
+
+SET LIBS=
+
+SET INCLUDE_DIRS=
+
+SET ASM_SRC_FILES=..\src\assembler.cpp ..\src\assembler_util.cpp ..\src\expression.cpp ..\src\diagnostics.cpp ..\src\object.cpp
+SET CPU_SRC_FILES=..\src\lib8085.cpp ..\src\memory_pool.cpp ..\src\reference_cpu.cpp
+
+SET CFLAGS=/std:c++17 /EHsc /MD /O1 /Zi /nologo /fsanitize=address /fsanitize=fuzzer -fsanitize=undefined
+
+SET SEED_FILES=..\asmtests\*.asm ..\exampleasm\*.asm ..\benchasm\*.asm
+
+pushd .
+mkdir build
+cd build
+
+clang-cl %ASM_SRC_FILES% ..\src\fuzz\fuzz_assembler.cpp %INCLUDE_DIRS% %CFLAGS% /Fe"fuzz_assembler" /link %LIB_DIRS% %LIBS%
+if ERRORLEVEL 1 GOTO EXIT
+
+clang-cl %CPU_SRC_FILES% ..\src\fuzz\fuzz_processor.cpp %INCLUDE_DIRS% %CFLAGS% /Fe"fuzz_processor" /link %LIB_DIRS% %LIBS%
+if ERRORLEVEL 1 GOTO EXIT
+
+REM Seed corpus, source text for the assembler and assembled programs for the processor
+mkdir corpus_assembler
+mkdir corpus_processor
+for %%f in (%SEED_FILES%) do copy /Y %%f corpus_assembler\ > NUL
+for %%f in (%SEED_FILES%) do copy /Y %%f corpus_processor\ > NUL
+
+REM The first bytes of each assembled program become its initial register state
+if exist retro85a.exe (
+    for %%f in (corpus_processor\*.asm) do call retro85a.exe -a %%f > NUL
+    del /Q corpus_processor\*.asm
+)
+
+call fuzz_assembler.exe corpus_assembler -max_total_time=60
+call fuzz_processor.exe corpus_processor -max_total_time=60
+
+:EXIT
+popd
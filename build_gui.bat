@@ -7,10 +7,10 @@ SET LIBS= glfw3.lib kernel32.lib opengl32.lib gdi32.lib shell32.lib
 
 SET INCLUDE_DIRS=/I..\thirdparty\glfw\include /I..\thirdparty\imgui\backends /I..\thirdparty\imgui
 
-SET SRC_FILES=..\src\assembler.cpp ..\src\assembler_util.cpp ..\src\lib8085.cpp ..\src\gui\app.cpp ..\thirdparty\imgui\backends\imgui_impl_glfw.cpp ..\thirdparty\imgui\backends\imgui_impl_opengl3.cpp ..\thirdparty\imgui\imgui*.cpp 
+SET SRC_FILES=..\src\assembler.cpp ..\src\assembler_util.cpp ..\src\expression.cpp ..\src\diagnostics.cpp ..\src\object.cpp ..\src\lib8085.cpp ..\src\input_log.cpp ..\src\savestate.cpp ..\src\memory_pool.cpp ..\src\sweep.cpp ..\src\state_field.cpp ..\src\gui\app.cpp ..\thirdparty\imgui\backends\imgui_impl_glfw.cpp ..\thirdparty\imgui\backends\imgui_impl_opengl3.cpp ..\thirdparty\imgui\imgui*.cpp 
 SET MAIN_FILE=..\src\gui\main.cpp
 
-SET CFLAGS=/EHsc /MD /Zi /nologo /Fe"retro85" 
+SET CFLAGS=/std:c++17 /EHsc /MD /Zi /nologo /Fe"retro85" 
 
 pushd .
 mkdir build
@@ -0,0 +1,24 @@
+@ECHO OFF
+
+SET LIB_DIRS=
+
+SET LIBS=
+
+SET INCLUDE_DIRS=
+
+SET SRC_FILES=..\src\assembler.cpp ..\src\assembler_util.cpp ..\src\expression.cpp ..\src\diagnostics.cpp ..\src\object.cpp ..\src\lib8085.cpp ..\src\memory_pool.cpp ..\src\source_map.cpp ..\src\profiler.cpp ..\src\call_graph.cpp ..\src\coverage.cpp ..\src\trace.cpp
+SET MAIN_FILE=..\src\tests\memory_pool_test.cpp
+
+SET CFLAGS=/std:c++17 /EHsc /MD /Zi /nologo /Fe"memory_pool_test"
+
+pushd .
+mkdir build
+cd build
+
+cl %SRC_FILES% %MAIN_FILE% %INCLUDE_DIRS% %CFLAGS% /link %LIB_DIRS% %LIBS%
+
+if ERRORLEVEL 1 GOTO EXIT
+call memory_pool_test.exe
+
+:EXIT
+popd
@@ -1,65 +1,556 @@
 #include "assembler.h"
 #include "instruction_set.h"
-#include "assembler_util.h"
+#include "keywords.h"
+#include "isa.h"
 
 #include <iostream>
-#include <sstream>
 #include <vector>
 #include <algorithm>
 #include <cctype>
+#include <unordered_set>
+#include <iterator>
+#include <cstdio>
 
 namespace lib8085
 {
+    static std::string to_upper(std::string_view str)
+    {
+        std::string upper(str);
+        std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return (char)std::toupper(c); });
+        return upper;
+    }
+
+    // Diagnostic codes, stable so tools can match on them
+    static const char* const DIAG_UNTERMINATED_STRING = "A001";
+    static const char* const DIAG_UNKNOWN_INSTRUCTION = "A002";
+    static const char* const DIAG_MISSING_OPERAND = "A003";
+    static const char* const DIAG_INVALID_OPERAND = "A004";
+    static const char* const DIAG_OPERAND_RANGE = "A005";
+    static const char* const DIAG_UNKNOWN_LABEL = "A006";
+    static const char* const DIAG_REFERENCE_RANGE = "A007";
+    static const char* const DIAG_UNSUPPORTED = "A008";
+    static const char* const DIAG_UNEXPECTED_TOKEN = "A009";
+    static const char* const DIAG_EMPTY = "A010";
+    static const char* const DIAG_LABEL_REDEFINED = "A011";
+    static const char* const DIAG_INVALID_OPCODE = "D001";
+    static const char* const DIAG_TRUNCATED = "D002";
+
+    // Mnemonic and operand of the instruction starting at bytes, all of it present
+    static std::string format_instruction(const IsaEntry& entry, const uint8_t* bytes)
+    {
+        // Formatted by hand, label fixups redo this for every instruction they touch
+        char operand[8] = "";
+
+        if(entry.operand == OPERAND_BYTE)
+        {
+            std::snprintf(operand, sizeof(operand), "0x%x", bytes[1]);
+        }
+        else if(entry.operand == OPERAND_WORD)
+        {
+            uint16_t operand_word = 0;
+            operand_word |= bytes[2] << 8;
+            operand_word |= bytes[1];
+            std::snprintf(operand, sizeof(operand), "0x%x", operand_word);
+        }
+
+        std::string text(entry.mnemonic);
+        text += ' ';
+        text += operand;
+        return text;
+    }
+
+    // Moves the entries from first on by delta without reallocating them, the keys they land on must be free
+    template<typename Map>
+    static void shift_keys(Map& map, size_t first, long long delta)
+    {
+        typedef typename Map::key_type Key;
+
+        if(delta > 0)
+        {
+            // From the back so no entry passes one that hasn't moved yet
+            auto it = map.end();
+            while(it != map.begin() && std::prev(it)->first >= first)
+            {
+                auto node = map.extract(std::prev(it));
+                node.key() = (Key)(node.key() + delta);
+                it = map.insert(it, std::move(node));
+            }
+        }
+        else if(delta < 0)
+        {
+            for(auto it = map.lower_bound((Key)first); it != map.end(); )
+            {
+                auto next = std::next(it);
+                auto node = map.extract(it);
+                node.key() = (Key)(node.key() + delta);
+                map.insert(next, std::move(node));
+                it = next;
+            }
+        }
+    }
+
     Assembler::Assembler() : Assembler(std::string())
     {
     }
 
-    Assembler::Assembler(std::string& code) : _code(code), m_tokens(nullptr)
+    Assembler::Assembler(std::string& code) : _code(code), _log(nullptr), _allow_imports(false), _generation(0), _line_mode(false),
+        _line_fixups_failed(false)
     {
-        _opcode_strs = { "ACI" , "ADC" , "ADD" , "ADI" , "ANA" , "ANI" , "CALL" , "CC" , "CM," , "CMA" , "CMC" , "CMP" , "CNC" , "CNZ" , "CP," , "CPE" , "CPI" , "CPO" , "CZ," , "DAA" , "DAD" , "DCR" , "DCX" , "DI," , "EI," , "HLT" , "IN," , "INR" , "INX" , "JC," , "JM," , "JMP" , "JNC" , "JNZ" , "JP," , "JPE" , "JPO" , "JZ," , "LDA" , "LDAX" , "LHLD" , "LXI" , "MOV" , "MVI" , "NOP" , "ORA" , "ORI" , "OUT" , "PCHL" , "POP" , "PUSH" , "RAL" , "RAR" , "RC," , "RET" , "RIM" , "RLC" , "RM," , "RNC" , "RNZ" , "RP," , "RPE" , "RPO" , "RRC" , "RST_0" , "RST_1" , "RST_2" , "RST_3" , "RST_4" , "RST_5" , "RST_6" , "RST_7" , "RZ" , "SBB" , "SBI" , "SHLD" , "SIM" , "SPH" , "STA" , "STAX" , "STC" , "SUB" , "SUI" , "XCHG" , "XRA" , "XRI" , "XTHL" };
     }
 
     std::vector<uint8_t> Assembler::assemble()
     {
         tokenize();
 
+        // Nothing half assembled is handed out, the diagnostics say what went wrong
         if(!parse())
         {
-            std::cout << "Parsing was not successful\n";
-        };
+            return std::vector<uint8_t>();
+        }
 
         disassemble();
 
         return _program_instructions;
     }
     
-    Assembler::~Assembler()
+    bool Assembler::assemble_object(ObjectModule& module)
+    {
+        module.clear();
+
+        _allow_imports = true;
+        tokenize();
+        bool assembled = parse();
+        _allow_imports = false;
+
+        if(!assembled)
+        {
+            return false;
+        }
+
+        ObjectSection code;
+        code.name = "CODE";
+        code.data = _program_instructions;
+        module.sections.push_back(std::move(code));
+
+        // Sorted by name so the same source always gives the same object
+        std::map<std::string, const SymbolValue*> defined;
+        std::map<std::string, const SymbolValue*> imported;
+        for(const auto& it : _symbol_table)
+        {
+            defined[it.first] = &it.second;
+        }
+        for(const auto& it : _imports)
+        {
+            imported[it.first] = &it.second;
+        }
+
+        for(const std::map<std::string, const SymbolValue*>* symbols : { &defined, &imported })
+        {
+            for(const auto& it : *symbols)
+            {
+                ObjectSymbol symbol;
+                symbol.name = it.first;
+                symbol.defined = symbols == &defined;
+                symbol.value = symbol.defined ? it.second->value : 0;
+
+                // Label operands were recorded by parse as references
+                for(int ref : it.second->references)
+                {
+                    module.relocations.push_back(Relocation{ 0, (uint16_t)ref, (uint32_t)module.symbols.size() });
+                }
+
+                module.symbols.push_back(std::move(symbol));
+            }
+        }
+
+        // Expressions add their constant to the address of their label or of the section for $
+        std::unordered_map<std::string_view, uint32_t> indexes;
+        for(size_t i = 0; i < module.symbols.size(); i ++)
+        {
+            indexes[module.symbols[i].name] = (uint32_t)i;
+        }
+
+        for(const Fixup& fixup : _fixups)
+        {
+            int term;
+            int32_t constant;
+            fixup.expression.linear(term, constant);
+
+            if(term == Expression::LOCATION)
+            {
+                module.relocations.push_back(Relocation{ 0, fixup.offset, Relocation::SECTION, (uint16_t)(fixup.location + constant) });
+            }
+            else
+            {
+                module.relocations.push_back(Relocation{ 0, fixup.offset, indexes[fixup.expression.symbols()[term]], (uint16_t)constant });
+            }
+        }
+
+        std::sort(module.relocations.begin(), module.relocations.end(), [](const Relocation& a, const Relocation& b)
+        {
+            return a.offset < b.offset;
+        });
+
+        return true;
+    }
+
+    std::vector<uint8_t> Assembler::assemble_incremental()
+    {
+        const std::string_view code(_code);
+
+        _generation++;
+        _tokens.clear();
+
+        // Addresses past 16 bits wrapped in the source map, start over
+        if(_program_instructions.size() > 0xffff)
+        {
+            _layout.clear();
+        }
+
+        if(_layout.empty())
+        {
+            _program_instructions.clear();
+            _source_lines.clear();
+            _disassembly.clear();
+            _symbol_table = std::unordered_map<std::string, lib8085::SymbolValue>();
+        }
+
+        // Lines at the start and the end of the source that are the same as last time keep their place
+        size_t prefix = 0;
+        size_t prefix_end = 0;
+        while(prefix < _layout.size())
+        {
+            const std::string& text = _layout[prefix].line->text;
+            if(code.compare(prefix_end, text.size(), text) != 0 || (text.back() != '\n' && prefix_end + text.size() != code.size()))
+            {
+                break;
+            }
+            prefix_end += text.size();
+            prefix++;
+        }
+
+        size_t suffix = 0;
+        size_t suffix_start = code.size();
+        while(prefix + suffix < _layout.size())
+        {
+            const std::string& text = _layout[_layout.size() - suffix - 1].line->text;
+            if(text.size() > suffix_start - prefix_end || code.compare(suffix_start - text.size(), text.size(), text) != 0)
+            {
+                break;
+            }
+
+            const size_t start = suffix_start - text.size();
+            if(start != prefix_end && code[start - 1] != '\n')
+            {
+                break;
+            }
+            suffix_start = start;
+            suffix++;
+        }
+
+        // Only the lines in between are looked up, and assembled when they are new
+        std::vector<LineLayout> changed;
+        std::vector<uint8_t> changed_program;
+        for(size_t start = prefix_end; start < suffix_start; )
+        {
+            // Lines keep their newline, without one the last token is dropped like assemble() does
+            size_t end = code.find('\n', start);
+            end = end == std::string_view::npos || end >= suffix_start ? suffix_start : end + 1;
+            const std::string_view text = code.substr(start, end - start);
+            start = end;
+
+            auto cached = _line_cache.find(text);
+            if(cached == _line_cache.end())
+            {
+                std::unique_ptr<AssembledLine> assembled(new AssembledLine());
+                assembled->text = std::string(text);
+                assemble_line(*assembled);
+
+                const std::string_view key(assembled->text);
+                cached = _line_cache.emplace(key, std::move(assembled)).first;
+            }
+
+            AssembledLine* line = cached->second.get();
+            changed.push_back(LineLayout{ line, 0 });
+            changed_program.insert(changed_program.end(), line->program.begin(), line->program.end());
+        }
+
+        const size_t removed_end = _layout.size() - suffix;
+        const size_t old_start = prefix < _layout.size() ? _layout[prefix].address : _program_instructions.size();
+        const size_t old_end = suffix ? _layout[removed_end].address : _program_instructions.size();
+        const long long delta = (long long)changed_program.size() - (long long)(old_end - old_start);
+        const long long line_delta = (long long)changed.size() - (long long)(removed_end - prefix);
+
+        // Splice the changed code in, what follows only moves
+        _program_instructions.erase(_program_instructions.begin() + old_start, _program_instructions.begin() + old_end);
+        _program_instructions.insert(_program_instructions.begin() + old_start, changed_program.begin(), changed_program.end());
+
+        _source_lines.erase(_source_lines.lower_bound((uint16_t)old_start), _source_lines.lower_bound((uint16_t)old_end));
+        _disassembly.erase(_disassembly.lower_bound(old_start), _disassembly.lower_bound(old_end));
+        shift_keys(_source_lines, old_end, delta);
+        shift_keys(_disassembly, old_end, delta);
+
+        if(line_delta)
+        {
+            for(auto it = _source_lines.lower_bound((uint16_t)(old_end + delta)); it != _source_lines.end(); it++)
+            {
+                it->second += (int)line_delta;
+            }
+        }
+
+        _layout.erase(_layout.begin() + prefix, _layout.begin() + removed_end);
+        _layout.insert(_layout.begin() + prefix, changed.begin(), changed.end());
+
+        auto source_line = _source_lines.lower_bound((uint16_t)old_start);
+        auto disassembly = _disassembly.lower_bound(old_start);
+        size_t address = old_start;
+        for(size_t i = prefix; i < prefix + changed.size(); i ++)
+        {
+            AssembledLine& line = *_layout[i].line;
+            _layout[i].address = address;
+
+            for(size_t j = 0; j < line.instructions.size(); j ++)
+            {
+                source_line = std::next(_source_lines.emplace_hint(source_line, (uint16_t)(address + line.instructions[j]), (int)i + 1));
+                disassembly = std::next(_disassembly.emplace_hint(disassembly, address + line.instructions[j], line.disassembly[j]));
+            }
+            address += line.program.size();
+        }
+
+        for(size_t i = prefix + changed.size(); i < _layout.size(); i ++)
+        {
+            _layout[i].address += delta;
+        }
+
+        // Labels, their references and the diagnostics are worked out again from the cached lines
+        _diagnostics.clear();
+        std::unordered_set<std::string_view> defined_labels;
+        // Labels whose address changed, expressions that name none of them keep their value
+        std::unordered_set<std::string_view> moved_labels;
+
+        for(size_t i = 0; i < _layout.size(); i ++)
+        {
+            AssembledLine& line = *_layout[i].line;
+            line.generation = _generation;
+
+            for(const Diagnostic& d : line.diagnostics)
+            {
+                _diagnostics.report(d.severity, d.code.c_str(), (int)i + 1, d.column, d.message);
+            }
+
+            for(const LineSymbol& label : line.labels)
+            {
+                if(!defined_labels.insert(label.name).second)
+                {
+                    _diagnostics.warning(DIAG_LABEL_REDEFINED, (int)i + 1, label.column,
+                            "Label \'" + label.name + "\' is defined again, references use this address");
+                }
+
+                const uint16_t value = (uint16_t)(_layout[i].address + label.offset);
+                auto sv = _symbol_table.try_emplace(label.name);
+                if(sv.second || sv.first->second.value != value)
+                {
+                    moved_labels.insert(label.name);
+                }
+                sv.first->second.value = value;
+                sv.first->second.references.clear();
+            }
+        }
+
+        // Labels edited away
+        const bool labels_removed = _symbol_table.size() != defined_labels.size();
+        if(labels_removed)
+        {
+            for(auto it = _symbol_table.begin(); it != _symbol_table.end(); )
+            {
+                it = defined_labels.count(it->first) ? std::next(it) : _symbol_table.erase(it);
+            }
+        }
+
+        for(size_t i = 0; i < _layout.size(); i ++)
+        {
+            const AssembledLine& line = *_layout[i].line;
+            const bool is_changed = i >= prefix && i < prefix + changed.size();
+
+            for(const LineSymbol& reference : line.references)
+            {
+                const size_t ref = _layout[i].address + reference.offset;
+                uint16_t value = 0;
+
+                auto label = _symbol_table.find(reference.name);
+                if(label == _symbol_table.end())
+                {
+                    // Zero is what a bad operand gets from assemble()
+                    _diagnostics.error(DIAG_UNKNOWN_LABEL, (int)i + 1, reference.column,
+                            "Unknown label or invalid operand \'" + reference.name + "\'");
+                }
+                else
+                {
+                    label->second.references.push_back((int)ref);
+                    value = label->second.value;
+                }
+
+                if(!is_changed && _program_instructions[ref] == (value & 0x00ff) && _program_instructions[ref+1] == (value & 0xff00) >> 8)
+                {
+                    continue;
+                }
+
+                _program_instructions[ref] = (value & 0x00ff);
+                _program_instructions[ref+1] = (value & 0xff00) >> 8;
+
+                // The operand follows its opcode
+                _disassembly[ref - 1] = format_instruction(Isa::entry(_program_instructions[ref - 1]), &_program_instructions[ref - 1]);
+            }
+        }
+
+        // Expressions are evaluated again when their line is new, their $ moved or a label they name did
+        const bool retry = _line_fixups_failed || labels_removed;
+        std::vector<int32_t> values;
+        _line_fixups_failed = false;
+
+        for(size_t i = 0; i < _layout.size(); i ++)
+        {
+            const AssembledLine& line = *_layout[i].line;
+            const bool is_changed = i >= prefix && i < prefix + changed.size();
+            const bool moved = delta != 0 && i >= prefix + changed.size();
+
+            for(const LineFixup& fixup : line.fixups)
+            {
+                const std::vector<std::string>& symbols = fixup.expression.symbols();
+
+                if(!is_changed && !retry && !(moved && fixup.expression.uses_location())
+                        && std::none_of(symbols.begin(), symbols.end(), [&](const std::string& name) { return moved_labels.count(name) > 0; }))
+                {
+                    continue;
+                }
+
+                const size_t ref = _layout[i].address + fixup.offset;
+                const size_t location = _layout[i].address + fixup.location;
+                int32_t value = 0;
+                bool valid = true;
+
+                values.clear();
+                for(const std::string& name : symbols)
+                {
+                    auto label = _symbol_table.find(name);
+                    if(label == _symbol_table.end())
+                    {
+                        _diagnostics.error(DIAG_UNKNOWN_LABEL, (int)i + 1, fixup.column,
+                                "Unknown label \'" + name + "\' in \'" + fixup.text + "\'");
+                        valid = false;
+                        break;
+                    }
+                    values.push_back(label->second.value);
+                }
+
+                if(valid && !fixup.expression.evaluate(values.data(), (int32_t)location, value))
+                {
+                    _diagnostics.error(DIAG_INVALID_OPERAND, (int)i + 1, fixup.column, "Division by zero in \'" + fixup.text + "\'");
+                    valid = false;
+                }
+
+                if(!valid || !check_range(fixup.text, value, fixup.size, (int)i + 1, fixup.column))
+                {
+                    // Zero like the placeholder assemble() leaves
+                    _line_fixups_failed = true;
+                    value = 0;
+                }
+
+                _program_instructions[ref] = (value & 0x00ff);
+                if(fixup.size == 2)
+                {
+                    _program_instructions[ref + 1] = (value & 0xff00) >> 8;
+                }
+
+                _disassembly[location] = format_instruction(Isa::entry(_program_instructions[location]), &_program_instructions[location]);
+            }
+        }
+
+        // Lines deleted or edited away are dropped once they outnumber the live ones
+        if(_line_cache.size() > 2 * _layout.size() + 64)
+        {
+            for(auto it = _line_cache.begin(); it != _line_cache.end(); )
+            {
+                it = it->second->generation != _generation ? _line_cache.erase(it) : std::next(it);
+            }
+        }
+
+        _diagnostics.sort();
+
+        if(_diagnostics.has_errors())
+        {
+            return std::vector<uint8_t>();
+        }
+
+        return _program_instructions;
+    }
+
+    void Assembler::assemble_line(AssembledLine& line)
     {
-        Token* t = m_tokens;
-        Token* tmp_ptr;
+        Assembler assembler(line.text);
+        assembler._line_mode = true;
+        assembler.tokenize();
+        assembler.parse();
+
+        line.program = std::move(assembler._program_instructions);
+        line.labels = std::move(assembler._line_labels);
+        line.references = std::move(assembler._line_references);
+        line.fixups = std::move(assembler._line_fixups);
+        line.diagnostics = assembler._diagnostics.entries();
+
+        for(const auto& it : assembler._source_lines)
+        {
+            line.instructions.push_back(it.first);
+            line.disassembly.push_back(format_instruction(Isa::entry(line.program[it.first]), &line.program[it.first]));
+        }
+    }
 
-        while(t)
+    void Assembler::set_log(std::ostream& log)
+    {
+        _log = &log;
+    }
+
+    Diagnostics& Assembler::diagnostics()
+    {
+        return _diagnostics;
+    }
+
+    const Diagnostics& Assembler::diagnostics() const
+    {
+        return _diagnostics;
+    }
+
+    std::map<uint16_t, std::string> Assembler::get_labels() const
+    {
+        std::map<uint16_t, std::string> labels;
+
+        for(const auto& it : _symbol_table)
         {
-            tmp_ptr = t->next;
-            delete t;
-            t = tmp_ptr;
+            std::map<uint16_t, std::string>::iterator l = labels.find(it.second.value);
+
+            // Alphabetical first keeps the choice stable
+            if(l == labels.end() || it.first < l->second)
+            {
+                labels[it.second.value] = it.first;
+            }
         }
+
+        return labels;
     }
 
     void Assembler::print_tokens()
     {
-        Token* tptr = m_tokens;
-        while(tptr != nullptr)
+        std::ostream& out = _log ? *_log : std::cout;
+
+        for(const Token& t : _tokens)
         {
-            std::cout << "tt: " << tptr->tt << ", str: " << tptr->token_string << ", line: " << tptr->line_number << ":" << tptr->col_number << std::endl;
-            tptr = tptr->next;
+            out << "tt: " << t.tt << ", str: " << t.token_string << ", line: " << t.line_number << ":" << t.col_number << std::endl;
         }
     }
 
     void Assembler::tokenize()
     {
-        Token* t = new Token, *tnext;
-        m_tokens = t;
+        const std::string_view code(_code);
         char c;
         bool is_comment = false;
         bool is_string = false;
@@ -67,11 +558,41 @@ namespace lib8085
         int col_number = 0;
         int token_col_number = 0;
 
+        // Text of the token being read, always a contiguous run of the source
+        size_t start = 0;
+        size_t length = 0;
+        TokenType tt = TokenType::UNKNOWN;
+
+        _tokens.clear();
+        _tokens.reserve(code.size() / 4 + 1);
+        _diagnostics.clear();
         _symbol_table = std::unordered_map<std::string, lib8085::SymbolValue>();
+        _imports = std::unordered_map<std::string, lib8085::SymbolValue>();
+        _fixups.clear();
+        // What assemble_incremental() laid out is rebuilt by parse
+        _layout.clear();
 
-        for(size_t i = 0; i < _code.size(); i ++)
+        auto append = [&](size_t i)
         {
-            c = _code[i];
+            if(length == 0)
+            {
+                start = i;
+                token_col_number = col_number;
+            }
+            length++;
+        };
+
+        auto push = [&](TokenType type)
+        {
+            _tokens.push_back(Token{ line_number, token_col_number, code.substr(start, length), type });
+            length = 0;
+            tt = TokenType::UNKNOWN;
+            token_col_number = col_number;
+        };
+
+        for(size_t i = 0; i < code.size(); i ++)
+        {
+            c = code[i];
             col_number++;
 
             if(is_comment)
@@ -79,24 +600,14 @@ namespace lib8085
                 if(c == '\n')
                 {
                     is_comment = false;
-                    line_number ++;
-
-                    t->line_number = line_number;
-                    t->col_number = token_col_number;
-
-                    tnext = new Token;
-                    tnext->prev = t;
-                    tnext->next = nullptr;
+                    push(tt);
 
-                    t->next = tnext;
-                    t = tnext;
-
-                    t->token_string = "";
-                    token_col_number = col_number;
+                    line_number ++;
+                    col_number = 0;
                 }
                 else
                 {
-                    t->token_string += c;
+                    append(i);
                 }
 
                 continue;
@@ -105,109 +616,79 @@ namespace lib8085
             {
                 if(c == '\n')
                 {
-                    std::cout << "Error: Expected closing quote character \' at " << token_col_number << "\' at line ";
-                        return;
+                    // The string is dropped and tokenizing goes on with the next line
+                    _diagnostics.error(DIAG_UNTERMINATED_STRING, line_number, token_col_number, "Expected closing quote character \'");
+                    is_string = false;
+                    length = 0;
                 }
                 else
                 {
-                    t->token_string += c;
+                    append(i);
                 }
             }
             else if(c == ':')
             {
-                t->tt = TokenType::LABEL;
-                t->line_number = line_number;
-                t->col_number = token_col_number;
-
-                tnext = new Token;
-                tnext->prev = t;
-                tnext->next = nullptr;
-
-                t->next = tnext;
-                t = tnext;
-
-                _symbol_table.insert({ t->token_string, SymbolValue() });
+                // Known before parsing so forward references resolve
+                _symbol_table.insert({ std::string(code.substr(start, length)), SymbolValue() });
 
-                t->token_string = "";
-                token_col_number = col_number;
+                push(TokenType::LABEL);
             }
-            // else if(c == '+' || c == '-' || c == '*' || c == '%')
-            // {
-            //     t->tt = TokenType::ARITHMETIC_OP;
-            //     t->line_number = line_number;
-            //     t->col_number = token_col_number;
-            //     _tokens.push_back(t);
-
-            //     t->token_string = "";
-            //     token_col_number = col_number;
-            // }
             else if(c == ' ' || c == ',' || c == '\n' ||  c == '\t' || c == '\r' || c == ';')
             {
-                if(t->token_string.size() > 0)
+                if(length > 0)
                 {
-                    const std::string token_string = t->token_string;
+                    const std::string_view token_string = code.substr(start, length);
 
-                    if(is_opcode(token_string))
-                    {
-                        t->tt = TokenType::OPCODE;
-                    }
-                    else if(is_reg(token_string))
+                    // One hash and compare classifies every keyword
+                    switch(Keywords::find(token_string))
                     {
-                        t->tt = TokenType::REG;
-                        t->token_string[0] = std::toupper(token_string[0]);
+                        case KEYWORD_OPCODE:
+                            tt = TokenType::OPCODE;
+                            break;
+                        case KEYWORD_REG:
+                            tt = TokenType::REG;
+                            break;
+                        default:
+                            tt = TokenType::UNKNOWN;
+                            break;
                     }
-                    else if(is_directive(token_string))
-                    {
-                        t->tt = TokenType::NAME;
-                    }
-                    else if(is_hex_operand(token_string))
-                    {
-                        t->tt = TokenType::OPERAND_HEX;
-                    }
-                    else if(is_dec_operand(token_string))
-                    {
-                        t->tt = TokenType::OPERAND_DEC;
-                    }
-                    else if(is_oct_operand(token_string))
-                    {
-                        t->tt = TokenType::OPERAND_OCT;
-                    }
-                    else if(is_bin_operand(token_string))
-                    {
-                        t->tt = TokenType::OPERAND_BIN;
-                    }
-                    else if(is_location_counter_operand(token_string))
-                    {
-                        t->tt = TokenType::OPERAND_LOCATION_COUNTER;
-                    }
-                    else
+
+                    if(tt == TokenType::UNKNOWN)
                     {
-                        t->tt = TokenType::UNKNOWN;
+                        if(is_hex_operand(token_string))
+                        {
+                            tt = TokenType::OPERAND_HEX;
+                        }
+                        else if(is_dec_operand(token_string))
+                        {
+                            tt = TokenType::OPERAND_DEC;
+                        }
+                        else if(is_oct_operand(token_string))
+                        {
+                            tt = TokenType::OPERAND_OCT;
+                        }
+                        else if(is_bin_operand(token_string))
+                        {
+                            tt = TokenType::OPERAND_BIN;
+                        }
+                        else if(is_location_counter_operand(token_string))
+                        {
+                            tt = TokenType::OPERAND_LOCATION_COUNTER;
+                        }
                     }
 
-                    t->line_number = line_number;
-                    t->col_number = token_col_number;
-
-                    tnext = new Token;
-                    tnext->prev = t;
-                    tnext->next = nullptr;
-
-                    t->next = tnext;
-                    t = tnext;
-
-                    t->token_string = "";
-                    token_col_number = col_number;
+                    push(tt);
                 }
             }
             else
             {
-                t->token_string += c;
+                append(i);
             }
 
             if(c == ';')
             {
                 is_comment = true;
-                t->tt = TokenType::COMMENT;
+                tt = TokenType::COMMENT;
                 token_col_number = col_number;
             }
             else if(c == '\'')
@@ -215,7 +696,7 @@ namespace lib8085
                 if(is_string)
                 {
                     is_string = false;
-                    t->tt = TokenType::OPERAND_ASCII_STR;
+                    tt = TokenType::OPERAND_ASCII_STR;
                     token_col_number = col_number;
                 }
                 else
@@ -232,54 +713,43 @@ namespace lib8085
             }
         }
 
-        t->line_number = line_number;
-        t->col_number = 0;
-        t->token_string = "_EOF";
-        t->tt = TokenType::_EOF;
-
-        t->next = nullptr;
+        // Whatever was being read is dropped for the end marker
+        _tokens.push_back(Token{ line_number, 0, "_EOF", TokenType::_EOF });
     }
 
-    bool Assembler::is_reg(const std::string& str) const
+    bool Assembler::is_identifier(std::string_view str) const
     {
-        std::string tmp = str;
-        std::transform(tmp.begin(), tmp.end(), tmp.begin(), ::toupper);
-
-        if( tmp == "A" || tmp == "B"
-                || tmp == "C" || tmp == "D"
-                || tmp == "E" || tmp == "H"
-                || tmp == "L" || tmp == "M"
-                || tmp == "SP")
-                {
-            return true;
+        if(str.empty() || std::isdigit((unsigned char)str[0]))
+        {
+            return false;
         }
-        return false;
+
+        return std::all_of(str.begin(), str.end(), [](char c)
+        {
+            return std::isalnum((unsigned char)c) || c == '_' || c == '?' || c == '@';
+        });
     }
 
-    bool Assembler::is_directive(const std::string& str) const
+    bool Assembler::is_reg(std::string_view str) const
     {
-        if(std::binary_search(_directive_strs.begin(), _directive_strs.end(), str))
-        {
-            return true;
-        }
-        return false;
+        return Keywords::find(str) == KEYWORD_REG;
     }
 
-    bool Assembler::is_opcode(const std::string& str) const
+    bool Assembler::is_opcode(std::string_view str) const
     {
-        if(std::binary_search(_opcode_strs.begin(), _opcode_strs.end(), str))
-        {
-            return true;
-        }
-        return false;
+        return Keywords::find(str) == KEYWORD_OPCODE;
     }
 
-    // TODO: If valid evaluate return value of actual string
-    // This will remove the need to run a simliar thing in parse_data_byte
-    bool Assembler::is_hex_operand(const std::string& str) const
+    // Token classes are only printed, operand values come from Expression
+    bool Assembler::is_hex_operand(std::string_view str) const
     {
         char c;
-        if(std::tolower(str.back()) != 'h')
+        if(str.empty())
+        {
+            return false;
+        }
+
+        if(std::tolower((unsigned char)str.back()) != 'h')
         {
             return false;
         }
@@ -288,7 +758,7 @@ namespace lib8085
 
         for(size_t i = 0; i < len-1; i ++)
         {
-            c = std::tolower(str[i]);
+            c = std::tolower((unsigned char)str[i]);
 
             if((c > '9' && c < 'a') || (c < '0' || c > 'f'))
             {
@@ -299,13 +769,16 @@ namespace lib8085
         return true;
     }
 
-    // TODO: If valid evaluate return value of actual string
-    // This will remove the need to run a simliar thing in parse_data_byte
-    bool Assembler::is_dec_operand(const std::string& str) const
+    bool Assembler::is_dec_operand(std::string_view str) const
     {
         size_t len;
 
-        if(std::tolower(str.back()) == 'd')
+        if(str.empty())
+        {
+            return false;
+        }
+
+        if(std::tolower((unsigned char)str.back()) == 'd')
         {
             len = str.size() - 1;
         }
@@ -314,10 +787,15 @@ namespace lib8085
             len = str.size();
         }
 
+        if(len == 0)
+        {
+            return false;
+        }
+
         char c;
         for(size_t i = 0; i < len; i ++)
         {
-            c = std::tolower(str[i]);
+            c = std::tolower((unsigned char)str[i]);
 
             if(c > '9' || c < '0')
             {
@@ -328,13 +806,16 @@ namespace lib8085
         return true;
     }
 
-    // TODO: If valid evaluate return value of actual string
-    // This will remove the need to run a simliar thing in parse_data_byte
-    bool Assembler::is_oct_operand(const std::string& str) const
+    bool Assembler::is_oct_operand(std::string_view str) const
     {
         char c;
-        
-        c = std::tolower(str.back());
+
+        if(str.empty())
+        {
+            return false;
+        }
+
+        c = std::tolower((unsigned char)str.back());
         if(c != 'o' && c != 'q')
         {
             return false;
@@ -344,7 +825,7 @@ namespace lib8085
 
         for(size_t i = 0; i < len-1; i ++)
         {
-            c = std::tolower(str[i]);
+            c = std::tolower((unsigned char)str[i]);
 
             if(c > '8' || c < '0')
             {
@@ -355,13 +836,16 @@ namespace lib8085
         return true;
     }
 
-    // TODO: If valid evaluate return value of actual string
-    // This will remove the need to run a simliar thing in parse_data_byte
-    bool Assembler::is_bin_operand(const std::string& str) const
+    bool Assembler::is_bin_operand(std::string_view str) const
     {
         char c;
-        
-        c = std::tolower(str.back());
+
+        if(str.empty())
+        {
+            return false;
+        }
+
+        c = std::tolower((unsigned char)str.back());
         if(c != 'b')
         {
             return false;
@@ -371,7 +855,7 @@ namespace lib8085
 
         for(size_t i = 0; i < len-1; i ++)
         {
-            c = std::tolower(str[i]);
+            c = std::tolower((unsigned char)str[i]);
 
             if(c != '0' && c != '1')
             {
@@ -382,183 +866,241 @@ namespace lib8085
         return true;
     }
 
-    // TODO: If valid evaluate return value of actual string
-    // This will remove the need to run a simliar thing in parse_data_byte
-    bool Assembler::is_location_counter_operand(const std::string& str) const
+    bool Assembler::is_location_counter_operand(std::string_view str) const
     {
         char c;
-        
-        c = std::tolower(str.front());
+
+        if(str.empty())
+        {
+            return false;
+        }
+
+        c = std::tolower((unsigned char)str.front());
         if(c != '$')
         {
             return false;
         }
 
-        // TODO: Validate str
         // Format: $+66
-
-        return true;
+        Expression expression;
+        std::string error;
+        return expression.compile(str, error) == str.size();
     }
 
-    bool Assembler::parse_data_byte(const Token& t, uint8_t& operand_byte)
+    bool Assembler::parse_operand(const Token& t, std::string_view text, size_t location, uint8_t size, uint16_t& value, size_t& used)
     {
-        char c;
-        const std::string& ts = t.token_string;
+        std::string error;
+        used = _expression.compile(text, error);
 
-        c = ts.back();
-        // try parse hex data
-        // Ends with 'H'
-        if(c == 'H' || c == 'h')
+        if(used == 0)
         {
-            if(ts.size() > 3)
+            // A single word that isn't an expression may still name a label, like before expressions
+            if(size == 2 && text.size() == t.token_string.size())
             {
-                std::cout << "Operand size\n";
-                return false;
+                used = text.size();
+                return parse_label(t, text, value);
             }
 
-            for(size_t i = 0; i < ts.size()-1; i ++)
-            {
-                c = std::tolower(ts[i]);
+            _diagnostics.error(DIAG_INVALID_OPERAND, t.line_number, t.col_number,
+                    "Invalid operand \'" + std::string(text) + "\': " + error);
+            return false;
+        }
 
-                if(c >= '0' && c <= '9')
-                {
-                    c -= '0';
-                }
-                else if(c >= 'a' && c <= 'f')
-                {
-                    c = (c - 'a') + 10;
-                }
-                else
-                {
-                    std::cout << "Invalid character " << c;
-                    return false;
-                }
+        std::string_view operand = text.substr(0, used);
+        while(operand.back() == ' ' || operand.back() == '\t' || operand.back() == '\r')
+        {
+            operand.remove_suffix(1);
+        }
+
+        // What follows has to start a new word, the caller reports it as unexpected
+        if(used < text.size() && operand.size() == used && text[used] != ',')
+        {
+            _diagnostics.error(DIAG_INVALID_OPERAND, t.line_number, t.col_number,
+                    "Unexpected \'" + std::string(1, text[used]) + "\' in operand \'" + std::string(text) + "\'");
+            return false;
+        }
 
-                operand_byte <<= 4;
-                operand_byte |= c;
+        const std::vector<std::string>& symbols = _expression.symbols();
 
+        // $ is only known here when the program is laid out as it is parsed
+        if(symbols.empty() && (!_expression.uses_location() || (!_line_mode && !_allow_imports)))
+        {
+            int32_t result;
+            if(!_expression.evaluate(nullptr, (int32_t)location, result))
+            {
+                _diagnostics.error(DIAG_INVALID_OPERAND, t.line_number, t.col_number,
+                        "Division by zero in \'" + std::string(operand) + "\'");
+                return false;
+            }
+            if(!check_range(operand, result, size, t.line_number, t.col_number))
+            {
+                return false;
             }
+
+            value = (uint16_t)result;
+            return true;
         }
-        else
+
+        if(size == 2 && _expression.is_symbol())
         {
-            return false;
+            return parse_label(t, symbols[0], value);
+        }
+
+        // The rest waits for every label to be placed
+        value = 0;
+
+        if(_line_mode)
+        {
+            _line_fixups.push_back(LineFixup{ _expression, std::string(operand), (uint16_t)_program_instructions.size(),
+                    (uint16_t)location, size, t.col_number });
+            return true;
+        }
+
+        Fixup fixup{ _expression, std::string(operand), {}, (uint16_t)_program_instructions.size(), (uint16_t)location,
+            size, t.line_number, t.col_number };
+
+        for(const std::string& name : symbols)
+        {
+            auto label = _symbol_table.find(name);
+
+            if(label != _symbol_table.end())
+            {
+                fixup.symbols.push_back(&label->second);
+            }
+            else if(_allow_imports && is_identifier(name))
+            {
+                fixup.symbols.push_back(&_imports[name]);
+            }
+            else
+            {
+                _diagnostics.error(DIAG_UNKNOWN_LABEL, t.line_number, t.col_number,
+                        "Unknown label \'" + name + "\' in \'" + std::string(operand) + "\'");
+                return false;
+            }
         }
 
+        _fixups.push_back(std::move(fixup));
         return true;
     }
 
-    bool Assembler::parse_data_word(const Token& t, uint16_t& operand_word)
+    bool Assembler::parse_label(const Token& t, std::string_view name, uint16_t& operand_word)
     {
-        char c;
-        const std::string& ts = t.token_string;
+        if(_line_mode)
+        {
+            // Whether it names a label is only known once every line is laid out
+            _line_references.push_back(LineSymbol{ std::string(name), (uint16_t)_program_instructions.size(), t.col_number });
 
-        // try parse hex data
-        // Ends with 'H'
-        if(ts.back() == 'H' || ts.back() == 'h')
+            operand_word = 0xffff;
+            return true;
+        }
+        else if(_symbol_table.find(std::string(name)) != _symbol_table.end())
         {
-            if(ts.size() > 5)
+            SymbolValue& sv = (_symbol_table[std::string(name)]);
+            if(_log)
             {
-                std::cout << "Operand size too big\n";
-                return false;
+                *_log << "Reference " << _program_instructions.size() + 1 << "\n";
             }
+            sv.references.push_back(_program_instructions.size());
 
-            for(size_t i = 0; i < ts.size()-1; i ++)
-            {
-                c = std::tolower(ts[i]);
+            operand_word = 0xffff;
+            return true;
+        }
+        else if(_allow_imports && is_identifier(name))
+        {
+            // Another module defines it, the linker fills it in
+            _imports[std::string(name)].references.push_back(_program_instructions.size());
 
-                if(c >= '0' && c <= '9')
-                {
-                    c -= '0';
-                }
-                else if(c >= 'a' && c <= 'f')
-                {
-                    c = (c - 'a') + 10;
-                }
-                else
-                {
-                    std::cout << "Invalid character " << c;
-                    return false;
-                }
+            operand_word = 0;
+            return true;
+        }
 
-                operand_word <<= 4;
-                operand_word |= c;
+        _diagnostics.error(DIAG_UNKNOWN_LABEL, t.line_number, t.col_number,
+                "Unknown label or invalid operand \'" + std::string(name) + "\'");
+        return false;
+    }
 
-            }
+    bool Assembler::check_range(std::string_view text, int32_t value, uint8_t size, int line, int column)
+    {
+        if(size == 1 ? value >= -0x80 && value <= 0xff : value >= -0x8000 && value <= 0xffff)
+        {
+            return true;
         }
-        else
+
+        _diagnostics.error(DIAG_OPERAND_RANGE, line, column,
+                "Operand \'" + std::string(text) + "\' does not fit in a " + (size == 1 ? "byte" : "word"));
+        return false;
+    }
+
+    void Assembler::evaluate_fixups()
+    {
+        std::vector<int32_t> values;
+
+        for(const Fixup& fixup : _fixups)
         {
-            // Check if it's a label or expression
-            if(is_location_counter_operand(ts))
+            values.clear();
+            for(const SymbolValue* symbol : fixup.symbols)
             {
-                // TODO: Evaluate expression
+                values.push_back(symbol->value);
             }
-            else if(_symbol_table.find(ts) != _symbol_table.end())
+
+            int32_t result;
+            int term;
+            int32_t constant;
+
+            if(!fixup.expression.evaluate(values.data(), fixup.location, result))
             {
-                SymbolValue& sv = (_symbol_table[t.token_string]);
-                std::cout << "Reference " << _program_instructions.size() + 1 << "\n";
-                sv.references.push_back(_program_instructions.size());
+                _diagnostics.error(DIAG_INVALID_OPERAND, fixup.line, fixup.column, "Division by zero in \'" + fixup.text + "\'");
+                continue;
+            }
 
-                operand_word = 0xffff;
-                return true;
+            if(!check_range(fixup.text, result, fixup.size, fixup.line, fixup.column))
+            {
+                continue;
             }
 
-            std::cout << "Invalid operand suffix\n";
-            return false;
+            // The linker adds the address of one label or of the section to a word
+            if(_allow_imports && (fixup.size != 2 || !fixup.expression.linear(term, constant)))
+            {
+                _diagnostics.error(DIAG_UNSUPPORTED, fixup.line, fixup.column, "Operand \'" + fixup.text
+                        + "\' can\'t be relocated, objects only add a constant to one label or $ in a word");
+                continue;
+            }
+
+            _program_instructions[fixup.offset] = (result & 0x00ff);
+            if(fixup.size == 2)
+            {
+                _program_instructions[fixup.offset + 1] = (result & 0xff00) >> 8;
+            }
         }
-        return true;
     }
 
     bool Assembler::disassemble()
     {
-        std::unordered_map<lib8085::InstructionSet, OpcodeData>
-            isa_opdata_map = AssemblerUtil::get_instraction_data_map();
-
         _disassembly = std::map<uint64_t, std::string>();
 
-        OpcodeData opcode_data;
-        uint8_t opcode;
-        uint8_t operand_byte;
-        uint16_t operand_word;
-        std::stringstream ss;
-
         size_t len = _program_instructions.size();
         size_t instruction_address;
         for(size_t i = 0; i < len; i++)
         {
             instruction_address = i;
-            std::stringstream ss;
-            opcode = _program_instructions[i];
-            std::unordered_map<lib8085::InstructionSet, OpcodeData>::const_iterator it
-                = isa_opdata_map.find(static_cast<InstructionSet>(opcode));
+            const IsaEntry& entry = Isa::entry(_program_instructions[i]);
 
-            if(it == isa_opdata_map.end())
+            if(!Isa::defined(_program_instructions[i]))
             {
-                std::cerr << "Failed to disasseble opcode \"" << opcode << "\" at location " << i << "\n";
+                _diagnostics.error(DIAG_INVALID_OPCODE, 0, 0, "Failed to disassemble opcode "
+                        + std::to_string(_program_instructions[i]) + " at location " + std::to_string(i));
                 return false;
             }
 
-            opcode_data = it->second;
-
-            ss << opcode_data.str << " ";
-
-            if(opcode_data.operand_count == 1)
+            if(i + entry.length > len)
             {
-                if(opcode_data.operand_size == 1)
-                {
-                    // TODO: Check for out of bounds ex
-                    i++;
-                    ss << "0x" << std::hex << (int)_program_instructions[i];
-                }
-                else if(opcode_data.operand_size == 2)
-                {
-                    operand_word = 0;
-                    operand_word |= _program_instructions[i+2] << 8;
-                    operand_word |= _program_instructions[i+1];
-                    ss << "0x"<< std::hex << (int)operand_word;
-                    i+=2;
-                }
+                _diagnostics.error(DIAG_TRUNCATED, 0, 0, "Missing operand for \'" + std::string(entry.mnemonic)
+                        + "\' at location " + std::to_string(i));
+                return false;
             }
-            _disassembly.insert({ instruction_address, ss.str() });
+
+            _disassembly.insert({ instruction_address, format_instruction(entry, &_program_instructions[i]) });
+            i += entry.length - 1;
         }
 
         return true;
@@ -566,43 +1108,75 @@ namespace lib8085
 
     bool Assembler::parse()
     {
-        std::unordered_map<std::string, lib8085::OpcodeData> instruction_db = 
-            AssemblerUtil::get_instraction_str_data_map();
-
-        if(!m_tokens)
+        if(_tokens.empty())
         {
-            std::cout << "m_tokens is null\n";
+            _diagnostics.error(DIAG_EMPTY, 0, 0, "Nothing to assemble, tokenize first");
             return false;
         }
 
-        Token* t = m_tokens;
+        const Token* end = _tokens.data() + _tokens.size();
+        auto next = [end](const Token* token) -> const Token*
+        {
+            return token + 1 < end ? token + 1 : nullptr;
+        };
+
+        // Operands and registers belong to the line of their instruction
+        auto next_on_line = [&next](const Token* token) -> const Token*
+        {
+            const Token* n = next(token);
+            return n && n->line_number == token->line_number && n->tt != TokenType::COMMENT && n->tt != TokenType::_EOF ? n : nullptr;
+        };
+
+        // Recovering from an error drops the rest of its line
+        auto skip_line = [&next](const Token* token) -> const Token*
+        {
+            while(next(token) && next(token)->line_number == token->line_number)
+            {
+                token = next(token);
+            }
+            return token;
+        };
+
+        const Token* t = _tokens.data();
         std::string tstring;
         std::string opcode_str;
-        Token* src_token;
-        uint8_t operand_byte;
+        std::unordered_set<std::string_view> defined_labels;
+        const Token* src_token;
         uint16_t operand_word;
 
-        while(t)
+        while(t && !_diagnostics.full())
         {
             if(t->tt == TokenType::OPCODE)
             {
-                std::cout << "line: " << t->line_number << ", str: " << t->token_string << "\n";
-                tstring = t->token_string;
+                if(_log)
+                {
+                    *_log << "line: " << t->line_number << ", str: " << t->token_string << "\n";
+                }
+                // Mnemonics match in any case, the instruction tables use upper
+                tstring = to_upper(t->token_string);
+                const Token* mnemonic = t;
 
-                Token* next_token_obj = t->next;
+                const Token* next_token_obj = next_on_line(t);
+                const std::string_view next_string = next_token_obj ? next_token_obj->token_string : std::string_view();
 
-                if(next_token_obj && is_reg(next_token_obj->token_string))
+                if(tstring == "RST" && next_string.size() == 1 && next_string[0] >= '0' && next_string[0] <= '7')
+                {
+                    // RST n names the RST_n table entry
+                    t = next_token_obj;
+                    opcode_str = tstring + "_" + std::string(next_string);
+                }
+                else if(next_token_obj && is_reg(next_string))
                 {
                     t = next_token_obj;
 
-                    opcode_str = tstring + "_" + next_token_obj->token_string;
+                    opcode_str = tstring + "_" + to_upper(next_token_obj->token_string);
 
-                    next_token_obj = next_token_obj->next;
+                    next_token_obj = next_on_line(next_token_obj);
 
                     if(next_token_obj && is_reg(next_token_obj->token_string))
                     {
                         t = next_token_obj;
-                        opcode_str += "_" + next_token_obj->token_string;
+                        opcode_str += "_" + to_upper(next_token_obj->token_string);
                     }
                 }
                 else
@@ -610,88 +1184,149 @@ namespace lib8085
                     opcode_str = tstring;
                 }
 
-                std::unordered_map<std::string, OpcodeData>::const_iterator it
-                    = instruction_db.find(opcode_str);
+                const IsaEntry* entry = Isa::find(opcode_str);
 
-                if(it == instruction_db.end())
+                if(!entry)
                 {
-                    std::cout << "Invalid instruction combination\'" << opcode_str << "\' at line "
-                        << t->line_number << ":" << t->col_number << "\n";
-                    return false;
+                    _diagnostics.error(DIAG_UNKNOWN_INSTRUCTION, mnemonic->line_number, mnemonic->col_number,
+                            "Invalid instruction combination \'" + opcode_str + "\'");
+                    t = next(skip_line(t));
+                    continue;
                 }
 
-                std::cout << "\'" << opcode_str << "\' " << "Opcode found\n";
+                if(_log)
+                {
+                    *_log << "\'" << opcode_str << "\' " << "Opcode found\n";
+                }
 
-                _program_instructions.push_back(it->second.opcode);
+                const size_t location = _program_instructions.size();
+                _source_lines[(uint16_t)location] = mnemonic->line_number;
+                _program_instructions.push_back(entry->opcode);
 
-                if(it->second.operand_count == 1)
+                if(entry->operand != OPERAND_NONE)
                 {
-                    src_token = t->next;
+                    src_token = next_on_line(t);
+                    bool valid = false;
+                    operand_word = 0;
 
                     if(!src_token)
                     {
-                        std::cout << "Expected operand at line "
-                            << t->line_number << ":" << t->col_number << "\n";
-                        return false;
+                        _diagnostics.error(DIAG_MISSING_OPERAND, t->line_number, t->col_number,
+                                "Expected an operand for \'" + opcode_str + "\'");
                     }
-
-                    if(it->second.operand_size == 1)
+                    else
                     {
-                        if(parse_data_byte(*src_token, operand_byte))
+                        // Expressions may be spaced out over several words, the operand runs to the end of the line
+                        const Token* last = src_token;
+                        while(next_on_line(last))
                         {
-                            std::cout << "Operand value: " << (int)operand_byte << std::endl;;
+                            last = next_on_line(last);
                         }
-                        else
+
+                        const char* begin = src_token->token_string.data();
+                        const std::string_view text(begin, last->token_string.data() + last->token_string.size() - begin);
+                        size_t used = 0;
+
+                        valid = parse_operand(*src_token, text, location, entry->operand == OPERAND_BYTE ? 1 : 2, operand_word, used);
+
+                        // Words the operand didn't take are left over for the check below
+                        t = src_token;
+                        while(next_on_line(t) && next_on_line(t)->token_string.data() < begin + used)
                         {
-                            std::cout << "Invalid operand \'" << src_token->token_string << "\' at line "
-                                << src_token->line_number << ":" << src_token->col_number << "\n";
-                            return false;
+                            t = next_on_line(t);
                         }
+                    }
 
-                        _program_instructions.push_back(operand_byte);
+                    if(valid && _log)
+                    {
+                        *_log << "Operand value: " << (entry->operand == OPERAND_BYTE ? (operand_word & 0x00ff) : (int)operand_word) << std::endl;
+                    }
 
+                    // Placeholders keep the addresses of what follows right when the operand was bad
+                    if(entry->operand == OPERAND_BYTE)
+                    {
+                        _program_instructions.push_back((operand_word & 0x00ff));
                     }
-                    else if(it->second.operand_size == 2)
+                    else
                     {
-                        if(parse_data_word(*src_token, operand_word))
-                        {
-                            std::cout << "Operand value: " << (int)operand_word << std::endl;;
-                        }
-                        else
-                        {
-                            std::cout << "Invalid operand \'" << src_token->token_string << "\' at line "
-                                << src_token->line_number << ":" << src_token->col_number << "\n";
-                            return false;
-                        }
-
                         _program_instructions.push_back((operand_word & 0x00ff));
                         _program_instructions.push_back((operand_word & 0xff00) >> 8);
                     }
+
+                    if(!valid)
+                    {
+                        t = next(skip_line(t));
+                        continue;
+                    }
+                }
+
+                // Anything left on the line wasn't consumed by the instruction
+                if(next_on_line(t))
+                {
+                    src_token = next_on_line(t);
+                    _diagnostics.error(DIAG_UNEXPECTED_TOKEN, src_token->line_number, src_token->col_number,
+                            "Unexpected \'" + std::string(src_token->token_string) + "\' after \'" + opcode_str + "\'");
+                    t = skip_line(t);
                 }
             }
             else if(t->tt == TokenType::LABEL)
             {
-                // std::cout << "Label: \"" << t->token_string << "\" = " << _program_instructions.size() << std::endl;
-                SymbolValue& sv = (_symbol_table[t->token_string]);
+                if(_line_mode)
+                {
+                    _line_labels.push_back(LineSymbol{ std::string(t->token_string), (uint16_t)_program_instructions.size(), t->col_number });
+                }
+                else if(!defined_labels.insert(t->token_string).second)
+                {
+                    _diagnostics.warning(DIAG_LABEL_REDEFINED, t->line_number, t->col_number,
+                            "Label \'" + std::string(t->token_string) + "\' is defined again, references use this address");
+                }
+
+                SymbolValue& sv = (_symbol_table[std::string(t->token_string)]);
                 sv.value = (uint16_t)_program_instructions.size();
             }
+            else if(t->tt != TokenType::COMMENT && t->tt != TokenType::_EOF)
+            {
+                // Statements start with a label or an instruction
+                _diagnostics.error(t->tt == TokenType::UNKNOWN ? DIAG_UNKNOWN_INSTRUCTION : DIAG_UNEXPECTED_TOKEN,
+                        t->line_number, t->col_number,
+                        (t->tt == TokenType::UNKNOWN ? "Unknown instruction \'" : "Unexpected \'") + std::string(t->token_string) + "\'");
+                t = skip_line(t);
+            }
 
-            t = t->next; 
+            t = next(t);
         }
 
-        std::cout << "Updating label references\n";
+        if(_log)
+        {
+            *_log << "Updating label references\n";
+        }
         // Update label references
         for(auto& it: _symbol_table)
         {
             SymbolValue& sv = it.second;
             for(auto& ref : it.second.references)
             {
+                if(ref < 0 || (size_t)ref + 1 >= _program_instructions.size())
+                {
+                    _diagnostics.error(DIAG_REFERENCE_RANGE, 0, 0, "Reference to \'" + it.first + "\' outside of the program");
+                    continue;
+                }
+
                 // NOTE: Big endian
                 // 0x0002 will appear 0x2000
                 _program_instructions[ref] = (sv.value & 0x00ff);
                 _program_instructions[ref+1] = (sv.value & 0xff00) >> 8;
             }
         }
-        return true;
+
+        // Expressions go last, now every label they name has its final address
+        if(!_line_mode)
+        {
+            evaluate_fixups();
+        }
+
+        // Tokenizer errors were reported first, source order reads better
+        _diagnostics.sort();
+        return !_diagnostics.has_errors();
     }
 }
@@ -1,8 +1,15 @@
 #pragma once
+#include "diagnostics.h"
+#include "object.h"
+#include "expression.h"
+
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_map>
 #include <map>
+#include <memory>
+#include <ostream>
 
 namespace lib8085
 {
@@ -27,14 +34,12 @@ namespace lib8085
 
     struct Token
     {
-        int line_number;
-        int col_number;
-        
-        std::string token_string;
-        TokenType tt;
-
-        Token* next;
-        Token* prev;
+        int line_number = 0;
+        int col_number = 0;
+
+        // Points into the source the assembler was given
+        std::string_view token_string;
+        TokenType tt = TokenType::UNKNOWN;
     };
 
     struct SymbolValue
@@ -43,39 +48,153 @@ namespace lib8085
         std::vector<int> references;
     };
 
+    // A label or a label operand found while assembling a single line
+    struct LineSymbol
+    {
+        std::string name;
+        // From the start of the line's own code
+        uint16_t offset = 0;
+        int column = 0;
+    };
+
+    // An operand computed from labels or $ on a single line, evaluated once the line is placed
+    struct LineFixup
+    {
+        Expression expression;
+        // The operand as written, for diagnostics
+        std::string text;
+        // Of the operand and of the instruction it belongs to, from the start of the line's own code
+        uint16_t offset = 0;
+        uint16_t location = 0;
+        // 1 or 2 bytes
+        uint8_t size = 0;
+        int column = 0;
+    };
+
+    // What one source line assembles to on its own, label operands left unresolved
+    struct AssembledLine
+    {
+        // The line including its newline, the cache key points into it
+        std::string text;
+        std::vector<uint8_t> program;
+        // Offset and disassembly of every instruction of the line
+        std::vector<uint16_t> instructions;
+        std::vector<std::string> disassembly;
+        std::vector<LineSymbol> labels;
+        std::vector<LineSymbol> references;
+        std::vector<LineFixup> fixups;
+        // Positioned on line 1
+        std::vector<Diagnostic> diagnostics;
+        // Last reassembly the line was part of
+        uint64_t generation = 0;
+    };
+
+    // Where a cached line went in the program of the last incremental build
+    struct LineLayout
+    {
+        AssembledLine* line;
+        size_t address;
+    };
+
     class Assembler
     {
         public:
+            // Bumped whenever the same source assembles to other bytes or diagnostics,
+            // cached outputs are keyed by it
+            static const uint32_t VERSION = 3;
+
             Assembler();
             Assembler(std::string& code);
-            ~Assembler();
 
             std::vector<uint8_t> assemble();
+            // Same results as assemble() but only lines not seen by an earlier call are
+            // tokenized and parsed, the rest comes from a cache keyed by line text. The
+            // program is patched where the source changed and labels are fixed up again.
+            // On errors the disassembly of what did assemble is kept.
+            std::vector<uint8_t> assemble_incremental();
+            // Assembles a module for the Linker, labels it doesn't define become imports
+            // and every label operand a relocation. False with diagnostics on errors
+            bool assemble_object(ObjectModule& module);
             void tokenize();
             bool parse();
             void print_tokens();
             bool disassemble();
 
+            // Progress of every step is traced here for debugging, nothing by default
+            void set_log(std::ostream& log);
+
+            // Errors and warnings of the last tokenize, parse and disassemble
+            Diagnostics& diagnostics();
+            const Diagnostics& diagnostics() const;
+
+            // Label names by address, one per address when several share it
+            std::map<uint16_t, std::string> get_labels() const;
+
             std::map<uint64_t, std::string> _disassembly;
             std::vector<uint8_t> _program_instructions;
+            // Source line of the instruction starting at each address
+            std::map<uint16_t, int> _source_lines;
         private:
             std::string& _code;
-            std::vector<std::string> _opcode_strs;
-            std::vector<std::string> _directive_strs;
 
-            Token* m_tokens;
+            // One contiguous array, rebuilt by every tokenize()
+            std::vector<Token> _tokens;
+            std::ostream* _log;
+            Diagnostics _diagnostics;
 
             std::unordered_map<std::string, SymbolValue> _symbol_table;
+            // Labels used but not defined when imports are allowed, only references are kept
+            std::unordered_map<std::string, SymbolValue> _imports;
+            bool _allow_imports;
+
+            // Results of assemble_incremental() by line text
+            std::unordered_map<std::string_view, std::unique_ptr<AssembledLine>> _line_cache;
+            // Source lines of the last incremental build in order, empty after tokenize()
+            std::vector<LineLayout> _layout;
+            uint64_t _generation;
+            // Set while assembling a single line, label operands are collected
+            // instead of being looked up and nothing is checked across lines
+            bool _line_mode;
+            std::vector<LineSymbol> _line_labels;
+            std::vector<LineSymbol> _line_references;
+            std::vector<LineFixup> _line_fixups;
+            // An expression failed to evaluate in the last incremental build, all are evaluated again
+            bool _line_fixups_failed;
+
+            // Operand computed from labels, evaluated once parse has placed all of them
+            struct Fixup
+            {
+                Expression expression;
+                std::string text;
+                // In _symbol_table or _imports, one for each symbol of the expression
+                std::vector<const SymbolValue*> symbols;
+                uint16_t offset;
+                // Address of the instruction, what $ stands for
+                uint16_t location;
+                uint8_t size;
+                int line;
+                int column;
+            };
+
+            std::vector<Fixup> _fixups;
+            // Every operand is compiled here, only the ones that need labels are copied
+            Expression _expression;
+
+            void assemble_line(AssembledLine& line);
+            void evaluate_fixups();
 
-            bool is_reg(const std::string& str) const;
-            bool is_opcode(const std::string& str) const;
-            bool is_directive(const std::string& str) const;
-            bool is_hex_operand(const std::string& str) const;
-            bool is_dec_operand(const std::string& str) const;
-            bool is_oct_operand(const std::string& str) const;
-            bool is_bin_operand(const std::string& str) const;
-            bool is_location_counter_operand(const std::string& str) const;
-            bool parse_data_byte(const Token& t, uint8_t& operand_byte);
-            bool parse_data_word(const Token& t, uint16_t& operand_word);
+            bool is_identifier(std::string_view str) const;
+            bool is_reg(std::string_view str) const;
+            bool is_opcode(std::string_view str) const;
+            bool is_hex_operand(std::string_view str) const;
+            bool is_dec_operand(std::string_view str) const;
+            bool is_oct_operand(std::string_view str) const;
+            bool is_bin_operand(std::string_view str) const;
+            bool is_location_counter_operand(std::string_view str) const;
+            // text runs from t to the end of its line, used is set to what the operand took of it
+            bool parse_operand(const Token& t, std::string_view text, size_t location, uint8_t size, uint16_t& value, size_t& used);
+            bool parse_label(const Token& t, std::string_view name, uint16_t& operand_word);
+            // False with a diagnostic when value doesn't fit size bytes, signed or not
+            bool check_range(std::string_view text, int32_t value, uint8_t size, int line, int column);
     };
 }
@@ -1,37 +1,18 @@
 #pragma once
-#include "instruction_set.h"
-
+#include <cstdint>
 #include <string>
-#include <unordered_map>
 
 namespace lib8085
 {
-
-    struct OpcodeData
-    {
-        std::string str;
-        InstructionSet opcode;
-        int operand_count;
-
-        int operand_size;
-    };
-
     class AssemblerUtil
     {
         public:
             /*
-             * Returns a map that maps the opcode(enum) with what it expects as input
-             * This map is to be used for disassembley
-             *
-             */
-            static std::unordered_map<InstructionSet, OpcodeData> get_instraction_data_map();
-
-            /*
-             * Returns a map that maps the opcode(string) with what it expects as input
-             * This map is to be used for assembley
+             * Parses a number written the way the assembler accepts it:
+             * 80H, 0x80, 1010B, 17O/17Q, 128D or plain decimal
              *
              */
-            static std::unordered_map<std::string, OpcodeData> get_instraction_str_data_map();
+            static bool parse_number(const std::string& str, uint32_t& value);
     };
 }
 
@@ -0,0 +1,354 @@
+#include "../assembler.h"
+#include "../lib8085.h"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+using namespace lib8085;
+
+// Guards against workloads that never halt
+static const uint64_t MAX_INSTRUCTIONS = 1ull << 32;
+
+static const uint16_t MICRO_ITERATIONS = 0xc000;
+static const int MICRO_BODY_REPEAT = 8;
+
+struct Workload
+{
+    std::string name;
+    std::vector<uint8_t> program;
+};
+
+struct Result
+{
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+    double median_ns = 0;
+    double min_ns = 0;
+    double stddev_ns = 0;
+};
+
+/*
+ * Emits machine code for the generated microbenchmarks.
+ * Every benchmark is a counted loop around a body of one instruction class,
+ * the 4 loop instructions are included in the measurement.
+ *
+ */
+class Emitter
+{
+    public:
+        std::vector<uint8_t> code;
+
+        void op(InstructionSet opcode)
+        {
+            code.push_back((uint8_t)opcode);
+        }
+
+        void op(InstructionSet opcode, uint8_t operand)
+        {
+            code.push_back((uint8_t)opcode);
+            code.push_back(operand);
+        }
+
+        void op16(InstructionSet opcode, uint16_t operand)
+        {
+            code.push_back((uint8_t)opcode);
+            code.push_back(operand & 0xff);
+            code.push_back(operand >> 8);
+        }
+
+        uint16_t here() const
+        {
+            return (uint16_t)code.size();
+        }
+};
+
+typedef void (*BodyFn)(Emitter& e, uint16_t subroutine);
+
+struct MicroBenchmark
+{
+    const char* name;
+    BodyFn body;
+};
+
+static const MicroBenchmark micro_benchmarks[] =
+{
+    { "micro/mov_rr", [](Emitter& e, uint16_t) {
+        e.op(MOV_D_E); e.op(MOV_E_H); e.op(MOV_H_L); e.op(MOV_L_D);
+    } },
+    { "micro/alu_reg", [](Emitter& e, uint16_t) {
+        e.op(ADD_D); e.op(SUB_E); e.op(ANA_H); e.op(ORA_L);
+        e.op(XRA_D); e.op(CMP_E); e.op(ADC_H); e.op(SBB_L);
+    } },
+    { "micro/alu_imm", [](Emitter& e, uint16_t) {
+        e.op(ADI, 0x11); e.op(SUI, 0x22); e.op(ANI, 0xf0); e.op(ORI, 0x0f);
+        e.op(XRI, 0x55); e.op(CPI, 0x80); e.op(ACI, 0x01); e.op(SBI, 0x01);
+    } },
+    { "micro/inr_dcr", [](Emitter& e, uint16_t) {
+        e.op(INR_D); e.op(DCR_E); e.op(INR_H); e.op(DCR_L);
+    } },
+    { "micro/rotate", [](Emitter& e, uint16_t) {
+        e.op(RLC); e.op(RRC); e.op(RAL); e.op(RAR);
+    } },
+    { "micro/daa", [](Emitter& e, uint16_t) {
+        e.op(ADI, 0x19); e.op(DAA);
+    } },
+    { "micro/mem_indirect", [](Emitter& e, uint16_t) {
+        e.op(MOV_A_M); e.op(MOV_M_A); e.op(LDAX_D); e.op(STAX_D);
+    } },
+    { "micro/mem_direct", [](Emitter& e, uint16_t) {
+        e.op16(LDA, 0x4000); e.op16(STA, 0x4001); e.op16(LHLD, 0x4002); e.op16(SHLD, 0x4004);
+    } },
+    { "micro/pair_16", [](Emitter& e, uint16_t) {
+        e.op(INX_D); e.op(DCX_H); e.op(DAD_D); e.op(XCHG);
+    } },
+    { "micro/push_pop", [](Emitter& e, uint16_t) {
+        e.op(PUSH_D); e.op(POP_D); e.op(PUSH_H); e.op(POP_H);
+    } },
+    { "micro/jump", [](Emitter& e, uint16_t) {
+        // Taken jumps to the next instruction
+        e.op16(JMP, e.here() + 3); e.op16(JMP, e.here() + 3);
+    } },
+    { "micro/call_ret", [](Emitter& e, uint16_t subroutine) {
+        e.op16(CALL, subroutine); e.op16(CALL, subroutine);
+    } },
+};
+
+static std::vector<uint8_t> build_micro_benchmark(const MicroBenchmark& mb)
+{
+    Emitter e;
+
+    e.op16(LXI_SP, 0xf000);
+    e.op16(LXI_H, 0x4000);
+    e.op16(LXI_D, 0x4100);
+    e.op16(LXI_B, MICRO_ITERATIONS);
+
+    // Subroutine for the call benchmark, jumped over on entry
+    e.op16(JMP, e.here() + 4);
+    uint16_t subroutine = e.here();
+    e.op(RET);
+
+    uint16_t loop = e.here();
+
+    for(int i = 0; i < MICRO_BODY_REPEAT; i++)
+    {
+        mb.body(e, subroutine);
+    }
+
+    e.op(DCX_B);
+    e.op(MOV_A_B);
+    e.op(ORA_C);
+    e.op16(JNZ, loop);
+    e.op(HLT);
+
+    return e.code;
+}
+
+static bool read_source(const char* path, std::string& code)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+
+    if(!file.is_open())
+    {
+        std::cerr << "Error reading file \'" << path << "\'\n";
+        return false;
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    code = ss.str();
+
+    return true;
+}
+
+static bool assemble_quiet(std::string& code, std::vector<uint8_t>& program)
+{
+    Assembler assembler(code);
+    assembler.tokenize();
+    bool ok = assembler.parse();
+    program = assembler._program_instructions;
+
+    return ok && !program.empty();
+}
+
+// Runs the workload once from reset, returns the elapsed time in seconds
+static double run_once(const std::vector<uint8_t>& program, uint64_t& instructions, uint64_t& cycles, bool& halted)
+{
+    Processor cpu;
+    cpu.load_memory(0, program.data(), program.size());
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    instructions = cpu.run(MAX_INSTRUCTIONS);
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    cycles = cpu.cycles;
+    halted = cpu.halted;
+
+    return elapsed;
+}
+
+static bool measure(const Workload& w, int warmup, int repetitions, Result& result)
+{
+    bool halted = false;
+
+    for(int i = 0; i < warmup; i++)
+    {
+        run_once(w.program, result.instructions, result.cycles, halted);
+    }
+
+    std::vector<double> samples;
+
+    for(int i = 0; i < repetitions; i++)
+    {
+        double elapsed = run_once(w.program, result.instructions, result.cycles, halted);
+
+        if(!halted)
+        {
+            std::cerr << "\'" << w.name << "\' did not halt within " << MAX_INSTRUCTIONS << " instructions\n";
+            return false;
+        }
+
+        samples.push_back(elapsed * 1e9 / (double)result.instructions);
+    }
+
+    std::sort(samples.begin(), samples.end());
+
+    size_t n = samples.size();
+    double mean = 0;
+
+    for(double s : samples)
+    {
+        mean += s;
+    }
+    mean /= n;
+
+    double variance = 0;
+
+    for(double s : samples)
+    {
+        variance += (s - mean) * (s - mean);
+    }
+
+    result.median_ns = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    result.min_ns = samples[0];
+    result.stddev_ns = n > 1 ? std::sqrt(variance / (n - 1)) : 0;
+
+    return true;
+}
+
+static void print_help()
+{
+    std::cout << "retro85b [workload.asm...] [--reps N] [--warmup N] [--filter TEXT] [--no-micro]\n";
+    std::cout << "     Runs every workload to HLT from reset and reports ns/instruction and MIPS\n";
+    std::cout << "     over N timed repetitions (default 10) after warmup runs (default 2)\n";
+    std::cout << "     Generated per instruction class microbenchmarks run unless --no-micro\n";
+}
+
+int main(int argc, char* argv[])
+{
+    int repetitions = 10;
+    int warmup = 2;
+    bool micro = true;
+    std::string filter;
+    std::vector<Workload> workloads;
+
+    while(*(++argv) != nullptr)
+    {
+        std::string arg(*argv);
+
+        if((arg == "--reps" || arg == "--warmup") && argv[1])
+        {
+            int value = std::atoi(*(++argv));
+
+            if(arg == "--reps") repetitions = std::max(1, value);
+            else                warmup = std::max(0, value);
+        }
+        else if(arg == "--filter" && argv[1])
+        {
+            filter = *(++argv);
+        }
+        else if(arg == "--no-micro")
+        {
+            micro = false;
+        }
+        else if(arg == "-h" || arg == "--help")
+        {
+            print_help();
+            return 0;
+        }
+        else
+        {
+            Workload w;
+            std::string code;
+
+            w.name = arg.substr(arg.find_last_of("/\\") + 1);
+
+            if(!read_source(*argv, code))
+            {
+                return -1;
+            }
+
+            if(!assemble_quiet(code, w.program))
+            {
+                std::cerr << "Error assembling \'" << arg << "\'\n";
+                return -1;
+            }
+
+            workloads.push_back(w);
+        }
+    }
+
+    if(micro)
+    {
+        for(const MicroBenchmark& mb : micro_benchmarks)
+        {
+            workloads.push_back({ mb.name, build_micro_benchmark(mb) });
+        }
+    }
+
+    std::cout << "Repetitions: " << repetitions << ", warmup: " << warmup << "\n\n";
+    std::cout << std::left << std::setw(22) << "Workload"
+        << std::right << std::setw(12) << "Instr"
+        << std::setw(13) << "Cycles"
+        << std::setw(12) << "ns/instr"
+        << std::setw(10) << "min"
+        << std::setw(10) << "stddev"
+        << std::setw(10) << "MIPS" << "\n";
+
+    int failures = 0;
+
+    for(const Workload& w : workloads)
+    {
+        if(!filter.empty() && w.name.find(filter) == std::string::npos)
+        {
+            continue;
+        }
+
+        Result r;
+
+        if(!measure(w, warmup, repetitions, r))
+        {
+            failures++;
+            continue;
+        }
+
+        std::cout << std::left << std::setw(22) << w.name
+            << std::right << std::setw(12) << r.instructions
+            << std::setw(13) << r.cycles
+            << std::fixed << std::setprecision(2)
+            << std::setw(12) << r.median_ns
+            << std::setw(10) << r.min_ns
+            << std::setw(10) << r.stddev_ns
+            << std::setw(10) << (r.median_ns > 0 ? 1e3 / r.median_ns : 0.0) << "\n";
+        std::cout.unsetf(std::ios_base::fixed);
+    }
+
+    return failures ? 1 : 0;
+}
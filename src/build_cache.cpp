@@ -0,0 +1,219 @@
+#include "build_cache.h"
+#include "assembler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <thread>
+
+namespace lib8085
+{
+    static const char _cache_magic[4] = { 'R', '8', '5', 'K' };
+    static const uint8_t _cache_version = 1;
+
+    static uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    static void put_32(std::vector<uint8_t>& out, uint32_t v)
+    {
+        for(int i = 0; i < 4; i ++)
+        {
+            out.push_back((uint8_t)(v >> (i * 8)));
+        }
+    }
+
+    static void put_string(std::vector<uint8_t>& out, const std::string& str)
+    {
+        put_32(out, (uint32_t)str.size());
+        out.insert(out.end(), str.begin(), str.end());
+    }
+
+    BuildCache::BuildCache(const std::string& directory) : _directory(directory)
+    {
+    }
+
+    std::string BuildCache::key(const std::string& kind, const std::string& source)
+    {
+        std::string material = "retro85 " + std::to_string(Assembler::VERSION) + " " + kind + "\n" + source;
+
+        // Two lanes over 8 byte words, 128 bits keep accidental collisions out of reach
+        uint64_t h1 = 0x9e3779b97f4a7c15ull;
+        uint64_t h2 = 0xc2b2ae3d27d4eb4full;
+        size_t i = 0;
+
+        for(; i < material.size(); i += 8)
+        {
+            uint64_t word = 0;
+            for(size_t j = 0; j < 8 && i + j < material.size(); j ++)
+            {
+                word |= (uint64_t)(uint8_t)material[i + j] << (j * 8);
+            }
+
+            h1 = mix(h1 ^ word) + 0x165667b19e3779f9ull;
+            h2 = mix(h2 + word * 0xff51afd7ed558ccdull) ^ h1;
+        }
+
+        h1 = mix(h1 ^ material.size());
+        h2 = mix(h2 ^ h1);
+
+        char hex[33];
+        std::snprintf(hex, sizeof(hex), "%016llx%016llx", (unsigned long long)h1, (unsigned long long)h2);
+        return hex;
+    }
+
+    std::string BuildCache::entry_path(const std::string& key) const
+    {
+        return (std::filesystem::path(_directory) / (key + ".r85k")).string();
+    }
+
+    bool BuildCache::load(const std::string& key, Entry& entry) const
+    {
+        std::ifstream file(entry_path(key), std::ios::in | std::ios::binary);
+
+        if(!file.good() || !file.is_open())
+        {
+            return false;
+        }
+
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t offset = 0;
+
+        auto get_32 = [&](uint32_t& v)
+        {
+            if(data.size() - offset < 4)
+            {
+                return false;
+            }
+            v = 0;
+            for(int i = 3; i >= 0; i --)
+            {
+                v = (v << 8) | data[offset + i];
+            }
+            offset += 4;
+            return true;
+        };
+
+        auto get_string = [&](std::string& str)
+        {
+            uint32_t size;
+            if(!get_32(size) || data.size() - offset < size)
+            {
+                return false;
+            }
+            str.assign(data.begin() + offset, data.begin() + offset + size);
+            offset += size;
+            return true;
+        };
+
+        if(data.size() < 6
+                || !std::equal(_cache_magic, _cache_magic + 4, data.begin())
+                || data[4] != _cache_version)
+        {
+            return false;
+        }
+
+        entry = Entry();
+        entry.assembled = data[5] != 0;
+        offset = 6;
+
+        uint32_t size;
+        if(!get_32(size) || data.size() - offset < size)
+        {
+            return false;
+        }
+        entry.output.assign(data.begin() + offset, data.begin() + offset + size);
+        offset += size;
+
+        uint32_t count;
+        if(!get_32(count))
+        {
+            return false;
+        }
+
+        for(uint32_t i = 0; i < count; i ++)
+        {
+            Diagnostic d;
+            uint32_t severity, line, column;
+
+            if(!get_32(severity) || !get_string(d.code) || !get_32(line) || !get_32(column) || !get_string(d.message)
+                    || severity > SEVERITY_ERROR)
+            {
+                return false;
+            }
+
+            d.severity = (Severity)severity;
+            d.line = (int)line;
+            d.column = (int)column;
+            entry.diagnostics.push_back(std::move(d));
+        }
+
+        return offset == data.size();
+    }
+
+    bool BuildCache::store(const std::string& key, const Entry& entry) const
+    {
+        std::vector<uint8_t> data(_cache_magic, _cache_magic + sizeof(_cache_magic));
+        data.push_back(_cache_version);
+        data.push_back(entry.assembled ? 1 : 0);
+
+        put_32(data, (uint32_t)entry.output.size());
+        data.insert(data.end(), entry.output.begin(), entry.output.end());
+
+        put_32(data, (uint32_t)entry.diagnostics.size());
+        for(const Diagnostic& d : entry.diagnostics)
+        {
+            put_32(data, (uint32_t)d.severity);
+            put_string(data, d.code);
+            put_32(data, (uint32_t)d.line);
+            put_32(data, (uint32_t)d.column);
+            put_string(data, d.message);
+        }
+
+        std::error_code error;
+        std::filesystem::create_directories(_directory, error);
+
+        // Unique per writer, other threads and processes may store the same key
+        static std::atomic<uint64_t> counter(0);
+        const std::string path = entry_path(key);
+        const std::string temporary = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()))
+            + "." + std::to_string(counter++) + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+
+        {
+            std::ofstream file(temporary, std::ios::out | std::ios::binary);
+
+            if(!file.good() || !file.is_open())
+            {
+                return false;
+            }
+
+            file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+            if(!file.good())
+            {
+                file.close();
+                std::remove(temporary.c_str());
+                return false;
+            }
+        }
+
+        // Fails when another writer got there first, its entry has the same content
+        if(std::rename(temporary.c_str(), path.c_str()) != 0)
+        {
+            std::remove(temporary.c_str());
+        }
+
+        return true;
+    }
+}
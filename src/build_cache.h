@@ -0,0 +1,48 @@
+#pragma once
+#include "diagnostics.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Assembled outputs kept on disk by a hash of everything that decides
+     * them: the assembler version, the kind of output and the source. Sources
+     * can't include other files yet, once they can the included text belongs
+     * in the key as well.
+     *
+     * An entry keeps the diagnostics next to the output, a hit reports the same
+     * warnings and errors assembling did, failed sources are cached too. Entries
+     * are written to a temporary file and renamed so processes sharing the
+     * directory never see half an entry. Nothing is evicted, deleting the
+     * directory empties the cache.
+     *
+     */
+    class BuildCache
+    {
+        public:
+            struct Entry
+            {
+                bool assembled = false;
+                std::vector<uint8_t> output;
+                // Without a file name, the caller stamps the path it assembled
+                std::vector<Diagnostic> diagnostics;
+            };
+
+            BuildCache(const std::string& directory);
+
+            // 32 hex digits naming the entry for assembling source to kind, "program" or "object"
+            static std::string key(const std::string& kind, const std::string& source);
+
+            // False on a miss or an entry that can't be read
+            bool load(const std::string& key, Entry& entry) const;
+            bool store(const std::string& key, const Entry& entry) const;
+
+        private:
+            std::string _directory;
+
+            std::string entry_path(const std::string& key) const;
+    };
+}
@@ -0,0 +1,58 @@
+#include "call_graph.h"
+
+#include <algorithm>
+#include <string>
+
+namespace lib8085
+{
+    CallGraph::CallGraph()
+    {
+        reset();
+    }
+
+    void CallGraph::reset()
+    {
+        _nodes.clear();
+        _frames.clear();
+        _children.clear();
+        _current = 0;
+        _last_cycles = 0;
+    }
+
+    size_t CallGraph::depth() const
+    {
+        return _frames.size();
+    }
+
+    size_t CallGraph::path_count() const
+    {
+        return _nodes.size();
+    }
+
+    void CallGraph::write_folded(std::ostream& out, const SourceMap& source) const
+    {
+        std::vector<std::string> paths(_nodes.size());
+        std::vector<std::string> lines;
+
+        // Parents are always created before their children
+        for(size_t i = 0; i < _nodes.size(); i ++)
+        {
+            const Node& node = _nodes[i];
+            std::string name = source.location(node.address) + (node.interrupt ? " [interrupt]" : "");
+
+            paths[i] = i == 0 ? name : paths[node.parent] + ";" + name;
+
+            if(node.cycles)
+            {
+                lines.push_back(paths[i] + " " + std::to_string(node.cycles));
+            }
+        }
+
+        std::sort(lines.begin(), lines.end());
+
+        for(const std::string& line : lines)
+        {
+            out << line << "\n";
+        }
+    }
+}
@@ -0,0 +1,167 @@
+#pragma once
+#include "lib8085.h"
+#include "source_map.h"
+
+#include <cstdint>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Call graph profile kept as a tree of call paths with the T-states spent in
+     * each, written out as folded stacks for flame graphs.
+     *
+     * Attach to a Processor with attach_call_graph. run() then reports taken
+     * calls, restarts, returns and interrupt entries, everything in between
+     * costs nothing. Shadow frames remember the stack slot and return address
+     * of their call. A return through an outer slot unwinds every frame above
+     * it, a RET that matches no frame (a computed jump) leaves the stack alone
+     * and frames whose slot was popped without a return are dropped on the
+     * next call.
+     *
+     * What run() calls is defined here so the processor doesn't link against
+     * the reporting side.
+     *
+     */
+    class CallGraph
+    {
+        public:
+            // Deeper recursion is folded into the deepest frame
+            static const size_t MAX_DEPTH = 4096;
+
+            CallGraph();
+
+            void reset();
+
+            // Called by Processor::run before and after a run
+            void begin(uint16_t address, uint64_t cycles)
+            {
+                if(_nodes.empty())
+                {
+                    _nodes.push_back(Node{ 0, address, false, 0 });
+                    _current = 0;
+                }
+                _last_cycles = cycles;
+            }
+
+            void end(uint64_t cycles)
+            {
+                _nodes[_current].cycles += cycles - _last_cycles;
+                _last_cycles = cycles;
+            }
+
+            // Called by Processor::run after every instruction with the opcode and SP it started with
+            void step(const Processor& cpu, uint8_t opcode, uint16_t stack_pointer, bool interrupted)
+            {
+                if(interrupted)
+                {
+                    enter(cpu, true);
+                    return;
+                }
+
+                switch(opcode)
+                {
+                    case CALL: case CC: case CNC: case CZ: case CNZ: case CP: case CM: case CPE: case CPO:
+                    case RST_0: case RST_1: case RST_2: case RST_3: case RST_4: case RST_5: case RST_6: case RST_7:
+                        // Conditional calls that aren't taken leave the stack where it was
+                        if(cpu.stack_pointer == (uint16_t)(stack_pointer - 2))
+                        {
+                            enter(cpu, false);
+                        }
+                        break;
+                    case RET: case RC: case RNC: case RZ: case RNZ: case RP: case RM: case RPE: case RPO:
+                        if(cpu.stack_pointer == (uint16_t)(stack_pointer + 2))
+                        {
+                            leave(cpu.program_counter, stack_pointer, cpu.cycles);
+                        }
+                        break;
+                }
+            }
+
+            size_t depth() const;
+            size_t path_count() const;
+
+            // One "outer;inner cycles" line per call path, labels from source where known
+            void write_folded(std::ostream& out, const SourceMap& source) const;
+
+        private:
+            struct Node
+            {
+                uint32_t parent;
+                uint16_t address;
+                bool interrupt;
+                uint64_t cycles;
+            };
+
+            struct Frame
+            {
+                uint32_t node;
+                uint16_t return_address;
+                // Where the return address was pushed
+                uint16_t stack_pointer;
+            };
+
+            std::vector<Node> _nodes;
+            std::vector<Frame> _frames;
+            // (parent, interrupt, address) to child node
+            std::unordered_map<uint64_t, uint32_t> _children;
+            uint32_t _current;
+            uint64_t _last_cycles;
+
+            void enter(const Processor& cpu, bool interrupt)
+            {
+                _nodes[_current].cycles += cpu.cycles - _last_cycles;
+                _last_cycles = cpu.cycles;
+
+                // Frames at or below the new slot were popped without returning
+                while(!_frames.empty() && _frames.back().stack_pointer <= cpu.stack_pointer)
+                {
+                    _current = _frames.back().node;
+                    _frames.pop_back();
+                }
+
+                // The return address is what the call just pushed
+                uint16_t return_address = (uint16_t)(cpu.read_mem(cpu.stack_pointer)
+                    | (cpu.read_mem((uint16_t)(cpu.stack_pointer + 1)) << 8));
+
+                _frames.push_back(Frame{ _current, return_address, cpu.stack_pointer });
+
+                if(_frames.size() > MAX_DEPTH)
+                {
+                    return;
+                }
+
+                uint64_t key = ((uint64_t)_current << 17) | ((uint64_t)interrupt << 16) | cpu.program_counter;
+                std::unordered_map<uint64_t, uint32_t>::iterator it = _children.find(key);
+
+                if(it != _children.end())
+                {
+                    _current = it->second;
+                    return;
+                }
+
+                _nodes.push_back(Node{ _current, cpu.program_counter, interrupt, 0 });
+                _current = (uint32_t)(_nodes.size() - 1);
+                _children.insert({ key, _current });
+            }
+
+            void leave(uint16_t address, uint16_t stack_pointer, uint64_t cycles)
+            {
+                _nodes[_current].cycles += cycles - _last_cycles;
+                _last_cycles = cycles;
+
+                // Outer frames sit higher up the stack, no need to look past the popped slot
+                for(size_t i = _frames.size(); i-- > 0 && _frames[i].stack_pointer <= stack_pointer;)
+                {
+                    if(_frames[i].stack_pointer == stack_pointer && _frames[i].return_address == address)
+                    {
+                        _current = _frames[i].node;
+                        _frames.resize(i);
+                        return;
+                    }
+                }
+            }
+    };
+}
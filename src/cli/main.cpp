@@ -1,12 +1,36 @@
 #include "../assembler.h"
+#include "../sweep.h"
+#include "../test_runner.h"
+#include "../differential.h"
+#include "../instruction_sweep.h"
+#include "../input_log.h"
+#include "../savestate.h"
+#include "../profiler.h"
+#include "../call_graph.h"
+#include "../coverage.h"
+#include "../trace.h"
+#include "../isa.h"
+#include "../parallel.h"
+#include "../linker.h"
+#include "../assembler_util.h"
+#include "../build_cache.h"
 
 #include <iostream>
 #include <fstream>
+#include <cstdlib>
+#include <chrono>
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <sstream>
+#include <memory>
+#include <stdexcept>
 
-void write_file(const char* path, char* data, size_t len)
+// False when the file couldn't be written, the reason goes to err
+bool write_file(const char* path, char* data, size_t len, std::ostream& out = std::cout, std::ostream& err = std::cerr)
 {
-    std::cout << "Writing file: \'" << path << "\' " << "\n";
-    std::cout << "Data size: " << len << "\n";
+    out << "Writing file: \'" << path << "\' " << "\n";
+    out << "Data size: " << len << "\n";
     std::ofstream file(path, std::ios::out | std::ios::binary);
 
     if(file.good() && file.is_open())
@@ -14,21 +38,31 @@ void write_file(const char* path, char* data, size_t len)
         file.write(data, len);
         file.close();
     }
-    else
+
+    if(!file.good())
     {
-        std::cerr << "Error writing file \'" << path << "\'\n";
+        err << "Error writing file \'" << path << "\'\n";
+        return false;
     }
+
+    return true;
 }
 
-std::vector<uint8_t> read_file(const char* path)
+std::vector<uint8_t> read_file(const char* path, std::ostream& out = std::cout, std::ostream& err = std::cerr)
 {
-    std::ifstream file(path);
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+
+    if(!file.is_open())
+    {
+        err << "Error reading file \'" << path << "\'\n";
+        return std::vector<uint8_t>();
+    }
 
     file.seekg(0, std::ios_base::end);
     std::vector<uint8_t> data(file.tellg());
     file.seekg(0, std::ios_base::beg);
 
-    std::cout << "File size: " << data.size() << "\n";
+    out << "File size: " << data.size() << "\n";
     if(file.good() && file.is_open())
     {
         file.read(reinterpret_cast<char*>(&data[0]), data.size());
@@ -36,16 +70,22 @@ std::vector<uint8_t> read_file(const char* path)
     }
     else
     {
-        std::cerr << "Error reading file \'" << path << "\'\n";
+        err << "Error reading file \'" << path << "\'\n";
     }
 
     return data;
 }
 
-std::vector<uint8_t> assemble(std::string& code)
+// Errors and warnings go to std::cerr, an empty program means assembling failed
+std::vector<uint8_t> assemble(std::string& code, const char* path)
 {
     lib8085::Assembler assembler(code);
-    return assembler.assemble();
+    assembler.diagnostics().set_file(path);
+
+    std::vector<uint8_t> program = assembler.assemble();
+    assembler.diagnostics().print(std::cerr);
+
+    return program;
 }
 
 std::map<uint64_t, std::string> disassemble(std::vector<uint8_t> instructions)
@@ -56,51 +96,931 @@ std::map<uint64_t, std::string> disassemble(std::vector<uint8_t> instructions)
     std::cout << "Program size: " << assembler._program_instructions.size() << "\n";;
 
     assembler.disassemble();
+    assembler.diagnostics().print(std::cerr);
     return assembler._disassembly;
 }
 
-void print_help()
+// Reads an assembled .retro85 file as is, anything else is assembled first.
+// When source is given it receives the line and label map of assembled programs
+std::vector<uint8_t> load_program(const char* path, lib8085::SourceMap* source = nullptr)
 {
-    std::cout << "-a - Assemble source code\n";
-    std::cout << "-d - Dissassemble program\n";
-    std::cout << "-r - Run program\n";
+    std::string p(path);
+    std::vector<uint8_t> file_bin = read_file(path);
+
+    if(p.size() > 8 && p.compare(p.size() - 8, 8, ".retro85") == 0)
+    {
+        return file_bin;
+    }
+
+    std::string code(file_bin.begin(), file_bin.end());
+
+    if(!source)
+    {
+        return assemble(code, path);
+    }
+
+    lib8085::Assembler assembler(code);
+    assembler.diagnostics().set_file(path);
+    std::vector<uint8_t> program = assembler.assemble();
+    assembler.diagnostics().print(std::cerr);
+    *source = lib8085::SourceMap(assembler, code);
+
+    return program;
 }
 
-int main(int argc, char* argv[])
+// What assembling one file printed, held until the files before it are printed
+struct AssembleJob
 {
-    while(*(++argv) != nullptr)
+    std::ostringstream out;
+    std::ostringstream err;
+    lib8085::Diagnostics diagnostics;
+    // 0 assembled, 1 failed to assemble or write, -1 empty or unreadable
+    int result = 0;
+};
+
+struct AssembleOptions
+{
+    bool verbose = false;
+    bool object = false;
+    // Outputs are looked up here before assembling and stored after, when set
+    const lib8085::BuildCache* cache = nullptr;
+};
+
+// Assembles path to path.retro85, or to the object path.obj, safe to run for several files at once
+void assemble_file(const char* path, AssembleJob& job, const AssembleOptions& options)
+{
+    job.out << "Assembling file:\'" << path << "\'\n";
+
+    std::vector<uint8_t> file_bin = read_file(path, job.out, job.err);
+
+    if(file_bin.size() == 0)
     {
-        if(std::string(*argv) == "-a")
+        job.out << "File empty, skipping\n";
+        job.diagnostics.set_file(path);
+        job.diagnostics.error("A010", 0, 0, "File is empty or could not be read");
+        job.result = -1;
+        return;
+    }
+
+    std::string code(file_bin.begin(), file_bin.end());
+    lib8085::BuildCache::Entry entry;
+    lib8085::ObjectModule module;
+    std::string key;
+    bool cached = false;
+
+    if(options.cache)
+    {
+        key = lib8085::BuildCache::key(options.object ? "object" : "program", code);
+
+        // -v asks for the assembler's trace, so it always assembles
+        cached = !options.verbose && options.cache->load(key, entry)
+            && (!options.object || !entry.assembled || module.deserialize(entry.output));
+    }
+
+    if(cached)
+    {
+        job.out << "Found in cache\n";
+    }
+    else
+    {
+        lib8085::Assembler assembler(code);
+        if(options.verbose)
+        {
+            assembler.set_log(job.out);
+        }
+
+        if(options.object)
         {
-            // Compile all paths
-            while(*(++argv) != nullptr)
+            entry.assembled = assembler.assemble_object(module);
+            if(entry.assembled)
             {
-                std::cout << "Assembling file:\'" << *argv << "\'\n";
+                module.serialize(entry.output);
+            }
+        }
+        else
+        {
+            entry.output = assembler.assemble();
+            entry.assembled = entry.output.size() > 0;
+        }
 
-                std::vector<uint8_t> file_bin = read_file(*argv);
+        entry.diagnostics = assembler.diagnostics().entries();
 
-                if(file_bin.size() == 0)
-                {
-                    std::cout << "File empty, exiting\n";
-                    return -1;
-                }
+        if(options.cache)
+        {
+            options.cache->store(key, entry);
+        }
+    }
 
-                std::string code(file_bin.begin(), file_bin.end());
-                std::vector<uint8_t> machine_code = assemble(code);
+    // Entries don't know the path, the same source elsewhere shares one
+    job.diagnostics.set_file(path);
+    for(const lib8085::Diagnostic& d : entry.diagnostics)
+    {
+        job.diagnostics.report(d.severity, d.code.c_str(), d.line, d.column, d.message);
+    }
 
-                if(machine_code.size() > 0)
-                {
-                    std::cout << "Writing to file:\'" << *argv << ".retro85\'...";
-                    std::string output_path = std::string(*argv) + ".retro85";
+    if(!entry.assembled)
+    {
+        job.out << "Some error occured while assembling\n";
+        job.result = 1;
+        return;
+    }
 
-                    write_file(output_path.c_str(), reinterpret_cast<char*>(machine_code.data()), machine_code.size() * sizeof(uint8_t));
-                }
-                else
-                {
-                    std::cout << "Some error occured while assembling\n";
-                }
+    if(options.object)
+    {
+        std::string output_path = std::string(path) + ".obj";
+        if(module.save(output_path.c_str(), job.err))
+        {
+            job.out << "Wrote object:\'" << output_path << "\' " << module.sections[0].data.size() << " bytes, "
+                << module.symbols.size() << " symbols, " << module.relocations.size() << " relocations\n";
+        }
+        else
+        {
+            job.result = 1;
+        }
+        return;
+    }
+
+    job.out << "Writing to file:\'" << path << ".retro85\'...";
+    std::string output_path = std::string(path) + ".retro85";
+
+    if(!write_file(output_path.c_str(), reinterpret_cast<char*>(entry.output.data()), entry.output.size() * sizeof(uint8_t), job.out, job.err))
+    {
+        job.result = 1;
+    }
+}
+
+int assemble_files(char** argv)
+{
+    bool json = false;
+    bool verbose = false;
+    AssembleOptions options;
+    unsigned threads = 0;
+    const char* cache_directory = std::getenv("RETRO85_CACHE");
+    std::vector<const char*> paths;
+    lib8085::Diagnostics diagnostics;
+    int result = 0;
+
+    for(; *argv != nullptr; argv++)
+    {
+        std::string arg(*argv);
+
+        if(arg == "--json")
+        {
+            json = true;
+        }
+        else if(arg == "-v")
+        {
+            verbose = true;
+        }
+        else if(arg == "--obj")
+        {
+            options.object = true;
+        }
+        else if(arg == "--threads" && argv[1])
+        {
+            threads = (unsigned)std::strtoul(*(++argv), nullptr, 0);
+        }
+        else if(arg == "--cache" && argv[1])
+        {
+            cache_directory = *(++argv);
+        }
+        else if(arg == "--no-cache")
+        {
+            cache_directory = nullptr;
+        }
+        else
+        {
+            paths.push_back(*argv);
+        }
+    }
+
+    std::unique_ptr<lib8085::BuildCache> cache;
+    if(cache_directory != nullptr && *cache_directory != '\0')
+    {
+        cache = std::make_unique<lib8085::BuildCache>(cache_directory);
+    }
+
+    options.verbose = verbose && !json;
+    options.cache = cache.get();
+
+    // Files are independent, they are assembled in parallel and reported in the order given
+    std::vector<AssembleJob> jobs(paths.size());
+
+    lib8085::parallel_for(paths.size(), [&](size_t index, unsigned worker)
+    {
+        assemble_file(paths[index], jobs[index], options);
+    }, threads);
+
+    for(AssembleJob& job : jobs)
+    {
+        // With --json stdout only carries the JSON document
+        if(json)
+        {
+            diagnostics.merge(job.diagnostics);
+        }
+        else
+        {
+            std::cout << job.out.str();
+        }
+
+        std::cerr << job.err.str();
+
+        if(!json)
+        {
+            job.diagnostics.print(std::cerr);
+        }
+
+        if(job.result < 0)
+        {
+            result = -1;
+        }
+        else if(job.result > 0 && result == 0)
+        {
+            result = 1;
+        }
+    }
+
+    if(json)
+    {
+        diagnostics.write_json(std::cout);
+    }
+
+    return result;
+}
+
+// A few seconds of emulation, a program that never halts still ends with its state printed
+static const uint64_t DEFAULT_RUN_CYCLES = 4000000000ull;
+
+int run(char** argv)
+{
+    uint64_t max_instructions = UINT64_MAX;
+    uint64_t max_cycles = DEFAULT_RUN_CYCLES;
+    const char* program_path = nullptr;
+    const char* record_path = nullptr;
+    const char* replay_path = nullptr;
+    const char* load_state_path = nullptr;
+    const char* save_state_path = nullptr;
+    bool profile = false;
+    size_t profile_top = 20;
+    const char* folded_path = nullptr;
+    const char* coverage_path = nullptr;
+    const char* lcov_path = nullptr;
+    const char* trace_path = nullptr;
+
+    for(; *argv != nullptr; argv++)
+    {
+        std::string arg(*argv);
+
+        if(arg == "--max" && argv[1])
+        {
+            max_instructions = std::strtoull(*(++argv), nullptr, 0);
+        }
+        else if(arg == "--profile")
+        {
+            profile = true;
+        }
+        else if(arg == "--top" && argv[1])
+        {
+            profile_top = (size_t)std::strtoull(*(++argv), nullptr, 0);
+        }
+        else if(arg == "--folded" && argv[1])
+        {
+            folded_path = *(++argv);
+        }
+        else if(arg == "--coverage" && argv[1])
+        {
+            coverage_path = *(++argv);
+        }
+        else if(arg == "--lcov" && argv[1])
+        {
+            lcov_path = *(++argv);
+        }
+        else if(arg == "--trace" && argv[1])
+        {
+            trace_path = *(++argv);
+        }
+        else if(arg == "--max-cycles" && argv[1])
+        {
+            max_cycles = std::strtoull(*(++argv), nullptr, 0);
+        }
+        else if(arg == "--record" && argv[1])
+        {
+            record_path = *(++argv);
+        }
+        else if(arg == "--replay" && argv[1])
+        {
+            replay_path = *(++argv);
+        }
+        else if(arg == "--load-state" && argv[1])
+        {
+            load_state_path = *(++argv);
+        }
+        else if(arg == "--save-state" && argv[1])
+        {
+            save_state_path = *(++argv);
+        }
+        else if(!program_path)
+        {
+            program_path = *argv;
+        }
+        else
+        {
+            std::cerr << "Unexpected argument \'" << arg << "\'\n";
+            return -1;
+        }
+    }
+
+    if(!program_path && !load_state_path)
+    {
+        std::cerr << "Expected a program or --load-state to run\n";
+        return -1;
+    }
+
+    lib8085::Processor cpu;
+    lib8085::Profiler profiler;
+    lib8085::CallGraph call_graph;
+    lib8085::Coverage coverage;
+    lib8085::TraceWriter trace;
+    lib8085::SourceMap source;
+
+    if(profile)
+    {
+        cpu.attach_profiler(&profiler);
+    }
+
+    if(folded_path)
+    {
+        cpu.attach_call_graph(&call_graph);
+    }
+
+    if(coverage_path || lcov_path)
+    {
+        // Accumulate into an existing coverage file
+        if(coverage_path && std::ifstream(coverage_path).good() && !coverage.load(coverage_path))
+        {
+            return -1;
+        }
+
+        cpu.attach_coverage(&coverage);
+    }
+
+    if(trace_path)
+    {
+        if(!trace.open(trace_path))
+        {
+            return -1;
+        }
+
+        cpu.attach_trace(&trace);
+    }
+
+    if(load_state_path)
+    {
+        lib8085::SaveState state;
+
+        if(!state.load(load_state_path) || !state.restore(cpu))
+        {
+            return -1;
+        }
+    }
+
+    if(program_path)
+    {
+        std::vector<uint8_t> program = load_program(program_path, &source);
+
+        if(program.empty())
+        {
+            std::cerr << "Nothing to run in \'" << program_path << "\'\n";
+            return -1;
+        }
+
+        cpu.load_memory(0, program.data(), program.size());
+    }
+
+    // No devices are attached in headless mode, IN reads FFh unless replayed
+    lib8085::InputLog log;
+    lib8085::InputRecorder recorder(nullptr, log);
+    std::unique_ptr<lib8085::InputReplayer> replayer;
+
+    if(replay_path)
+    {
+        if(!log.load(replay_path))
+        {
+            return -1;
+        }
+
+        replayer.reset(new lib8085::InputReplayer(log));
+        cpu.attach_bus(replayer.get());
+    }
+    else if(record_path)
+    {
+        cpu.attach_bus(&recorder);
+    }
+
+    uint64_t start_cycles = cpu.cycles;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    uint64_t instructions = 0;
+    std::string divergence;
+
+    // A log that doesn't belong to this program or is cut short is reported, not fatal
+    try
+    {
+        instructions = cpu.run(max_instructions, max_cycles);
+    }
+    catch(const std::runtime_error& e)
+    {
+        divergence = e.what();
+    }
+
+    if(replayer && divergence.empty() && !replayer->done())
+    {
+        divergence = "Replay stopped before the end of the input log";
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    cpu.print();
+
+    if(!divergence.empty())
+    {
+        std::cerr << divergence << " \'" << replay_path << "\'\n";
+        return 1;
+    }
+
+    std::cout << (cpu.halted ? "Halted" : "Budget exhausted") << "\n";
+    std::cout << "Instructions: " << instructions << "\n";
+    std::cout << "Cycles: " << (cpu.cycles - start_cycles) << "\n";
+    std::cout << "Elapsed: " << elapsed * 1000.0 << " ms\n";
+    std::cout << "MIPS: " << (elapsed > 0 ? instructions / elapsed / 1e6 : 0.0) << "\n";
+
+    if(profile)
+    {
+        std::cout << "\n";
+        profiler.print_report(std::cout, source, profile_top);
+    }
+
+    if(folded_path)
+    {
+        std::ofstream folded(folded_path, std::ios::out | std::ios::binary);
+
+        if(!folded.is_open())
+        {
+            std::cerr << "Error writing file \'" << folded_path << "\'\n";
+            return -1;
+        }
+
+        call_graph.write_folded(folded, source);
+        std::cout << "Call paths: " << call_graph.path_count() << " written to \'" << folded_path << "\'\n";
+    }
+
+    if(trace_path)
+    {
+        if(!trace.close())
+        {
+            return -1;
+        }
+
+        std::cout << "Trace: " << trace.instruction_count() << " instructions, " << trace.raw_bytes() << " bytes encoded, "
+                  << trace.file_bytes() << " bytes written to \'" << trace_path << "\'\n";
+    }
+
+    if(coverage_path || lcov_path)
+    {
+        std::cout << "\n";
+        coverage.print_report(std::cout, source);
+
+        if(coverage_path && !coverage.save(coverage_path))
+        {
+            return -1;
+        }
+    }
+
+    if(lcov_path)
+    {
+        std::ofstream lcov(lcov_path, std::ios::out | std::ios::binary);
+
+        if(!lcov.is_open())
+        {
+            std::cerr << "Error writing file \'" << lcov_path << "\'\n";
+            return -1;
+        }
+
+        coverage.write_lcov(lcov, source, program_path ? program_path : "");
+    }
+
+    if(record_path && !replay_path && !log.save(record_path))
+    {
+        return -1;
+    }
+
+    if(save_state_path && !lib8085::SaveState::save(cpu, save_state_path))
+    {
+        return -1;
+    }
+
+    return cpu.halted ? 0 : 1;
+}
+
+int sweep(char** argv)
+{
+    lib8085::ParameterSweep::Options options;
+    uint32_t seed = 1;
+    const char* program_path = nullptr;
+    std::vector<std::string> specs;
+
+    for(; *argv != nullptr; argv++)
+    {
+        std::string arg(*argv);
+
+        if((arg == "--max" || arg == "--threads" || arg == "--seed" || arg == "--outliers") && argv[1])
+        {
+            unsigned long long value = std::strtoull(*(++argv), nullptr, 0);
+
+            if(arg == "--max")          options.max_instructions = value;
+            else if(arg == "--threads") options.threads = (unsigned)value;
+            else if(arg == "--seed")    seed = (uint32_t)value;
+            else                        options.max_outliers = (size_t)value;
+        }
+        else if(!program_path)
+        {
+            program_path = *argv;
+        }
+        else
+        {
+            specs.push_back(arg);
+        }
+    }
+
+    if(!program_path)
+    {
+        std::cerr << "Expected a program to sweep\n";
+        return -1;
+    }
+
+    lib8085::ParameterSweep sweep(seed);
+    std::string error;
+
+    for(const std::string& spec : specs)
+    {
+        if(!sweep.add_variable(spec, error))
+        {
+            std::cerr << error << "\n";
+            return -1;
+        }
+    }
+
+    std::vector<uint8_t> program = load_program(program_path);
+    if(program.empty())
+    {
+        std::cerr << "Nothing to run in \'" << program_path << "\'\n";
+        return -1;
+    }
+
+    std::cout << "Sweeping " << sweep.combination_count() << " initial states\n";
+    sweep.run(program, options);
+    sweep.print_report(std::cout);
+
+    return 0;
+}
+
+// Links objects into one program, --org places the object after it
+int link_objects(char** argv)
+{
+    if(*argv == nullptr)
+    {
+        std::cerr << "Expected an output file and objects to link\n";
+        return -1;
+    }
+
+    const char* output_path = *argv++;
+    lib8085::Linker linker;
+    bool has_origin = false;
+    uint32_t origin = 0;
+    size_t count = 0;
+
+    for(; *argv != nullptr; argv++)
+    {
+        std::string arg(*argv);
+
+        if(arg == "--org" && argv[1])
+        {
+            if(!lib8085::AssemblerUtil::parse_number(*(++argv), origin) || origin > 0xffff)
+            {
+                std::cerr << "Invalid origin \'" << *argv << "\'\n";
+                return -1;
             }
-            break;
+            has_origin = true;
+            continue;
+        }
+
+        lib8085::ObjectModule module;
+        if(!module.load(*argv))
+        {
+            return -1;
+        }
+
+        if(has_origin)
+        {
+            linker.add(module, arg, (uint16_t)origin);
+        }
+        else
+        {
+            linker.add(module, arg);
+        }
+        has_origin = false;
+        count++;
+    }
+
+    std::cout << "Linking " << count << " objects\n";
+
+    bool linked = linker.link();
+    linker.diagnostics().print(std::cerr);
+
+    if(!linked)
+    {
+        std::cout << "Some error occured while linking\n";
+        return 1;
+    }
+
+    std::vector<uint8_t> image = linker.image();
+    if(!write_file(output_path, reinterpret_cast<char*>(image.data()), image.size()))
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
+int test(char** argv)
+{
+    lib8085::TestRunner::Options options;
+    std::vector<std::string> paths;
+
+    for(; *argv != nullptr; argv++)
+    {
+        std::string arg(*argv);
+
+        if((arg == "--max" || arg == "--threads") && argv[1])
+        {
+            unsigned long long value = std::strtoull(*(++argv), nullptr, 0);
+
+            if(arg == "--max") options.max_instructions = value;
+            else               options.threads = (unsigned)value;
+        }
+        else if(arg == "-v")
+        {
+            options.verbose = true;
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+
+    if(paths.empty())
+    {
+        std::cerr << "Expected test files to run\n";
+        return -1;
+    }
+
+    lib8085::TestRunner runner;
+    runner.run(paths, options);
+    runner.print_report(std::cout);
+
+    return runner.failure_count() ? 1 : 0;
+}
+
+int cross_check(char** argv)
+{
+    lib8085::DifferentialTester::Options options;
+
+    for(; *argv != nullptr; argv++)
+    {
+        std::string arg(*argv);
+
+        if((arg == "--cases" || arg == "--length" || arg == "--seed" || arg == "--threads" || arg == "--failures") && argv[1])
+        {
+            unsigned long long value = std::strtoull(*(++argv), nullptr, 0);
+
+            if(arg == "--cases")        options.cases = value;
+            else if(arg == "--length")  options.length = (int)std::max(1ull, value);
+            else if(arg == "--seed")    options.seed = value;
+            else if(arg == "--threads") options.threads = (unsigned)value;
+            else                        options.max_failures = (size_t)value;
+        }
+        else
+        {
+            std::cerr << "Unexpected argument \'" << arg << "\'\n";
+            return -1;
+        }
+    }
+
+    lib8085::DifferentialTester tester;
+    tester.run(options);
+    tester.print_report(std::cout);
+
+    return tester.failure_count() ? 1 : 0;
+}
+
+int exhaustive(char** argv)
+{
+    lib8085::InstructionSweep::Options options;
+
+    for(; *argv != nullptr; argv++)
+    {
+        std::string arg(*argv);
+
+        if((arg == "--threads" || arg == "--failures") && argv[1])
+        {
+            unsigned long long value = std::strtoull(*(++argv), nullptr, 0);
+
+            if(arg == "--threads") options.threads = (unsigned)value;
+            else                   options.max_reports = (size_t)value;
+        }
+        else if(arg == "--filter" && argv[1])
+        {
+            options.filter = *(++argv);
+            std::transform(options.filter.begin(), options.filter.end(), options.filter.begin(),
+                [](unsigned char c) { return (char)std::toupper(c); });
+        }
+        else
+        {
+            std::cerr << "Unexpected argument \'" << arg << "\'\n";
+            return -1;
+        }
+    }
+
+    lib8085::InstructionSweep sweep;
+    sweep.run(options);
+    sweep.print_report(std::cout);
+
+    return sweep.failure_count() ? 1 : 0;
+}
+
+int list_trace(char** argv)
+{
+    if(*argv == nullptr)
+    {
+        std::cerr << "Expected a trace file\n";
+        return -1;
+    }
+
+    const char* path = *argv;
+    uint64_t from = 0;
+    uint64_t at_cycle = UINT64_MAX;
+    uint64_t count = UINT64_MAX;
+    uint16_t memory_address = 0;
+    size_t memory_length = 0;
+
+    for(argv++; *argv != nullptr; argv++)
+    {
+        std::string arg(*argv);
+
+        if((arg == "--from" || arg == "--cycle" || arg == "--count") && argv[1])
+        {
+            unsigned long long value = std::strtoull(*(++argv), nullptr, 0);
+
+            if(arg == "--from")       from = value;
+            else if(arg == "--cycle") at_cycle = value;
+            else                      count = value;
+        }
+        else if(arg == "--memory" && argv[1] && argv[2])
+        {
+            memory_address = (uint16_t)std::strtoul(*(++argv), nullptr, 0);
+            memory_length = (size_t)std::strtoul(*(++argv), nullptr, 0);
+        }
+        else
+        {
+            std::cerr << "Unexpected argument \'" << arg << "\'\n";
+            return -1;
+        }
+    }
+
+    lib8085::TraceReader reader;
+
+    if(!reader.open(path))
+    {
+        return -1;
+    }
+
+    static const char* reg_names[8] = { "A", "F", "B", "C", "D", "E", "H", "L" };
+    lib8085::TraceRecord record;
+
+    if(!(at_cycle != UINT64_MAX ? reader.seek_cycle(at_cycle) : reader.seek(from)))
+    {
+        if(!reader.failed())
+        {
+            std::cerr << "Trace \'" << path << "\' ends before that point\n";
+            return 1;
+        }
+    }
+
+    std::cout << std::uppercase << std::setfill('0') << std::hex;
+
+    // Memory as it was before the first listed instruction
+    for(size_t i = 0; i < memory_length && !reader.failed(); i ++)
+    {
+        uint16_t address = (uint16_t)(memory_address + i);
+
+        if(i % 16 == 0)
+        {
+            std::cout << (i ? "\n" : "") << std::setw(4) << address << "H:";
+        }
+        std::cout << " " << std::setw(2) << (int)reader.memory()[address];
+    }
+    std::cout << (memory_length ? "\n" : "");
+
+    while(count && reader.next(record))
+    {
+        count--;
+
+        std::string_view name = lib8085::Isa::defined(record.opcode) ? lib8085::Isa::entry(record.opcode).mnemonic : "?";
+
+        std::cout << std::dec << record.instruction << "  " << std::hex << std::setw(4) << record.address << "H  "
+                  << std::left << std::setfill(' ') << std::setw(10)
+                  << (record.interrupt ? "interrupt" : name)
+                  << std::right << std::setfill('0') << std::dec << " +" << record.cycle_delta << std::hex;
+
+        for(int i = 0; i < 8; i ++)
+        {
+            std::cout << " " << reg_names[i] << "=" << std::setw(2) << (int)record.after.registers[i];
+        }
+        std::cout << " SP=" << std::setw(4) << record.after.stack_pointer;
+
+        for(int i = 0; i < record.write_count; i ++)
+        {
+            std::cout << "  [" << std::setw(4) << (uint16_t)(record.write_address + i) << "H]=" << std::setw(2) << (int)record.write_values[i];
+        }
+        std::cout << "\n";
+    }
+
+    std::cout << std::dec;
+
+    if(reader.failed())
+    {
+        std::cerr << "Trace \'" << path << "\' is damaged\n";
+        return -1;
+    }
+
+    return 0;
+}
+
+void print_help()
+{
+    std::cout << "-a - Assemble source code\n";
+    std::cout << "     -a <files...> [--json] [-v] [--threads N] [--obj] [--cache DIR | --no-cache]\n";
+    std::cout << "     Files are assembled in parallel and reported in the order given. Errors and warnings are printed\n";
+    std::cout << "     as file:line:column, --json prints them as one JSON document instead and -v traces every step of\n";
+    std::cout << "     the assembler. Exits with 1 when a file failed to assemble and -1 when one was empty or unreadable\n";
+    std::cout << "     --obj writes a relocatable object file.obj for -k instead of a program\n";
+    std::cout << "     --cache keeps outputs in DIR by a hash of the source and reuses them while it is unchanged,\n";
+    std::cout << "     RETRO85_CACHE sets the directory when --cache isn't given\n";
+    std::cout << "-k - Link objects into a program\n";
+    std::cout << "     -k <output> [--org ADDR] <objects...>\n";
+    std::cout << "     Labels a module doesn't define are imported from the others. --org places the next object at ADDR,\n";
+    std::cout << "     the rest follow the one before them. Exits with 1 when a symbol is undefined or sections overlap\n";
+    std::cout << "-d - Dissassemble program\n";
+    std::cout << "-r - Run program\n";
+    std::cout << "     -r <program> [--max N] [--max-cycles N] [--record log] [--replay log]\n";
+    std::cout << "        [--load-state file] [--save-state file] [--profile [--top N]] [--folded file]\n";
+    std::cout << "        [--coverage file] [--lcov file] [--trace file]\n";
+    std::cout << "     --profile reports cycles per address, label and opcode, mapped to source lines for .asm files\n";
+    std::cout << "     --folded writes cycles per call path as folded stacks for flamegraph.pl\n";
+    std::cout << "     --coverage merges executed lines and branch outcomes into file, created when missing\n";
+    std::cout << "     --lcov writes line and branch coverage of the .asm source as an lcov tracefile\n";
+    std::cout << "     --trace writes every instruction with changed registers and memory writes to a compressed binary trace\n";
+    std::cout << "     --max-cycles defaults to 4000000000, --max to no limit\n";
+    std::cout << "     Exits with 0 when the program halted and 1 when a budget ran out\n";
+    std::cout << "-s - Sweep program over initial states\n";
+    std::cout << "     -s <program> [--max N] [--threads N] [--seed N] [--outliers N] VAR=VALUES...\n";
+    std::cout << "     VAR: A-L, BC, DE, HL, SP, PC, S, Z, P, CY, AC or [address]\n";
+    std::cout << "     VALUES: 0..FFH[:step], comma separated lists, rand:N[:lo..hi] with N up to 2^24\n";
+    std::cout << "     Runs every combination of the values, at most 2^32 of them\n";
+    std::cout << "-t - Run annotated tests in parallel\n";
+    std::cout << "     -t <files...> [--max N] [--threads N] [-v]\n";
+    std::cout << "     Checks '; EXPECT: A=57H CY=0 [2000H]=12H' comments, '; SETUP:' sets the initial state\n";
+    std::cout << "     and '; MAX: N' the instruction budget. Exits with 1 when a test failed\n";
+    std::cout << "-x - Cross check the emulator against the reference model on random programs\n";
+    std::cout << "     -x [--cases N] [--length N] [--seed N] [--threads N] [--failures N]\n";
+    std::cout << "-e - Exhaustively verify every instruction against the datasheet spec and the reference model\n";
+    std::cout << "     -e [--threads N] [--filter MNEMONIC] [--failures N]\n";
+    std::cout << "-l - List instructions from a trace written by -r --trace\n";
+    std::cout << "     -l <trace> [--from N | --cycle N] [--count N] [--memory ADDRESS LENGTH]\n";
+    std::cout << "     --from and --cycle seek through the trace index, --memory dumps memory before the first listed instruction\n";
+}
+
+int main(int argc, char* argv[])
+{
+    while(*(++argv) != nullptr)
+    {
+        if(std::string(*argv) == "-a")
+        {
+            return assemble_files(argv + 1);
+        }
+        else if(std::string(*argv) == "-k")
+        {
+            return link_objects(argv + 1);
         }
         else if(std::string(*argv) == "-d")
         {
@@ -118,10 +1038,35 @@ int main(int argc, char* argv[])
                     std::cout << it->first << ": " << it->second << "\n";
                 }
             }
+            break;
+        }
+        else if(std::string(*argv) == "-r")
+        {
+            return run(argv + 1);
+        }
+        else if(std::string(*argv) == "-s")
+        {
+            return sweep(argv + 1);
+        }
+        else if(std::string(*argv) == "-t")
+        {
+            return test(argv + 1);
+        }
+        else if(std::string(*argv) == "-x")
+        {
+            return cross_check(argv + 1);
+        }
+        else if(std::string(*argv) == "-e")
+        {
+            return exhaustive(argv + 1);
+        }
+        else if(std::string(*argv) == "-l")
+        {
+            return list_trace(argv + 1);
         }
         else
         {
-            std::cout << "Unknown command \'" << *argv << (*argv == "-a" ? "yes" : "no") << "\'\n";
+            std::cout << "Unknown command \'" << *argv << "\'\n";
             print_help();
             return -1;
         }
@@ -0,0 +1,289 @@
+#include "coverage.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+namespace lib8085
+{
+    static const char _coverage_magic[4] = { 'R', '8', '5', 'C' };
+    static const uint8_t _coverage_version = 1;
+
+    static size_t count_bits(const std::vector<uint64_t>& bitmap)
+    {
+        size_t count = 0;
+
+        for(uint64_t word : bitmap)
+        {
+            for(; word; word &= word - 1)
+            {
+                count++;
+            }
+        }
+
+        return count;
+    }
+
+    static double percent(size_t part, size_t whole)
+    {
+        return whole ? part * 100.0 / whole : 100.0;
+    }
+
+    Coverage::Coverage() : _executed(WORD_COUNT), _taken(WORD_COUNT), _not_taken(WORD_COUNT)
+    {
+    }
+
+    void Coverage::reset()
+    {
+        std::fill(_executed.begin(), _executed.end(), 0);
+        std::fill(_taken.begin(), _taken.end(), 0);
+        std::fill(_not_taken.begin(), _not_taken.end(), 0);
+    }
+
+    void Coverage::merge(const Coverage& other)
+    {
+        for(size_t i = 0; i < WORD_COUNT; i ++)
+        {
+            _executed[i] |= other._executed[i];
+            _taken[i] |= other._taken[i];
+            _not_taken[i] |= other._not_taken[i];
+        }
+    }
+
+    bool Coverage::executed(uint16_t address) const
+    {
+        return (_executed[address >> 6] >> (address & 63)) & 1;
+    }
+
+    bool Coverage::taken(uint16_t address) const
+    {
+        return (_taken[address >> 6] >> (address & 63)) & 1;
+    }
+
+    bool Coverage::not_taken(uint16_t address) const
+    {
+        return (_not_taken[address >> 6] >> (address & 63)) & 1;
+    }
+
+    size_t Coverage::executed_count() const
+    {
+        return count_bits(_executed);
+    }
+
+    bool Coverage::save(const char* path) const
+    {
+        std::ofstream file(path, std::ios::out | std::ios::binary);
+
+        if(!file.good() || !file.is_open())
+        {
+            std::cerr << "Error writing coverage \'" << path << "\'\n";
+            return false;
+        }
+
+        file.write(_coverage_magic, sizeof(_coverage_magic));
+        file.write(reinterpret_cast<const char*>(&_coverage_version), 1);
+
+        // Little endian words, executed then taken then not taken
+        for(const std::vector<uint64_t>* bitmap : { &_executed, &_taken, &_not_taken })
+        {
+            for(uint64_t word : *bitmap)
+            {
+                for(int i = 0; i < 8; i ++)
+                {
+                    file.put((char)(word >> (i * 8)));
+                }
+            }
+        }
+
+        return file.good();
+    }
+
+    bool Coverage::load(const char* path)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+
+        if(!file.good() || !file.is_open())
+        {
+            std::cerr << "Error reading coverage \'" << path << "\'\n";
+            return false;
+        }
+
+        char header[5];
+        file.read(header, sizeof(header));
+
+        if(!file.good()
+                || !std::equal(_coverage_magic, _coverage_magic + 4, header)
+                || (uint8_t)header[4] != _coverage_version)
+        {
+            std::cerr << "\'" << path << "\' is not a supported coverage file\n";
+            return false;
+        }
+
+        std::vector<uint8_t> data(WORD_COUNT * 8 * 3);
+        file.read(reinterpret_cast<char*>(data.data()), data.size());
+
+        if((size_t)file.gcount() != data.size())
+        {
+            std::cerr << "\'" << path << "\' is truncated\n";
+            return false;
+        }
+
+        const uint8_t* p = data.data();
+        for(std::vector<uint64_t>* bitmap : { &_executed, &_taken, &_not_taken })
+        {
+            for(uint64_t& word : *bitmap)
+            {
+                word = 0;
+                for(int i = 0; i < 8; i ++)
+                {
+                    word |= (uint64_t)*p++ << (i * 8);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    void Coverage::print_report(std::ostream& out, const SourceMap& source) const
+    {
+        if(source.lines().empty())
+        {
+            out << "Addresses executed: " << executed_count() << "\n";
+            return;
+        }
+
+        const std::vector<uint8_t>& program = source.program();
+        size_t lines = 0, lines_hit = 0, branches = 0, branches_hit = 0;
+        std::vector<std::string> missed_lines, missed_branches;
+
+        for(const auto& it : source.lines())
+        {
+            uint16_t address = it.first;
+            int line = it.second;
+            std::string prefix = "  " + std::to_string(line) + "  " + source.text(line);
+
+            lines++;
+            if(executed(address))
+            {
+                lines_hit++;
+            }
+            else
+            {
+                missed_lines.push_back(prefix);
+            }
+
+            if(address >= program.size() || !branch_length(program[address]))
+            {
+                continue;
+            }
+
+            branches += 2;
+            branches_hit += (taken(address) ? 1 : 0) + (not_taken(address) ? 1 : 0);
+
+            if(executed(address) && !(taken(address) && not_taken(address)))
+            {
+                missed_branches.push_back(prefix + (taken(address) ? "  (never fell through)" : "  (never taken)"));
+            }
+        }
+
+        out << std::fixed << std::setprecision(1)
+            << "Lines: " << lines_hit << " of " << lines << " (" << percent(lines_hit, lines) << "%)\n"
+            << "Branches: " << branches_hit << " of " << branches << " outcomes (" << percent(branches_hit, branches) << "%)\n";
+        out.unsetf(std::ios_base::fixed);
+
+        if(!missed_lines.empty())
+        {
+            out << "Lines not executed:\n";
+            for(const std::string& l : missed_lines)
+            {
+                out << l << "\n";
+            }
+        }
+
+        if(!missed_branches.empty())
+        {
+            out << "Branches with one outcome:\n";
+            for(const std::string& l : missed_branches)
+            {
+                out << l << "\n";
+            }
+        }
+    }
+
+    void Coverage::write_lcov(std::ostream& out, const SourceMap& source, const std::string& source_path) const
+    {
+        const std::vector<uint8_t>& program = source.program();
+        size_t lines = 0, lines_hit = 0, branches = 0, branches_hit = 0;
+
+        out << "TN:\n";
+        out << "SF:" << source_path << "\n";
+
+        // Labels stand in for functions
+        for(const auto& it : source.labels())
+        {
+            int line = source.line(it.first);
+            if(line)
+            {
+                out << "FN:" << line << "," << it.second << "\n";
+            }
+        }
+        size_t functions = 0, functions_hit = 0;
+        for(const auto& it : source.labels())
+        {
+            if(source.line(it.first))
+            {
+                out << "FNDA:" << (executed(it.first) ? 1 : 0) << "," << it.second << "\n";
+                functions++;
+                functions_hit += executed(it.first) ? 1 : 0;
+            }
+        }
+        out << "FNF:" << functions << "\n";
+        out << "FNH:" << functions_hit << "\n";
+
+        for(const auto& it : source.lines())
+        {
+            uint16_t address = it.first;
+            int line = it.second;
+
+            if(address >= program.size() || !branch_length(program[address]))
+            {
+                continue;
+            }
+
+            // Branch 0 is taken, branch 1 falls through, "-" when the line never ran
+            for(int b = 0; b < 2; b ++)
+            {
+                bool hit = b == 0 ? taken(address) : not_taken(address);
+
+                out << "BRDA:" << line << ",0," << b << ",";
+                if(executed(address))
+                {
+                    out << (hit ? 1 : 0);
+                }
+                else
+                {
+                    out << "-";
+                }
+                out << "\n";
+
+                branches++;
+                branches_hit += hit ? 1 : 0;
+            }
+        }
+        out << "BRF:" << branches << "\n";
+        out << "BRH:" << branches_hit << "\n";
+
+        for(const auto& it : source.lines())
+        {
+            bool hit = executed(it.first);
+
+            out << "DA:" << it.second << "," << (hit ? 1 : 0) << "\n";
+            lines++;
+            lines_hit += hit ? 1 : 0;
+        }
+        out << "LF:" << lines << "\n";
+        out << "LH:" << lines_hit << "\n";
+        out << "end_of_record\n";
+    }
+}
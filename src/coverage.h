@@ -0,0 +1,80 @@
+#pragma once
+#include "instruction_set.h"
+#include "source_map.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Code coverage as bitmaps over the address space: which addresses started
+     * an instruction, and which conditional jumps, calls and returns were seen
+     * taken and not taken.
+     *
+     * Attach to a Processor with attach_coverage, run() then sets the bits for
+     * every instruction. Bitmaps from any number of runs merge with a bitwise
+     * or, and are saved in a small file so separate runs can accumulate.
+     * Reports map addresses back to source lines, as text or as lcov tracefile.
+     *
+     */
+    class Coverage
+    {
+        public:
+            static const size_t WORD_COUNT = (1 << 16) / 64;
+
+            Coverage();
+
+            // Instruction length of conditional branches, 0 for everything else
+            static int branch_length(uint8_t opcode)
+            {
+                switch(opcode)
+                {
+                    case JC: case JNC: case JZ: case JNZ: case JP: case JM: case JPE: case JPO:
+                    case CC: case CNC: case CZ: case CNZ: case CP: case CM: case CPE: case CPO:
+                        return 3;
+                    case RC: case RNC: case RZ: case RNZ: case RP: case RM: case RPE: case RPO:
+                        return 1;
+                }
+                return 0;
+            }
+
+            // next is the program counter after the instruction
+            void record(uint16_t address, uint8_t opcode, uint16_t next)
+            {
+                uint64_t bit = 1ull << (address & 63);
+                size_t word = address >> 6;
+
+                _executed[word] |= bit;
+
+                int length = branch_length(opcode);
+                if(length)
+                {
+                    (next == (uint16_t)(address + length) ? _not_taken : _taken)[word] |= bit;
+                }
+            }
+
+            void reset();
+            void merge(const Coverage& other);
+
+            bool executed(uint16_t address) const;
+            bool taken(uint16_t address) const;
+            bool not_taken(uint16_t address) const;
+            size_t executed_count() const;
+
+            bool save(const char* path) const;
+            bool load(const char* path);
+
+            // Line and branch summary with the lines and branches that were missed
+            void print_report(std::ostream& out, const SourceMap& source) const;
+            // lcov tracefile for source_path, DA hit counts are 0 or 1
+            void write_lcov(std::ostream& out, const SourceMap& source, const std::string& source_path) const;
+
+        private:
+            std::vector<uint64_t> _executed;
+            std::vector<uint64_t> _taken;
+            std::vector<uint64_t> _not_taken;
+    };
+}
@@ -0,0 +1,273 @@
+#include "diagnostics.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+
+namespace lib8085
+{
+    static const char* severity_name(Severity severity)
+    {
+        switch(severity)
+        {
+            case SEVERITY_NOTE:
+                return "note";
+            case SEVERITY_WARNING:
+                return "warning";
+            default:
+                return "error";
+        }
+    }
+
+    // Length of the well formed UTF-8 sequence at str[i], 0 when the bytes there aren't one
+    static size_t utf8_sequence_length(const std::string& str, size_t i)
+    {
+        unsigned char lead = (unsigned char)str[i];
+        size_t length;
+        uint32_t code_point;
+
+        if(lead < 0x80)
+        {
+            return 1;
+        }
+        else if(lead >= 0xc2 && lead <= 0xdf)
+        {
+            length = 2;
+            code_point = lead & 0x1f;
+        }
+        else if(lead >= 0xe0 && lead <= 0xef)
+        {
+            length = 3;
+            code_point = lead & 0x0f;
+        }
+        else if(lead >= 0xf0 && lead <= 0xf4)
+        {
+            length = 4;
+            code_point = lead & 0x07;
+        }
+        else
+        {
+            return 0;
+        }
+
+        if(i + length > str.size())
+        {
+            return 0;
+        }
+
+        for(size_t k = 1; k < length; k ++)
+        {
+            unsigned char b = (unsigned char)str[i + k];
+
+            if((b & 0xc0) != 0x80)
+            {
+                return 0;
+            }
+            code_point = (code_point << 6) | (b & 0x3f);
+        }
+
+        // Overlong forms, surrogates and code points past U+10FFFF
+        if((length == 3 && code_point < 0x800) || (length == 4 && code_point < 0x10000)
+                || (code_point >= 0xd800 && code_point <= 0xdfff) || code_point > 0x10ffff)
+        {
+            return 0;
+        }
+
+        return length;
+    }
+
+    // Source lines aren't necessarily UTF-8, bytes that don't form a valid sequence become U+FFFD
+    static void write_json_string(std::ostream& out, const std::string& str)
+    {
+        out << '"';
+        for(size_t i = 0; i < str.size(); i ++)
+        {
+            char c = str[i];
+
+            if((unsigned char)c >= 0x80)
+            {
+                size_t length = utf8_sequence_length(str, i);
+
+                if(length == 0)
+                {
+                    out << "\\ufffd";
+                }
+                else
+                {
+                    out.write(str.data() + i, length);
+                    i += length - 1;
+                }
+                continue;
+            }
+
+            switch(c)
+            {
+                case '"':
+                    out << "\\\"";
+                    break;
+                case '\\':
+                    out << "\\\\";
+                    break;
+                case '\n':
+                    out << "\\n";
+                    break;
+                case '\r':
+                    out << "\\r";
+                    break;
+                case '\t':
+                    out << "\\t";
+                    break;
+                default:
+                    if((unsigned char)c < 0x20)
+                    {
+                        char escaped[8];
+                        std::snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned char)c);
+                        out << escaped;
+                    }
+                    else
+                    {
+                        out << c;
+                    }
+                    break;
+            }
+        }
+        out << '"';
+    }
+
+    Diagnostics::Diagnostics() : _max_errors(DEFAULT_MAX_ERRORS), _errors(0), _warnings(0)
+    {
+    }
+
+    void Diagnostics::set_file(const std::string& file)
+    {
+        _file = file;
+    }
+
+    void Diagnostics::set_max_errors(size_t max_errors)
+    {
+        _max_errors = max_errors;
+    }
+
+    void Diagnostics::report(Severity severity, const char* code, int line, int column, const std::string& message)
+    {
+        if(full())
+        {
+            return;
+        }
+
+        _entries.push_back(Diagnostic{ severity, code, _file, line, column, message });
+
+        if(severity == SEVERITY_ERROR)
+        {
+            _errors++;
+
+            if(full())
+            {
+                _entries.push_back(Diagnostic{ SEVERITY_NOTE, code, _file, line, column, "Too many errors, stopping" });
+            }
+        }
+        else if(severity == SEVERITY_WARNING)
+        {
+            _warnings++;
+        }
+    }
+
+    void Diagnostics::error(const char* code, int line, int column, const std::string& message)
+    {
+        report(SEVERITY_ERROR, code, line, column, message);
+    }
+
+    void Diagnostics::warning(const char* code, int line, int column, const std::string& message)
+    {
+        report(SEVERITY_WARNING, code, line, column, message);
+    }
+
+    void Diagnostics::clear()
+    {
+        _entries.clear();
+        _errors = 0;
+        _warnings = 0;
+    }
+
+    void Diagnostics::sort()
+    {
+        auto position = [](const Diagnostic& d)
+        {
+            return std::make_pair(d.line ? d.line : INT_MAX, d.column);
+        };
+
+        std::stable_sort(_entries.begin(), _entries.end(), [&position](const Diagnostic& a, const Diagnostic& b)
+        {
+            return position(a) < position(b);
+        });
+    }
+
+    void Diagnostics::merge(const Diagnostics& other)
+    {
+        _entries.insert(_entries.end(), other._entries.begin(), other._entries.end());
+        _errors += other._errors;
+        _warnings += other._warnings;
+    }
+
+    const std::vector<Diagnostic>& Diagnostics::entries() const
+    {
+        return _entries;
+    }
+
+    size_t Diagnostics::error_count() const
+    {
+        return _errors;
+    }
+
+    size_t Diagnostics::warning_count() const
+    {
+        return _warnings;
+    }
+
+    bool Diagnostics::has_errors() const
+    {
+        return _errors > 0;
+    }
+
+    bool Diagnostics::full() const
+    {
+        return _max_errors && _errors >= _max_errors;
+    }
+
+    void Diagnostics::print(std::ostream& out) const
+    {
+        for(const Diagnostic& d : _entries)
+        {
+            if(!d.file.empty())
+            {
+                out << d.file << ":";
+            }
+            if(d.line)
+            {
+                out << d.line << ":" << d.column << ":";
+            }
+            out << (d.file.empty() && !d.line ? "" : " ") << severity_name(d.severity) << " " << d.code << ": " << d.message << "\n";
+        }
+    }
+
+    void Diagnostics::write_json(std::ostream& out) const
+    {
+        out << "{\"errors\":" << _errors << ",\"warnings\":" << _warnings << ",\"diagnostics\":[";
+
+        for(size_t i = 0; i < _entries.size(); i ++)
+        {
+            const Diagnostic& d = _entries[i];
+
+            out << (i ? "," : "") << "{\"severity\":\"" << severity_name(d.severity) << "\",\"code\":";
+            write_json_string(out, d.code);
+            out << ",\"file\":";
+            write_json_string(out, d.file);
+            out << ",\"line\":" << d.line << ",\"column\":" << d.column << ",\"message\":";
+            write_json_string(out, d.message);
+            out << "}";
+        }
+
+        out << "]}\n";
+    }
+}
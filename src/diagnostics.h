@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    enum Severity
+    {
+        SEVERITY_NOTE,
+        SEVERITY_WARNING,
+        SEVERITY_ERROR
+    };
+
+    struct Diagnostic
+    {
+        Severity severity = SEVERITY_ERROR;
+        // Stable identifier tools can match on, A0xx for the assembler, D0xx for the disassembler
+        std::string code;
+        std::string file;
+        // 1 based, 0 when the diagnostic isn't tied to a source position
+        int line = 0;
+        int column = 0;
+        std::string message;
+    };
+
+    /*
+     * Collects what the assembler finds wrong with a source instead of printing
+     * it, nothing is written until the caller asks for text or JSON. Reporting
+     * keeps going after errors so one pass finds all of them, up to
+     * max_errors after which a note says the rest were dropped.
+     *
+     */
+    class Diagnostics
+    {
+        public:
+            static const size_t DEFAULT_MAX_ERRORS = 100;
+
+            Diagnostics();
+
+            // File name stamped on diagnostics reported after this
+            void set_file(const std::string& file);
+            void set_max_errors(size_t max_errors);
+
+            void report(Severity severity, const char* code, int line, int column, const std::string& message);
+            void error(const char* code, int line, int column, const std::string& message);
+            void warning(const char* code, int line, int column, const std::string& message);
+
+            void clear();
+            // Orders by line and column, diagnostics without a position go last
+            void sort();
+            // Appends the diagnostics of another collector, counts included
+            void merge(const Diagnostics& other);
+
+            const std::vector<Diagnostic>& entries() const;
+            size_t error_count() const;
+            size_t warning_count() const;
+            bool has_errors() const;
+            // True once max_errors errors were reported, callers may stop early
+            bool full() const;
+
+            // One "file:line:column: error A002: message" line per diagnostic
+            void print(std::ostream& out) const;
+            // {"errors":N,"warnings":N,"diagnostics":[{...}]}
+            void write_json(std::ostream& out) const;
+
+        private:
+            std::vector<Diagnostic> _entries;
+            std::string _file;
+            size_t _max_errors;
+            size_t _errors;
+            size_t _warnings;
+    };
+}
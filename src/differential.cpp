@@ -0,0 +1,521 @@
+#include "differential.h"
+#include "isa.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace lib8085
+{
+    // Opcodes are the enum values, XTHL is the last one
+    static const int OPCODE_COUNT = XTHL + 1;
+
+    // splitmix64, cheap to seed per case
+    struct CaseRandom
+    {
+        uint64_t state;
+
+        explicit CaseRandom(uint64_t seed) : state(seed)
+        {
+        }
+
+        uint64_t next()
+        {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+    };
+
+    static bool is_branch(uint8_t opcode)
+    {
+        switch(opcode)
+        {
+            case JMP: case JC: case JNC: case JZ: case JNZ: case JP: case JM: case JPE: case JPO:
+            case CALL: case CC: case CNC: case CZ: case CNZ: case CP: case CM: case CPE: case CPO:
+                return true;
+        }
+        return false;
+    }
+
+    static void fill_page(uint64_t seed, uint8_t page, uint8_t* data)
+    {
+        CaseRandom rng(seed + page);
+
+        for(size_t i = 0; i < MEM_PAGE_SIZE; i += 8)
+        {
+            uint64_t v = rng.next();
+            std::memcpy(data + i, &v, 8);
+        }
+    }
+
+    static std::string hex(unsigned value, int width)
+    {
+        std::stringstream ss;
+        ss << std::hex << std::uppercase << std::setfill('0') << std::setw(width) << value << "H";
+        return ss.str();
+    }
+
+    DifferentialTester::Case DifferentialTester::generate(uint64_t seed, uint64_t index, int length)
+    {
+        CaseRandom rng(seed * 0x100000001b3ull ^ (index + 1) * 0x9e3779b97f4a7c15ull);
+        Case c;
+
+        c.index = index;
+        // Page aligned and low enough for the longest possible sequence to fit
+        uint32_t pages = (0x10000 - std::min(length * 3, 0xff00)) >> 8;
+        c.base = (uint16_t)((rng.next() % pages) << 8);
+
+        uint64_t r = rng.next();
+        for(int i = 0; i < 8; i ++)
+        {
+            c.regs[i] = (uint8_t)(r >> (i * 8));
+        }
+        c.regs[R_M] = 0;
+
+        r = rng.next();
+        c.flags = (uint8_t)((r & 0xd5) | 0x02);
+        c.sp = (uint16_t)(r >> 8);
+        c.interrupt_enable = (r >> 24) & 1;
+        c.interrupt_mask = (r >> 25) & 0x07;
+
+        for(int i = 0; i < length; i ++)
+        {
+            r = rng.next();
+
+            Instruction ins;
+            ins.bytes[0] = (uint8_t)(r % OPCODE_COUNT);
+            ins.bytes[1] = (uint8_t)(r >> 16);
+            ins.bytes[2] = (uint8_t)(r >> 24);
+            ins.length = ReferenceCpu::length(ins.bytes[0]);
+            ins.target = -1;
+
+            // Most branches stay inside the sequence so it keeps running generated code
+            if(is_branch(ins.bytes[0]) && ((r >> 32) & 3) != 0)
+            {
+                ins.target = (int)((r >> 40) % (length + 1));
+            }
+
+            c.program.push_back(ins);
+        }
+
+        // Give loads something other than zeroes to read
+        uint16_t pointers[] = { c.sp, (uint16_t)(c.sp - 1),
+            (uint16_t)((c.regs[R_B] << 8) | c.regs[R_C]),
+            (uint16_t)((c.regs[R_D] << 8) | c.regs[R_E]),
+            (uint16_t)((c.regs[R_H] << 8) | c.regs[R_L]) };
+
+        for(uint16_t p : pointers)
+        {
+            uint8_t page = p >> 8;
+            if(std::find(c.data_pages.begin(), c.data_pages.end(), page) == c.data_pages.end())
+            {
+                c.data_pages.push_back(page);
+            }
+        }
+
+        c.data_seed = rng.next();
+        c.steps = length * 2;
+
+        return c;
+    }
+
+    std::vector<uint8_t> DifferentialTester::layout(const Case& c)
+    {
+        std::vector<uint16_t> offsets;
+        uint16_t offset = 0;
+
+        for(const Instruction& ins : c.program)
+        {
+            offsets.push_back(offset);
+            offset += ins.length;
+        }
+        offsets.push_back(offset);
+
+        std::vector<uint8_t> code;
+
+        for(const Instruction& ins : c.program)
+        {
+            uint8_t bytes[3] = { ins.bytes[0], ins.bytes[1], ins.bytes[2] };
+
+            if(ins.target >= 0)
+            {
+                uint16_t address = c.base + offsets[ins.target];
+                bytes[1] = address & 0xff;
+                bytes[2] = address >> 8;
+            }
+
+            code.insert(code.end(), bytes, bytes + ins.length);
+        }
+
+        return code;
+    }
+
+    bool DifferentialTester::compare_state(const Processor& cpu, const ReferenceCpu& ref, std::string& message)
+    {
+        struct Field
+        {
+            const char* name;
+            unsigned expected, actual;
+            int width;
+        };
+
+        const Field fields[] = {
+            { "A",  ref.regs[R_A], cpu.reg_a, 2 }, { "B",  ref.regs[R_B], cpu.reg_b, 2 },
+            { "C",  ref.regs[R_C], cpu.reg_c, 2 }, { "D",  ref.regs[R_D], cpu.reg_d, 2 },
+            { "E",  ref.regs[R_E], cpu.reg_e, 2 }, { "H",  ref.regs[R_H], cpu.reg_h, 2 },
+            { "L",  ref.regs[R_L], cpu.reg_l, 2 }, { "FLAGS", ref.flags, cpu.get_flags(), 2 },
+            { "PC", ref.pc, cpu.program_counter, 4 }, { "SP", ref.sp, cpu.stack_pointer, 4 },
+            { "IE", ref.interrupt_enable, cpu.interrupt_enable, 1 },
+            { "MASK", ref.interrupt_mask, (unsigned)(cpu.interrupt_mask & 0x07), 1 },
+            { "SOD", ref.serial_output, cpu.serial_output, 1 },
+            { "HALTED", ref.halted, cpu.halted, 1 },
+        };
+
+        for(const Field& f : fields)
+        {
+            if(f.expected != f.actual)
+            {
+                message += std::string(message.empty() ? "" : ", ") + f.name + " expected "
+                    + hex(f.expected, f.width) + " got " + hex(f.actual, f.width);
+            }
+        }
+
+        if(ref.cycles != cpu.cycles)
+        {
+            message += std::string(message.empty() ? "" : ", ") + "cycles expected "
+                + std::to_string(ref.cycles) + " got " + std::to_string(cpu.cycles);
+        }
+
+        for(int i = 0; i < ref.write_count; i ++)
+        {
+            uint8_t actual = cpu.read_mem(ref.writes[i].address);
+
+            if(actual != ref.writes[i].value)
+            {
+                message += std::string(message.empty() ? "" : ", ") + "[" + hex(ref.writes[i].address, 4) + "] expected "
+                    + hex(ref.writes[i].value, 2) + " got " + hex(actual, 2);
+            }
+        }
+
+        return message.empty();
+    }
+
+    static bool compare_memory(const Processor& cpu, const ReferenceCpu& ref, std::string& message)
+    {
+        for(size_t page = 0; page < MEM_PAGE_COUNT; page ++)
+        {
+            const uint8_t* data = cpu.get_page(page);
+            const uint8_t* expected = ref.page((int)page);
+
+            if(std::memcmp(data, expected, MEM_PAGE_SIZE) == 0)
+            {
+                continue;
+            }
+
+            for(size_t i = 0; i < MEM_PAGE_SIZE; i ++)
+            {
+                if(data[i] != expected[i])
+                {
+                    message = "[" + hex((unsigned)(page * MEM_PAGE_SIZE + i), 4) + "] expected " + hex(expected[i], 2) + " got " + hex(data[i], 2);
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }
+
+    int DifferentialTester::check(const Case& c, Processor& cpu, ReferenceCpu& ref, std::string& message)
+    {
+        cpu.reset();
+        ref.reset();
+        ref.clear_memory();
+
+        uint8_t page_data[MEM_PAGE_SIZE];
+
+        for(uint8_t page : c.data_pages)
+        {
+            fill_page(c.data_seed, page, page_data);
+            cpu.load_memory((uint16_t)(page << 8), page_data, MEM_PAGE_SIZE);
+
+            for(size_t i = 0; i < MEM_PAGE_SIZE; i ++)
+            {
+                ref.write((uint16_t)((page << 8) + i), page_data[i]);
+            }
+        }
+
+        std::vector<uint8_t> code = layout(c);
+        cpu.load_memory(c.base, code.data(), code.size());
+
+        for(size_t i = 0; i < code.size(); i ++)
+        {
+            ref.write((uint16_t)(c.base + i), code[i]);
+        }
+
+        cpu.reg_a = c.regs[R_A];
+        cpu.reg_b = c.regs[R_B];
+        cpu.reg_c = c.regs[R_C];
+        cpu.reg_d = c.regs[R_D];
+        cpu.reg_e = c.regs[R_E];
+        cpu.reg_h = c.regs[R_H];
+        cpu.reg_l = c.regs[R_L];
+        cpu.set_flags(c.flags);
+        cpu.stack_pointer = c.sp;
+        cpu.program_counter = c.base;
+        cpu.interrupt_enable = c.interrupt_enable;
+        cpu.interrupt_mask = c.interrupt_mask;
+
+        std::memcpy(ref.regs, c.regs, sizeof(ref.regs));
+        ref.flags = c.flags;
+        ref.sp = c.sp;
+        ref.pc = c.base;
+        ref.interrupt_enable = c.interrupt_enable;
+        ref.interrupt_mask = c.interrupt_mask;
+
+        message.clear();
+
+        for(int step = 0; step < c.steps; step ++)
+        {
+            cpu.step();
+            ref.step();
+
+            if(!compare_state(cpu, ref, message))
+            {
+                return step;
+            }
+        }
+
+        if(!compare_memory(cpu, ref, message))
+        {
+            return c.steps - 1;
+        }
+
+        return -1;
+    }
+
+    DifferentialTester::Case DifferentialTester::minimise(const Case& c, Processor& cpu, ReferenceCpu& ref)
+    {
+        std::string message;
+        Case best = c;
+
+        int step = check(best, cpu, ref, message);
+        if(step < 0)
+        {
+            return best;
+        }
+        best.steps = step + 1;
+
+        // Keeps a candidate if it still diverges, with the steps cut to the divergence
+        auto try_case = [&](Case& candidate) -> bool
+        {
+            int s = check(candidate, cpu, ref, message);
+            if(s < 0)
+            {
+                return false;
+            }
+
+            candidate.steps = s + 1;
+            best = candidate;
+            return true;
+        };
+
+        // Simpler state can make more instructions removable, so repeat until nothing changes
+        bool changed = true;
+        while(changed)
+        {
+            changed = false;
+
+            for(size_t i = best.program.size(); i-- > 0;)
+            {
+                Case candidate = best;
+                candidate.program.erase(candidate.program.begin() + i);
+
+                // Branches into the removed instruction now land on the one after it
+                for(Instruction& ins : candidate.program)
+                {
+                    if(ins.target > (int)i)
+                    {
+                        ins.target--;
+                    }
+                }
+
+                changed |= try_case(candidate);
+            }
+
+            for(int r = 0; r < 8; r ++)
+            {
+                if(best.regs[r] != 0)
+                {
+                    Case candidate = best;
+                    candidate.regs[r] = 0;
+                    changed |= try_case(candidate);
+                }
+            }
+
+            if(best.flags != 0x02)
+            {
+                Case candidate = best;
+                candidate.flags = 0x02;
+                changed |= try_case(candidate);
+            }
+
+            if(best.interrupt_enable || best.interrupt_mask != 0x07)
+            {
+                Case candidate = best;
+                candidate.interrupt_enable = false;
+                candidate.interrupt_mask = 0x07;
+                changed |= try_case(candidate);
+            }
+
+            for(size_t i = best.data_pages.size(); i-- > 0;)
+            {
+                Case candidate = best;
+                candidate.data_pages.erase(candidate.data_pages.begin() + i);
+                changed |= try_case(candidate);
+            }
+        }
+
+        return best;
+    }
+
+    void DifferentialTester::run(const Options& options)
+    {
+        _options = options;
+        _failures.clear();
+
+        unsigned threads = options.threads ? options.threads : default_thread_count();
+
+        std::vector<std::unique_ptr<Processor>> cpus(threads);
+        std::vector<std::unique_ptr<ReferenceCpu>> refs(threads);
+        std::atomic<uint64_t> failures(0);
+        std::mutex mutex;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        parallel_for(options.cases, [&](size_t index, unsigned worker)
+        {
+            if(!cpus[worker])
+            {
+                cpus[worker].reset(new Processor());
+                refs[worker].reset(new ReferenceCpu());
+            }
+
+            Processor& cpu = *cpus[worker];
+            ReferenceCpu& ref = *refs[worker];
+
+            Case c = generate(options.seed, index, options.length);
+            std::string message;
+
+            if(check(c, cpu, ref, message) < 0)
+            {
+                return;
+            }
+
+            // Only the first few failures are worth minimising
+            if(failures.fetch_add(1) >= options.max_failures)
+            {
+                return;
+            }
+
+            Failure f;
+            f.original = c;
+            f.minimal = minimise(c, cpu, ref);
+            f.step = check(f.minimal, cpu, ref, f.message);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            _failures.push_back(f);
+        }, threads);
+
+        _elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        _cases_run = options.cases;
+        _failure_count = failures.load();
+
+        std::sort(_failures.begin(), _failures.end(), [](const Failure& a, const Failure& b)
+        {
+            return a.original.index < b.original.index;
+        });
+    }
+
+    void DifferentialTester::print_case(const Case& c, std::ostream& out)
+    {
+        static const char* reg_names[8] = { "B", "C", "D", "E", "H", "L", "M", "A" };
+
+        out << "  Initial:";
+        for(int r = 0; r < 8; r ++)
+        {
+            if(r != R_M)
+            {
+                out << " " << reg_names[r] << "=" << hex(c.regs[r], 2);
+            }
+        }
+        out << " FLAGS=" << hex(c.flags, 2) << " SP=" << hex(c.sp, 4)
+            << " IE=" << c.interrupt_enable << " MASK=" << (int)c.interrupt_mask << "\n";
+
+        out << "  Data pages:";
+        for(uint8_t page : c.data_pages)
+        {
+            out << " " << hex(page << 8, 4);
+        }
+        out << " (seed " << c.data_seed << ")\n";
+
+        std::vector<uint8_t> code = layout(c);
+        size_t offset = 0;
+
+        for(const Instruction& ins : c.program)
+        {
+            out << "  " << hex((unsigned)(c.base + offset), 4) << "  "
+                << (Isa::defined(code[offset]) ? Isa::entry(code[offset]).mnemonic : "?");
+
+            if(ins.length == 2)
+            {
+                out << " " << hex(code[offset + 1], 2);
+            }
+            else if(ins.length == 3)
+            {
+                out << " " << hex((unsigned)(code[offset + 1] | (code[offset + 2] << 8)), 4);
+            }
+            out << "\n";
+
+            offset += ins.length;
+        }
+    }
+
+    void DifferentialTester::print_report(std::ostream& out) const
+    {
+        out << "Cases: " << _cases_run << ", failed: " << _failure_count
+            << ", " << std::fixed << std::setprecision(2) << _elapsed << " s ("
+            << std::setprecision(0) << (_elapsed > 0 ? _cases_run / _elapsed * 60.0 : 0.0) << " cases/min)\n";
+        out.unsetf(std::ios_base::fixed);
+
+        for(const Failure& f : _failures)
+        {
+            out << "\nCase " << f.original.index << " (seed " << _options.seed << ", length " << f.original.program.size()
+                << ") minimised to " << f.minimal.program.size() << " instructions\n";
+            print_case(f.minimal, out);
+            out << "  Diverged at step " << f.step << ": " << f.message << "\n";
+        }
+    }
+
+    uint64_t DifferentialTester::cases_run() const
+    {
+        return _cases_run;
+    }
+
+    uint64_t DifferentialTester::failure_count() const
+    {
+        return _failure_count;
+    }
+
+    const std::vector<DifferentialTester::Failure>& DifferentialTester::failures() const
+    {
+        return _failures;
+    }
+}
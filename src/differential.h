@@ -0,0 +1,91 @@
+#pragma once
+#include "lib8085.h"
+#include "reference_cpu.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Differential tester, runs random instruction sequences on Processor and on
+     * ReferenceCpu and compares the complete visible state after every step.
+     *
+     * Each case is derived from (seed, case index) only, so any failure can be
+     * reproduced on its own. Failing cases are minimised by dropping instructions
+     * and zeroing initial state for as long as the mismatch remains.
+     *
+     */
+    class DifferentialTester
+    {
+        public:
+            struct Options
+            {
+                uint64_t cases = 100000;
+                int length = 32;
+                uint64_t seed = 1;
+                unsigned threads = 0;
+                size_t max_failures = 5;
+            };
+
+            struct Instruction
+            {
+                uint8_t bytes[3];
+                int length;
+                // Index of the instruction a jump or call targets, -1 for raw operands
+                int target;
+            };
+
+            struct Case
+            {
+                uint64_t index = 0;
+                uint16_t base = 0;
+                uint8_t regs[8] = {};
+                uint8_t flags = 0;
+                uint16_t sp = 0;
+                bool interrupt_enable = false;
+                uint8_t interrupt_mask = 0;
+                std::vector<Instruction> program;
+                // Pages filled with random data before the run
+                std::vector<uint8_t> data_pages;
+                uint64_t data_seed = 0;
+                int steps = 0;
+            };
+
+            struct Failure
+            {
+                Case original;
+                Case minimal;
+                int step;
+                std::string message;
+            };
+
+            void run(const Options& options);
+            void print_report(std::ostream& out) const;
+
+            uint64_t cases_run() const;
+            uint64_t failure_count() const;
+            const std::vector<Failure>& failures() const;
+
+            static Case generate(uint64_t seed, uint64_t index, int length);
+
+            // Returns the step that diverged or -1, message describes the difference
+            static int check(const Case& c, Processor& cpu, ReferenceCpu& ref, std::string& message);
+            static Case minimise(const Case& c, Processor& cpu, ReferenceCpu& ref);
+
+            // Registers, flags, control state, cycles and the last step's writes
+            static bool compare_state(const Processor& cpu, const ReferenceCpu& ref, std::string& message);
+
+            static std::vector<uint8_t> layout(const Case& c);
+            static void print_case(const Case& c, std::ostream& out);
+
+        private:
+            Options _options;
+            uint64_t _cases_run = 0;
+            uint64_t _failure_count = 0;
+            double _elapsed = 0;
+            std::vector<Failure> _failures;
+    };
+}
@@ -0,0 +1,736 @@
+#include "expression.h"
+#include "assembler_util.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace lib8085
+{
+    enum ExpressionOp : uint8_t
+    {
+        // Constants follow low byte first
+        OP_CONST8,
+        OP_CONST16,
+        OP_CONST32,
+        // Followed by the symbol index
+        OP_SYMBOL,
+        OP_LOCATION,
+        OP_NEG,
+        OP_NOT,
+        OP_HIGH,
+        OP_LOW,
+        OP_ADD,
+        OP_SUB,
+        OP_MUL,
+        OP_DIV,
+        OP_MOD,
+        OP_SHL,
+        OP_SHR,
+        OP_AND,
+        OP_OR,
+        OP_XOR
+    };
+
+    // Deep enough for anything written by hand, compiling refuses more
+    static const int MAX_STACK = 16;
+    static const int MAX_NESTING = 32;
+
+    static bool apply_unary(uint8_t op, int32_t a, int32_t& result)
+    {
+        switch(op)
+        {
+            case OP_NEG:  result = (int32_t)(0u - (uint32_t)a); break;
+            case OP_NOT:  result = ~a; break;
+            case OP_HIGH: result = (a >> 8) & 0xff; break;
+            case OP_LOW:  result = a & 0xff; break;
+            default:
+                return false;
+        }
+        return true;
+    }
+
+    static bool apply_binary(uint8_t op, int32_t a, int32_t b, int32_t& result)
+    {
+        switch(op)
+        {
+            case OP_ADD: result = (int32_t)((uint32_t)a + (uint32_t)b); break;
+            case OP_SUB: result = (int32_t)((uint32_t)a - (uint32_t)b); break;
+            case OP_MUL: result = (int32_t)((uint32_t)a * (uint32_t)b); break;
+            case OP_DIV:
+            case OP_MOD:
+                if(b == 0)
+                {
+                    return false;
+                }
+                // In 64 bit so INT_MIN / -1 doesn't trap
+                result = (int32_t)(op == OP_DIV ? (int64_t)a / b : (int64_t)a % b);
+                break;
+            case OP_SHL: result = b < 0 || b > 31 ? 0 : (int32_t)((uint32_t)a << b); break;
+            case OP_SHR: result = b < 0 || b > 31 ? 0 : (int32_t)((uint32_t)a >> b); break;
+            case OP_AND: result = a & b; break;
+            case OP_OR:  result = a | b; break;
+            case OP_XOR: result = a ^ b; break;
+            default:
+                return false;
+        }
+        return true;
+    }
+
+    static bool is_name_start(char c)
+    {
+        return std::isalpha((unsigned char)c) || c == '_' || c == '?' || c == '@';
+    }
+
+    static bool is_name_char(char c)
+    {
+        return std::isalnum((unsigned char)c) || c == '_' || c == '?' || c == '@';
+    }
+
+    static bool equals_keyword(std::string_view word, const char* keyword)
+    {
+        size_t i = 0;
+        for(; i < word.size() && keyword[i]; i ++)
+        {
+            if(std::toupper((unsigned char)word[i]) != keyword[i])
+            {
+                return false;
+            }
+        }
+        return i == word.size() && !keyword[i];
+    }
+
+    // Recursive descent straight to bytecode, constant operands are folded as they are emitted
+    class ExpressionCompiler
+    {
+        public:
+            ExpressionCompiler(std::string_view text, std::vector<uint8_t>& code, std::vector<std::string>& symbols, bool& location)
+                : _text(text), _pos(0), _nesting(0), _code(code), _symbols(symbols), _location(location), _top(0)
+            {
+            }
+
+            size_t compile(std::string& error)
+            {
+                skip_blanks();
+
+                if(!or_expression())
+                {
+                    error = _error;
+                    return 0;
+                }
+
+                return _pos;
+            }
+
+        private:
+            // Where each value on the stack starts in the code, and its value when it is a constant
+            struct Slot
+            {
+                size_t start;
+                bool constant;
+                int32_t value;
+            };
+
+            std::string_view _text;
+            size_t _pos;
+            int _nesting;
+            std::vector<uint8_t>& _code;
+            std::vector<std::string>& _symbols;
+            bool& _location;
+            Slot _stack[MAX_STACK];
+            int _top;
+            std::string _error;
+
+            bool fail(const std::string& error)
+            {
+                _error = error;
+                return false;
+            }
+
+            void skip_blanks()
+            {
+                while(_pos < _text.size() && (_text[_pos] == ' ' || _text[_pos] == '\t' || _text[_pos] == '\r'))
+                {
+                    _pos++;
+                }
+            }
+
+            std::string_view peek_name() const
+            {
+                size_t end = _pos;
+                if(end < _text.size() && is_name_start(_text[end]))
+                {
+                    while(end < _text.size() && is_name_char(_text[end]))
+                    {
+                        end++;
+                    }
+                }
+                return _text.substr(_pos, end - _pos);
+            }
+
+            bool accept(char c)
+            {
+                if(_pos < _text.size() && _text[_pos] == c)
+                {
+                    _pos++;
+                    skip_blanks();
+                    return true;
+                }
+                return false;
+            }
+
+            bool accept_keyword(const char* keyword)
+            {
+                std::string_view name = peek_name();
+                if(!name.empty() && equals_keyword(name, keyword))
+                {
+                    _pos += name.size();
+                    skip_blanks();
+                    return true;
+                }
+                return false;
+            }
+
+            bool push(bool constant, int32_t value)
+            {
+                if(_top >= MAX_STACK)
+                {
+                    return fail("Expression is too complex");
+                }
+                _stack[_top++] = Slot{ _code.size(), constant, value };
+                return true;
+            }
+
+            bool emit_constant(int32_t value)
+            {
+                if(!push(true, value))
+                {
+                    return false;
+                }
+
+                const uint32_t v = (uint32_t)value;
+                if(v <= 0xff)
+                {
+                    _code.push_back(OP_CONST8);
+                    _code.push_back((uint8_t)v);
+                }
+                else if(v <= 0xffff)
+                {
+                    _code.push_back(OP_CONST16);
+                    _code.push_back((uint8_t)v);
+                    _code.push_back((uint8_t)(v >> 8));
+                }
+                else
+                {
+                    _code.push_back(OP_CONST32);
+                    for(int i = 0; i < 4; i ++)
+                    {
+                        _code.push_back((uint8_t)(v >> (i * 8)));
+                    }
+                }
+                return true;
+            }
+
+            bool emit_unary(uint8_t op)
+            {
+                const Slot a = _stack[_top - 1];
+                int32_t result;
+
+                if(a.constant && apply_unary(op, a.value, result))
+                {
+                    _top--;
+                    _code.resize(a.start);
+                    return emit_constant(result);
+                }
+
+                _stack[_top - 1].constant = false;
+                _code.push_back(op);
+                return true;
+            }
+
+            bool emit_binary(uint8_t op)
+            {
+                const Slot b = _stack[--_top];
+                const Slot a = _stack[_top - 1];
+                int32_t result;
+
+                // Division by zero is left to evaluate() to report
+                if(a.constant && b.constant && apply_binary(op, a.value, b.value, result))
+                {
+                    _top--;
+                    _code.resize(a.start);
+                    return emit_constant(result);
+                }
+
+                _stack[_top - 1].constant = false;
+                _code.push_back(op);
+                return true;
+            }
+
+            bool or_expression()
+            {
+                if(!and_expression())
+                {
+                    return false;
+                }
+
+                for(;;)
+                {
+                    uint8_t op;
+                    if(accept_keyword("OR"))
+                    {
+                        op = OP_OR;
+                    }
+                    else if(accept_keyword("XOR"))
+                    {
+                        op = OP_XOR;
+                    }
+                    else
+                    {
+                        return true;
+                    }
+
+                    if(!and_expression() || !emit_binary(op))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            bool and_expression()
+            {
+                if(!not_expression())
+                {
+                    return false;
+                }
+
+                while(accept_keyword("AND"))
+                {
+                    if(!not_expression() || !emit_binary(OP_AND))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            bool not_expression()
+            {
+                if(accept_keyword("NOT"))
+                {
+                    if(++_nesting > MAX_NESTING)
+                    {
+                        return fail("Expression is nested too deeply");
+                    }
+                    bool valid = not_expression() && emit_unary(OP_NOT);
+                    _nesting--;
+                    return valid;
+                }
+                return add_expression();
+            }
+
+            bool add_expression()
+            {
+                if(!mul_expression())
+                {
+                    return false;
+                }
+
+                for(;;)
+                {
+                    uint8_t op;
+                    if(accept('+'))
+                    {
+                        op = OP_ADD;
+                    }
+                    else if(accept('-'))
+                    {
+                        op = OP_SUB;
+                    }
+                    else
+                    {
+                        return true;
+                    }
+
+                    if(!mul_expression() || !emit_binary(op))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            bool mul_expression()
+            {
+                if(!unary_expression())
+                {
+                    return false;
+                }
+
+                for(;;)
+                {
+                    uint8_t op;
+                    if(accept('*'))
+                    {
+                        op = OP_MUL;
+                    }
+                    else if(accept('/'))
+                    {
+                        op = OP_DIV;
+                    }
+                    else if(accept_keyword("MOD"))
+                    {
+                        op = OP_MOD;
+                    }
+                    else if(accept_keyword("SHL"))
+                    {
+                        op = OP_SHL;
+                    }
+                    else if(accept_keyword("SHR"))
+                    {
+                        op = OP_SHR;
+                    }
+                    else
+                    {
+                        return true;
+                    }
+
+                    if(!unary_expression() || !emit_binary(op))
+                    {
+                        return false;
+                    }
+                }
+            }
+
+            bool unary_expression()
+            {
+                uint8_t op;
+                if(accept('+'))
+                {
+                    return unary_expression();
+                }
+                else if(accept('-'))
+                {
+                    op = OP_NEG;
+                }
+                else if(accept_keyword("HIGH"))
+                {
+                    op = OP_HIGH;
+                }
+                else if(accept_keyword("LOW"))
+                {
+                    op = OP_LOW;
+                }
+                else
+                {
+                    return primary();
+                }
+
+                if(++_nesting > MAX_NESTING)
+                {
+                    return fail("Expression is nested too deeply");
+                }
+                bool valid = unary_expression() && emit_unary(op);
+                _nesting--;
+                return valid;
+            }
+
+            bool primary()
+            {
+                if(_pos >= _text.size())
+                {
+                    return fail("Expected a value at the end of the expression");
+                }
+
+                const char c = _text[_pos];
+
+                if(c == '(')
+                {
+                    if(++_nesting > MAX_NESTING)
+                    {
+                        return fail("Expression is nested too deeply");
+                    }
+                    accept('(');
+
+                    if(!or_expression())
+                    {
+                        return false;
+                    }
+                    if(!accept(')'))
+                    {
+                        return fail("Expected \')\'");
+                    }
+                    _nesting--;
+                    return true;
+                }
+
+                if(c == '$')
+                {
+                    accept('$');
+                    _location = true;
+                    if(!push(false, 0))
+                    {
+                        return false;
+                    }
+                    _code.push_back(OP_LOCATION);
+                    return true;
+                }
+
+                if(c == '\'')
+                {
+                    // One or two characters, the first one is the high byte
+                    const size_t close = _text.find('\'', _pos + 1);
+                    if(close == std::string_view::npos || close == _pos + 1 || close > _pos + 3)
+                    {
+                        return fail("Expected one or two characters between quotes");
+                    }
+
+                    int32_t value = 0;
+                    for(size_t i = _pos + 1; i < close; i ++)
+                    {
+                        value = (value << 8) | (uint8_t)_text[i];
+                    }
+                    _pos = close;
+                    accept('\'');
+                    return emit_constant(value);
+                }
+
+                if(std::isdigit((unsigned char)c))
+                {
+                    size_t end = _pos;
+                    while(end < _text.size() && std::isalnum((unsigned char)_text[end]))
+                    {
+                        end++;
+                    }
+
+                    const std::string number(_text.substr(_pos, end - _pos));
+                    uint32_t value;
+                    if(!AssemblerUtil::parse_number(number, value))
+                    {
+                        return fail("Invalid number \'" + number + "\'");
+                    }
+                    _pos = end;
+                    skip_blanks();
+                    return emit_constant((int32_t)value);
+                }
+
+                const std::string_view name = peek_name();
+                if(name.empty())
+                {
+                    return fail("Expected a value, found \'" + std::string(1, c) + "\'");
+                }
+
+                for(const char* keyword : { "OR", "XOR", "AND", "NOT", "MOD", "SHL", "SHR", "HIGH", "LOW" })
+                {
+                    if(equals_keyword(name, keyword))
+                    {
+                        return fail("Expected a value, found \'" + std::string(name) + "\'");
+                    }
+                }
+
+                _pos += name.size();
+                skip_blanks();
+
+                // Hex digits with an H suffix were numbers before labels could be used in expressions
+                if(name.size() > 1 && std::toupper((unsigned char)name.back()) == 'H'
+                        && std::all_of(name.begin(), name.end() - 1, [](char h) { return std::isxdigit((unsigned char)h); }))
+                {
+                    uint32_t value;
+                    if(!AssemblerUtil::parse_number(std::string(name), value))
+                    {
+                        return fail("Invalid number \'" + std::string(name) + "\'");
+                    }
+                    return emit_constant((int32_t)value);
+                }
+
+                size_t index = 0;
+                while(index < _symbols.size() && _symbols[index] != name)
+                {
+                    index++;
+                }
+                if(index == _symbols.size())
+                {
+                    if(_symbols.size() > 0xff)
+                    {
+                        return fail("Expression names too many labels");
+                    }
+                    _symbols.push_back(std::string(name));
+                }
+
+                if(!push(false, 0))
+                {
+                    return false;
+                }
+                _code.push_back(OP_SYMBOL);
+                _code.push_back((uint8_t)index);
+                return true;
+            }
+    };
+
+    void Expression::clear()
+    {
+        _code.clear();
+        _symbols.clear();
+        _location = false;
+    }
+
+    size_t Expression::compile(std::string_view text, std::string& error)
+    {
+        clear();
+
+        ExpressionCompiler compiler(text, _code, _symbols, _location);
+        size_t used = compiler.compile(error);
+
+        if(used == 0)
+        {
+            clear();
+        }
+
+        return used;
+    }
+
+    bool Expression::evaluate(const int32_t* values, int32_t location, int32_t& value) const
+    {
+        int32_t stack[MAX_STACK];
+        int top = 0;
+
+        for(size_t pc = 0; pc < _code.size(); )
+        {
+            const uint8_t op = _code[pc++];
+
+            switch(op)
+            {
+                case OP_CONST8:
+                    stack[top++] = _code[pc];
+                    pc += 1;
+                    break;
+                case OP_CONST16:
+                    stack[top++] = _code[pc] | (_code[pc + 1] << 8);
+                    pc += 2;
+                    break;
+                case OP_CONST32:
+                    stack[top++] = (int32_t)((uint32_t)_code[pc] | ((uint32_t)_code[pc + 1] << 8)
+                            | ((uint32_t)_code[pc + 2] << 16) | ((uint32_t)_code[pc + 3] << 24));
+                    pc += 4;
+                    break;
+                case OP_SYMBOL:
+                    stack[top++] = values[_code[pc]];
+                    pc += 1;
+                    break;
+                case OP_LOCATION:
+                    stack[top++] = location;
+                    break;
+                case OP_NEG:
+                case OP_NOT:
+                case OP_HIGH:
+                case OP_LOW:
+                    apply_unary(op, stack[top - 1], stack[top - 1]);
+                    break;
+                default:
+                    top--;
+                    if(!apply_binary(op, stack[top - 1], stack[top], stack[top - 1]))
+                    {
+                        return false;
+                    }
+                    break;
+            }
+        }
+
+        value = stack[0];
+        return true;
+    }
+
+    bool Expression::linear(int& term, int32_t& constant) const
+    {
+        // Every value is a constant plus at most one term
+        struct Value
+        {
+            int term;
+            int32_t constant;
+        };
+
+        Value stack[MAX_STACK];
+        int top = 0;
+
+        for(size_t pc = 0; pc < _code.size(); )
+        {
+            const uint8_t op = _code[pc++];
+
+            switch(op)
+            {
+                case OP_CONST8:
+                case OP_CONST16:
+                case OP_CONST32:
+                {
+                    const size_t size = op == OP_CONST8 ? 1 : op == OP_CONST16 ? 2 : 4;
+                    uint32_t v = 0;
+                    for(size_t i = 0; i < size; i ++)
+                    {
+                        v |= (uint32_t)_code[pc + i] << (i * 8);
+                    }
+                    stack[top++] = Value{ NONE, (int32_t)v };
+                    pc += size;
+                    break;
+                }
+                case OP_SYMBOL:
+                    stack[top++] = Value{ _code[pc], 0 };
+                    pc += 1;
+                    break;
+                case OP_LOCATION:
+                    stack[top++] = Value{ LOCATION, 0 };
+                    break;
+                case OP_NEG:
+                case OP_NOT:
+                case OP_HIGH:
+                case OP_LOW:
+                    if(stack[top - 1].term != NONE)
+                    {
+                        return false;
+                    }
+                    apply_unary(op, stack[top - 1].constant, stack[top - 1].constant);
+                    break;
+                default:
+                {
+                    top--;
+                    Value& a = stack[top - 1];
+                    const Value& b = stack[top];
+
+                    if(op == OP_ADD && (a.term == NONE || b.term == NONE))
+                    {
+                        a.term = a.term == NONE ? b.term : a.term;
+                    }
+                    else if(op == OP_SUB && b.term == NONE)
+                    {
+                    }
+                    else if(a.term != NONE || b.term != NONE)
+                    {
+                        return false;
+                    }
+
+                    if(!apply_binary(op, a.constant, b.constant, a.constant))
+                    {
+                        return false;
+                    }
+                    break;
+                }
+            }
+        }
+
+        term = stack[0].term;
+        constant = stack[0].constant;
+        return true;
+    }
+
+    const std::vector<std::string>& Expression::symbols() const
+    {
+        return _symbols;
+    }
+
+    bool Expression::uses_location() const
+    {
+        return _location;
+    }
+
+    bool Expression::is_symbol() const
+    {
+        return _code.size() == 2 && _code[0] == OP_SYMBOL;
+    }
+}
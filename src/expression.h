@@ -0,0 +1,61 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Operand expression compiled once into postfix bytecode and evaluated as
+     * often as the labels it names move.
+     *
+     * Grammar, loosest binding first:
+     *   OR, XOR
+     *   AND
+     *   NOT
+     *   + -
+     *   * / MOD SHL SHR
+     *   unary + -, HIGH, LOW
+     *   numbers, 'c' and 'cc' characters, $, labels and parentheses
+     *
+     * Numbers are written the way AssemblerUtil::parse_number reads them,
+     * names that are hex digits with an H suffix such as FFH are numbers too.
+     * Operators match in any case, labels don't. Values are 32 bit while
+     * evaluating, the caller checks they fit the operand.
+     *
+     */
+    class Expression
+    {
+        public:
+            // Term of linear() that stands for $
+            static const int LOCATION = -1;
+            // Term of linear() when the value is a constant
+            static const int NONE = -2;
+
+            void clear();
+
+            // Compiles the expression text starts with and returns the characters it used,
+            // trailing blanks included. 0 with error set when there is none
+            size_t compile(std::string_view text, std::string& error);
+
+            // values[i] is the value of symbols()[i] and location the address $ stands for.
+            // False on division by zero
+            bool evaluate(const int32_t* values, int32_t location, int32_t& value) const;
+
+            // Whether the value is one label or $ plus a constant, what a relocation can
+            // express. term is the symbol index, LOCATION or NONE
+            bool linear(int& term, int32_t& constant) const;
+
+            // Labels in order of first use, bytecode refers to them by index
+            const std::vector<std::string>& symbols() const;
+            bool uses_location() const;
+            // A lone label, nothing computed from it
+            bool is_symbol() const;
+
+        private:
+            std::vector<uint8_t> _code;
+            std::vector<std::string> _symbols;
+            bool _location = false;
+    };
+}
@@ -0,0 +1,27 @@
+#include "../assembler.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// Arbitrary source text through the tokenizer, parser, disassembler and diagnostics
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static std::ostream discard(nullptr);
+
+    std::string code(reinterpret_cast<const char*>(data), size);
+
+    lib8085::Assembler assembler(code);
+    assembler.tokenize();
+
+    if(assembler.parse())
+    {
+        assembler.disassemble();
+    }
+
+    assembler.diagnostics().print(discard);
+    assembler.diagnostics().write_json(discard);
+
+    return 0;
+}
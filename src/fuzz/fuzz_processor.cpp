@@ -0,0 +1,92 @@
+#include "../lib8085.h"
+#include "../reference_cpu.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Instructions per input, enough to run through loops without hurting throughput
+static const uint64_t MAX_INSTRUCTIONS = 4096;
+
+// Initial registers, flags and stack pointer taken from the front of the input
+static const size_t STATE_SIZE = 10;
+
+/*
+ * Arbitrary memory images executed on Processor, checked against ReferenceCpu.
+ *
+ * The first bytes set A, B, C, D, E, H, L, the flags and SP, the rest is loaded
+ * at address 0 where execution starts. Any divergence from the reference model
+ * aborts so the fuzzer keeps the input.
+ *
+ */
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static lib8085::Processor cpu;
+    static lib8085::ReferenceCpu ref;
+
+    if(size < STATE_SIZE)
+    {
+        return 0;
+    }
+
+    const uint8_t* image = data + STATE_SIZE;
+    size_t image_size = size - STATE_SIZE;
+
+    if(image_size > 0x10000)
+    {
+        image_size = 0x10000;
+    }
+
+    cpu.reset();
+    ref.reset();
+    ref.clear_memory();
+
+    cpu.load_memory(0, image, image_size);
+    for(size_t i = 0; i < image_size; i ++)
+    {
+        ref.write((uint16_t)i, image[i]);
+    }
+
+    cpu.reg_a = ref.regs[lib8085::R_A] = data[0];
+    cpu.reg_b = ref.regs[lib8085::R_B] = data[1];
+    cpu.reg_c = ref.regs[lib8085::R_C] = data[2];
+    cpu.reg_d = ref.regs[lib8085::R_D] = data[3];
+    cpu.reg_e = ref.regs[lib8085::R_E] = data[4];
+    cpu.reg_h = ref.regs[lib8085::R_H] = data[5];
+    cpu.reg_l = ref.regs[lib8085::R_L] = data[6];
+    cpu.set_flags(data[7]);
+    ref.flags = cpu.get_flags();
+    cpu.stack_pointer = ref.sp = (uint16_t)(data[8] | (data[9] << 8));
+
+    for(uint64_t i = 0; i < MAX_INSTRUCTIONS; i ++)
+    {
+        cpu.step();
+        ref.step();
+
+        if(cpu.reg_a != ref.regs[lib8085::R_A] || cpu.reg_b != ref.regs[lib8085::R_B]
+                || cpu.reg_c != ref.regs[lib8085::R_C] || cpu.reg_d != ref.regs[lib8085::R_D]
+                || cpu.reg_e != ref.regs[lib8085::R_E] || cpu.reg_h != ref.regs[lib8085::R_H]
+                || cpu.reg_l != ref.regs[lib8085::R_L] || cpu.get_flags() != ref.flags
+                || cpu.program_counter != ref.pc || cpu.stack_pointer != ref.sp
+                || cpu.halted != ref.halted || cpu.cycles != ref.cycles)
+        {
+            std::abort();
+        }
+
+        for(int w = 0; w < ref.write_count; w ++)
+        {
+            if(cpu.read_mem(ref.writes[w].address) != ref.writes[w].value)
+            {
+                std::abort();
+            }
+        }
+
+        if(cpu.halted)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -3,16 +3,15 @@
 
 bool retro85::App::assemble(std::string& code)
 {
-    std::cout << "Code: " << code << "\n";
-    lib8085::Assembler assembler{code};
+    _code = code;
 
-    assembler.assemble();
-    std::copy(assembler._program_instructions.begin(), 
-            assembler._program_instructions.end(), _cpu.mem);
-    assembler.disassemble();
-    _assembler._disassembly = assembler._disassembly;
+    // Only lines changed since the last build are assembled again
+    _assembler.assemble_incremental();
+    _cpu.load_memory(0, _assembler._program_instructions.data(),
+            _assembler._program_instructions.size());
+    _assembler.diagnostics().print(std::cerr);
 
-    return true;
+    return !_assembler.diagnostics().has_errors();
 }
 
 bool retro85::App::step()
@@ -43,7 +42,7 @@ lib8085::Processor* retro85::App::get_cpu()
     return &_cpu;
 }
 
-retro85::App::App() : _assembler(lib8085::Assembler(std::string("")))
+retro85::App::App() : _assembler(_code)
 {
 
 }
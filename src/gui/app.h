@@ -18,6 +18,8 @@ namespace retro85
 
             ~App();
         private:
+            // The assembler keeps referring to it, its line cache makes rebuilding after an edit cheap
+            std::string _code;
             lib8085::Assembler _assembler;
             lib8085::Processor _cpu;
 
@@ -330,7 +330,7 @@ int main(int, char**)
                             uint8_t val;
                             for(int j = 0; j < cols; j ++)
                             {
-                                val = cpu->mem[mem_index++];
+                                val = cpu->read_mem((uint16_t)mem_index++);
 
                                 if(std::isprint(val))
                                     ascii_string += val;
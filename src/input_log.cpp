@@ -0,0 +1,262 @@
+#include "input_log.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+namespace lib8085
+{
+    static const char _input_log_magic[4] = { 'R', '8', '5', 'I' };
+    static const uint8_t _input_log_version = 1;
+
+    void InputLog::clear()
+    {
+        data.clear();
+        _last_interrupt_cycle = 0;
+    }
+
+    void InputLog::push_varint(uint64_t value)
+    {
+        while(value >= 0x80)
+        {
+            data.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        data.push_back((uint8_t)value);
+    }
+
+    void InputLog::push_in(uint8_t value)
+    {
+        data.push_back(EVENT_IN);
+        data.push_back(value);
+    }
+
+    void InputLog::push_sid(bool sid)
+    {
+        data.push_back(EVENT_SID);
+        data.push_back(sid ? 1 : 0);
+    }
+
+    void InputLog::push_interrupt(uint64_t cycle, uint8_t lines)
+    {
+        data.push_back(EVENT_INTERRUPT);
+        push_varint(cycle - _last_interrupt_cycle);
+        data.push_back(lines);
+
+        _last_interrupt_cycle = cycle;
+    }
+
+    void InputLog::push_acknowledge(uint8_t rst)
+    {
+        data.push_back(EVENT_ACKNOWLEDGE);
+        data.push_back(rst);
+    }
+
+    bool InputLog::save(const char* path) const
+    {
+        std::ofstream file(path, std::ios::out | std::ios::binary);
+
+        if(!file.good() || !file.is_open())
+        {
+            std::cerr << "Error writing input log \'" << path << "\'\n";
+            return false;
+        }
+
+        file.write(_input_log_magic, sizeof(_input_log_magic));
+        file.write(reinterpret_cast<const char*>(&_input_log_version), 1);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+        return file.good();
+    }
+
+    bool InputLog::load(const char* path)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+
+        if(!file.good() || !file.is_open())
+        {
+            std::cerr << "Error reading input log \'" << path << "\'\n";
+            return false;
+        }
+
+        char header[5];
+        file.read(header, sizeof(header));
+
+        if(!file.good()
+                || !std::equal(_input_log_magic, _input_log_magic + 4, header)
+                || (uint8_t)header[4] != _input_log_version)
+        {
+            std::cerr << "\'" << path << "\' is not a supported input log\n";
+            return false;
+        }
+
+        clear();
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+
+        return true;
+    }
+
+    InputRecorder::InputRecorder(IoBus* devices, InputLog& log) : _devices(devices), _log(log)
+    {
+    }
+
+    uint8_t InputRecorder::in(uint8_t port)
+    {
+        uint8_t value = _devices ? _devices->in(port) : 0xff;
+        _log.push_in(value);
+
+        return value;
+    }
+
+    void InputRecorder::out(uint8_t port, uint8_t value)
+    {
+        if(_devices)
+        {
+            _devices->out(port, value);
+        }
+    }
+
+    bool InputRecorder::sid()
+    {
+        bool sid = _devices ? _devices->sid() : false;
+        _log.push_sid(sid);
+
+        return sid;
+    }
+
+    uint8_t InputRecorder::interrupts(uint64_t cycle, uint8_t raised)
+    {
+        uint8_t lines = _devices ? _devices->interrupts(cycle, raised) : raised;
+
+        if(lines)
+        {
+            _log.push_interrupt(cycle, lines);
+        }
+
+        return lines;
+    }
+
+    uint8_t InputRecorder::acknowledge()
+    {
+        uint8_t rst = _devices ? _devices->acknowledge() : 7;
+        _log.push_acknowledge(rst);
+
+        return rst;
+    }
+
+    uint64_t InputRecorder::next_event_cycle() const
+    {
+        return _devices ? _devices->next_event_cycle() : UINT64_MAX;
+    }
+
+    InputReplayer::InputReplayer(const InputLog& log)
+        : _log(log), _offset(0), _last_interrupt_cycle(0), _next_interrupt_cycle(UINT64_MAX)
+    {
+        peek_interrupt();
+    }
+
+    uint64_t InputReplayer::read_varint()
+    {
+        uint64_t value = 0;
+        int shift = 0;
+
+        while(_offset < _log.data.size())
+        {
+            uint8_t b = _log.data[_offset++];
+            value |= (uint64_t)(b & 0x7f) << shift;
+
+            if(!(b & 0x80))
+            {
+                return value;
+            }
+
+            shift += 7;
+        }
+
+        throw std::runtime_error("Input log truncated");
+    }
+
+    void InputReplayer::peek_interrupt()
+    {
+        _next_interrupt_cycle = UINT64_MAX;
+
+        if(_offset < _log.data.size() && _log.data[_offset] == InputLog::EVENT_INTERRUPT)
+        {
+            size_t offset = _offset++;
+            _next_interrupt_cycle = _last_interrupt_cycle + read_varint();
+            _offset = offset;
+        }
+    }
+
+    uint8_t InputReplayer::expect(InputLog::EventType type)
+    {
+        if(_offset + 2 > _log.data.size() || _log.data[_offset] != type)
+        {
+            throw std::runtime_error("Replay diverged from the input log");
+        }
+
+        uint8_t value = _log.data[_offset + 1];
+        _offset += 2;
+
+        peek_interrupt();
+
+        return value;
+    }
+
+    uint8_t InputReplayer::in(uint8_t)
+    {
+        return expect(InputLog::EVENT_IN);
+    }
+
+    void InputReplayer::out(uint8_t, uint8_t)
+    {
+    }
+
+    bool InputReplayer::sid()
+    {
+        return expect(InputLog::EVENT_SID) != 0;
+    }
+
+    uint8_t InputReplayer::interrupts(uint64_t cycle, uint8_t)
+    {
+        // Live lines are ignored, only what was recorded gets delivered
+        if(cycle < _next_interrupt_cycle)
+        {
+            return 0;
+        }
+
+        if(cycle > _next_interrupt_cycle)
+        {
+            throw std::runtime_error("Replay missed a recorded interrupt");
+        }
+
+        _offset++;
+        _last_interrupt_cycle += read_varint();
+
+        if(_offset >= _log.data.size())
+        {
+            throw std::runtime_error("Input log truncated");
+        }
+
+        uint8_t lines = _log.data[_offset++];
+        peek_interrupt();
+
+        return lines;
+    }
+
+    uint8_t InputReplayer::acknowledge()
+    {
+        return expect(InputLog::EVENT_ACKNOWLEDGE);
+    }
+
+    uint64_t InputReplayer::next_event_cycle() const
+    {
+        return _next_interrupt_cycle;
+    }
+
+    bool InputReplayer::done() const
+    {
+        return _offset >= _log.data.size();
+    }
+}
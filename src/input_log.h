@@ -0,0 +1,99 @@
+#pragma once
+#include "lib8085.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Compact binary log of every nondeterministic input the processor consumed.
+     *
+     * Events are stored in the order the processor asked for them:
+     *   IN value, SID bit, interrupt lines latched at a cycle (cycle is a varint
+     *   delta from the previous interrupt) and the restart number acknowledged for INTR.
+     *
+     */
+    class InputLog
+    {
+        public:
+            enum EventType : uint8_t
+            {
+                EVENT_IN,
+                EVENT_SID,
+                EVENT_INTERRUPT,
+                EVENT_ACKNOWLEDGE
+            };
+
+            std::vector<uint8_t> data;
+
+            void clear();
+
+            void push_in(uint8_t value);
+            void push_sid(bool sid);
+            void push_interrupt(uint64_t cycle, uint8_t lines);
+            void push_acknowledge(uint8_t rst);
+
+            bool save(const char* path) const;
+            bool load(const char* path);
+
+        private:
+            uint64_t _last_interrupt_cycle = 0;
+
+            void push_varint(uint64_t value);
+    };
+
+    /*
+     * Sits between the processor and the real devices, forwarding everything
+     * while appending what the processor saw to the log.
+     *
+     */
+    class InputRecorder : public IoBus
+    {
+        public:
+            InputRecorder(IoBus* devices, InputLog& log);
+
+            uint8_t in(uint8_t port) override;
+            void out(uint8_t port, uint8_t value) override;
+            bool sid() override;
+            uint8_t interrupts(uint64_t cycle, uint8_t raised) override;
+            uint8_t acknowledge() override;
+            uint64_t next_event_cycle() const override;
+
+        private:
+            IoBus* _devices;
+            InputLog& _log;
+    };
+
+    /*
+     * Feeds a recorded log back to the processor with the devices disconnected.
+     * Output is discarded, anything that doesn't match the recorded sequence throws
+     * std::runtime_error, check done() afterwards for a log that wasn't used up.
+     *
+     */
+    class InputReplayer : public IoBus
+    {
+        public:
+            InputReplayer(const InputLog& log);
+
+            uint8_t in(uint8_t port) override;
+            void out(uint8_t port, uint8_t value) override;
+            bool sid() override;
+            uint8_t interrupts(uint64_t cycle, uint8_t raised) override;
+            uint8_t acknowledge() override;
+            uint64_t next_event_cycle() const override;
+
+            // True once every recorded event has been consumed
+            bool done() const;
+
+        private:
+            const InputLog& _log;
+            size_t _offset;
+            uint64_t _last_interrupt_cycle;
+            uint64_t _next_interrupt_cycle;
+
+            uint8_t expect(InputLog::EventType type);
+            uint64_t read_varint();
+            void peek_interrupt();
+    };
+}
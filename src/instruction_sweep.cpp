@@ -0,0 +1,766 @@
+#include "instruction_sweep.h"
+#include "isa.h"
+#include "differential.h"
+#include "parallel.h"
+#include "state_field.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+
+namespace lib8085
+{
+    // Instructions run from here, M operands live at M_ADDRESS
+    static const uint16_t CODE_ADDRESS = 0x1000;
+    static const uint16_t M_ADDRESS = 0x2000;
+
+    // States handed to a worker at a time
+    static const uint64_t BLOCK_SIZE = 16384;
+
+    enum SweepFlag : uint8_t
+    {
+        SF_CY = 0x01, SF_P = 0x04, SF_AC = 0x10, SF_Z = 0x40, SF_S = 0x80,
+        SF_ALL = SF_S | SF_Z | SF_AC | SF_P | SF_CY
+    };
+
+    enum SpecKind
+    {
+        SPEC_NONE,
+        SPEC_ADD, SPEC_ADC, SPEC_SUB, SPEC_SBB, SPEC_ANA, SPEC_XRA, SPEC_ORA, SPEC_CMP,
+        SPEC_INR, SPEC_DCR, SPEC_DAA, SPEC_RLC, SPEC_RRC, SPEC_RAL, SPEC_RAR,
+        SPEC_CMA, SPEC_CMC, SPEC_STC,
+        SPEC_MOV, SPEC_MVI, SPEC_LXI, SPEC_INX, SPEC_DCX, SPEC_DAD
+    };
+
+    // The part of the input state that is enumerated, the rest is filled with noise
+    enum SweepSpace
+    {
+        SPACE_ALU,   // A x operand x CY x AC
+        SPACE_BYTE,  // operand x all flags
+        SPACE_WORD,  // every value of a register pair
+        SPACE_DAD,   // every HL x edge values of the other pair
+        SPACE_FLAGS  // A x all flags
+    };
+
+    enum SweepPair { PAIR_BC, PAIR_DE, PAIR_HL, PAIR_SP };
+
+    struct Spec
+    {
+        InstructionSet opcode;
+        std::string name;
+        int length;
+        SpecKind kind;
+        SweepSpace space;
+        // ReferenceRegister or R_IMM, -1 when unused
+        int source;
+        int dest;
+        int pair;
+    };
+
+    struct SweepState
+    {
+        // ReferenceRegister order, R_M is the byte at M_ADDRESS
+        uint8_t regs[8];
+        uint8_t flags;
+        uint16_t sp;
+        uint8_t operand[2];
+        bool interrupt_enable;
+        uint8_t interrupt_mask;
+    };
+
+    struct Expected
+    {
+        StateField field;
+        uint16_t value;
+        uint8_t flags;
+    };
+
+    struct SpecName
+    {
+        const char* mnemonic;
+        SpecKind kind;
+        SweepSpace space;
+    };
+
+    static const SpecName _spec_names[] = {
+        { "ADD", SPEC_ADD, SPACE_ALU },   { "ADI", SPEC_ADD, SPACE_ALU },
+        { "ADC", SPEC_ADC, SPACE_ALU },   { "ACI", SPEC_ADC, SPACE_ALU },
+        { "SUB", SPEC_SUB, SPACE_ALU },   { "SUI", SPEC_SUB, SPACE_ALU },
+        { "SBB", SPEC_SBB, SPACE_ALU },   { "SBI", SPEC_SBB, SPACE_ALU },
+        { "ANA", SPEC_ANA, SPACE_ALU },   { "ANI", SPEC_ANA, SPACE_ALU },
+        { "XRA", SPEC_XRA, SPACE_ALU },   { "XRI", SPEC_XRA, SPACE_ALU },
+        { "ORA", SPEC_ORA, SPACE_ALU },   { "ORI", SPEC_ORA, SPACE_ALU },
+        { "CMP", SPEC_CMP, SPACE_ALU },   { "CPI", SPEC_CMP, SPACE_ALU },
+        { "INR", SPEC_INR, SPACE_BYTE },  { "DCR", SPEC_DCR, SPACE_BYTE },
+        { "MOV", SPEC_MOV, SPACE_BYTE },  { "MVI", SPEC_MVI, SPACE_BYTE },
+        { "DAA", SPEC_DAA, SPACE_FLAGS }, { "RLC", SPEC_RLC, SPACE_FLAGS },
+        { "RRC", SPEC_RRC, SPACE_FLAGS }, { "RAL", SPEC_RAL, SPACE_FLAGS },
+        { "RAR", SPEC_RAR, SPACE_FLAGS }, { "CMA", SPEC_CMA, SPACE_FLAGS },
+        { "CMC", SPEC_CMC, SPACE_FLAGS }, { "STC", SPEC_STC, SPACE_FLAGS },
+        { "LXI", SPEC_LXI, SPACE_WORD },  { "INX", SPEC_INX, SPACE_WORD },
+        { "DCX", SPEC_DCX, SPACE_WORD },  { "DAD", SPEC_DAD, SPACE_DAD }
+    };
+
+    // Carries out of every nibble and byte boundary, DAD pairs them with every HL
+    static const uint16_t _edge_values[] = {
+        0x0000, 0x0001, 0x0002, 0x000f, 0x0010, 0x007f, 0x0080, 0x00ff,
+        0x0100, 0x0101, 0x01ff, 0x0f0f, 0x0fff, 0x1000, 0x1234, 0x3fff,
+        0x4000, 0x5555, 0x7f7f, 0x7fff, 0x8000, 0x8001, 0x8080, 0x9999,
+        0xaaaa, 0xc000, 0xedcb, 0xf000, 0xf0f0, 0xfeff, 0xff00, 0xffff
+    };
+
+    static const uint64_t EDGE_COUNT = sizeof(_edge_values) / sizeof(_edge_values[0]);
+
+    static uint64_t mix(uint64_t x)
+    {
+        x += 0x9e3779b97f4a7c15ull;
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+        return x ^ (x >> 31);
+    }
+
+    static int register_index(const std::string& name)
+    {
+        static const char* names[8] = { "B", "C", "D", "E", "H", "L", "M", "A" };
+
+        for(int r = 0; r < 8; r ++)
+        {
+            if(name == names[r])
+            {
+                return r;
+            }
+        }
+        return -1;
+    }
+
+    static int pair_index(const std::string& name)
+    {
+        if(name == "B")  return PAIR_BC;
+        if(name == "D")  return PAIR_DE;
+        if(name == "H")  return PAIR_HL;
+        if(name == "SP") return PAIR_SP;
+        return -1;
+    }
+
+    // Reads the operation and its operands from the mnemonic, MOV_A_B is MOV A,B
+    static Spec classify(InstructionSet opcode, const IsaEntry& entry)
+    {
+        Spec spec;
+        spec.opcode = opcode;
+        spec.name = std::string(entry.mnemonic);
+        spec.length = entry.length;
+        spec.kind = SPEC_NONE;
+        spec.space = SPACE_FLAGS;
+        spec.source = spec.dest = spec.pair = -1;
+
+        std::vector<std::string> parts;
+        std::stringstream ss(spec.name);
+        std::string part;
+
+        while(std::getline(ss, part, '_'))
+        {
+            parts.push_back(part);
+        }
+
+        for(const SpecName& n : _spec_names)
+        {
+            if(parts[0] == n.mnemonic)
+            {
+                spec.kind = n.kind;
+                spec.space = n.space;
+                break;
+            }
+        }
+
+        switch(spec.space)
+        {
+            case SPACE_ALU:
+                spec.source = parts.size() > 1 ? register_index(parts[1]) : R_IMM;
+                spec.dest = R_A;
+                break;
+            case SPACE_BYTE:
+                if(spec.kind == SPEC_MOV)
+                {
+                    spec.dest = register_index(parts[1]);
+                    spec.source = register_index(parts[2]);
+                }
+                else
+                {
+                    spec.dest = register_index(parts[1]);
+                    spec.source = spec.kind == SPEC_MVI ? R_IMM : spec.dest;
+                }
+                break;
+            case SPACE_WORD:
+            case SPACE_DAD:
+                spec.pair = pair_index(parts[1]);
+                break;
+            case SPACE_FLAGS:
+                spec.dest = R_A;
+                break;
+        }
+
+        return spec;
+    }
+
+    static uint64_t states_for(const Spec& spec)
+    {
+        switch(spec.space)
+        {
+            case SPACE_ALU:  return spec.source == R_A ? 256 * 4 : 65536 * 4;
+            case SPACE_BYTE: return 256 * 32;
+            case SPACE_WORD: return 65536;
+            case SPACE_DAD:  return spec.pair == PAIR_HL ? 65536 : 65536 * EDGE_COUNT;
+            default:         return 256 * 32;
+        }
+    }
+
+    // Five enumerated bits to S Z AC P CY
+    static uint8_t flags_from_bits(uint64_t bits)
+    {
+        return (bits & 0x10 ? SF_S : 0) | (bits & 0x08 ? SF_Z : 0) | (bits & 0x04 ? SF_AC : 0)
+            | (bits & 0x02 ? SF_P : 0) | (bits & 0x01 ? SF_CY : 0);
+    }
+
+    static uint8_t szp(uint8_t value)
+    {
+        uint8_t ones = value;
+        ones ^= ones >> 4;
+        ones ^= ones >> 2;
+        ones ^= ones >> 1;
+
+        return (value & 0x80 ? SF_S : 0) | (value == 0 ? SF_Z : 0) | (ones & 1 ? 0 : SF_P);
+    }
+
+    static uint16_t get_pair(const SweepState& s, int pair)
+    {
+        switch(pair)
+        {
+            case PAIR_BC: return (uint16_t)((s.regs[R_B] << 8) | s.regs[R_C]);
+            case PAIR_DE: return (uint16_t)((s.regs[R_D] << 8) | s.regs[R_E]);
+            case PAIR_HL: return (uint16_t)((s.regs[R_H] << 8) | s.regs[R_L]);
+            default:      return s.sp;
+        }
+    }
+
+    static void set_pair(SweepState& s, int pair, uint16_t value)
+    {
+        switch(pair)
+        {
+            case PAIR_BC: s.regs[R_B] = value >> 8; s.regs[R_C] = value & 0xff; break;
+            case PAIR_DE: s.regs[R_D] = value >> 8; s.regs[R_E] = value & 0xff; break;
+            case PAIR_HL: s.regs[R_H] = value >> 8; s.regs[R_L] = value & 0xff; break;
+            default:      s.sp = value; break;
+        }
+    }
+
+    static uint8_t get_operand(const SweepState& s, int source)
+    {
+        return source == R_IMM ? s.operand[0] : s.regs[source];
+    }
+
+    static void set_operand(SweepState& s, int source, uint8_t value)
+    {
+        if(source == R_IMM)
+        {
+            s.operand[0] = value;
+        }
+        else
+        {
+            s.regs[source] = value;
+        }
+    }
+
+    static StateField register_field(int r)
+    {
+        static const StateTarget targets[8] = {
+            TARGET_B, TARGET_C, TARGET_D, TARGET_E, TARGET_H, TARGET_L, TARGET_MEMORY, TARGET_A
+        };
+
+        StateField field;
+        field.target = targets[r];
+        field.address = r == R_M ? M_ADDRESS : 0;
+        return field;
+    }
+
+    static StateField pair_field(int pair)
+    {
+        static const StateTarget targets[4] = { TARGET_BC, TARGET_DE, TARGET_HL, TARGET_SP };
+
+        StateField field;
+        field.target = targets[pair];
+        field.max_value = 0xffff;
+        return field;
+    }
+
+    // Results from the datasheet formulas
+    static Expected expect(const Spec& spec, const SweepState& s)
+    {
+        Expected e;
+        uint8_t a = s.regs[R_A];
+        bool cy = (s.flags & SF_CY) != 0;
+        bool ac = (s.flags & SF_AC) != 0;
+
+        e.flags = s.flags & SF_ALL;
+        e.field = spec.dest >= 0 ? register_field(spec.dest) : pair_field(spec.pair);
+        e.value = spec.dest >= 0 ? s.regs[spec.dest] : get_pair(s, spec.pair);
+
+        switch(spec.kind)
+        {
+            case SPEC_ADD:
+            case SPEC_ADC:
+            {
+                uint8_t v = get_operand(s, spec.source);
+                unsigned c = spec.kind == SPEC_ADC && cy ? 1 : 0;
+                unsigned sum = a + v + c;
+
+                e.value = sum & 0xff;
+                e.flags = szp((uint8_t)e.value) | (sum > 0xff ? SF_CY : 0)
+                    | ((a & 0x0f) + (v & 0x0f) + c > 0x0f ? SF_AC : 0);
+                break;
+            }
+            case SPEC_SUB:
+            case SPEC_SBB:
+            case SPEC_CMP:
+            {
+                // AC is set when bit 3 doesn't borrow, CY when the whole byte does
+                uint8_t v = get_operand(s, spec.source);
+                unsigned b = spec.kind == SPEC_SBB && cy ? 1 : 0;
+                uint8_t r = (uint8_t)(a - v - b);
+
+                e.value = spec.kind == SPEC_CMP ? a : r;
+                e.flags = szp(r) | ((unsigned)a < v + b ? SF_CY : 0)
+                    | ((unsigned)(a & 0x0f) >= (v & 0x0f) + b ? SF_AC : 0);
+                break;
+            }
+            case SPEC_ANA:
+                e.value = a & get_operand(s, spec.source);
+                e.flags = szp((uint8_t)e.value) | SF_AC;
+                break;
+            case SPEC_XRA:
+                e.value = a ^ get_operand(s, spec.source);
+                e.flags = szp((uint8_t)e.value);
+                break;
+            case SPEC_ORA:
+                e.value = a | get_operand(s, spec.source);
+                e.flags = szp((uint8_t)e.value);
+                break;
+            case SPEC_INR:
+            {
+                uint8_t v = s.regs[spec.dest];
+                e.value = (uint8_t)(v + 1);
+                e.flags = (s.flags & SF_CY) | szp((uint8_t)e.value) | ((v & 0x0f) == 0x0f ? SF_AC : 0);
+                break;
+            }
+            case SPEC_DCR:
+            {
+                uint8_t v = s.regs[spec.dest];
+                e.value = (uint8_t)(v - 1);
+                e.flags = (s.flags & SF_CY) | szp((uint8_t)e.value) | ((v & 0x0f) != 0 ? SF_AC : 0);
+                break;
+            }
+            case SPEC_DAA:
+            {
+                unsigned correction = ((a & 0x0f) > 9 || ac ? 0x06 : 0) | (a > 0x99 || cy ? 0x60 : 0);
+                e.value = (uint8_t)(a + correction);
+                e.flags = szp((uint8_t)e.value) | (correction & 0x60 ? SF_CY : 0) | ((a & 0x0f) > 9 ? SF_AC : 0);
+                break;
+            }
+            case SPEC_RLC:
+                e.value = (uint8_t)((a << 1) | (a >> 7));
+                e.flags = (e.flags & ~SF_CY) | (a >> 7);
+                break;
+            case SPEC_RRC:
+                e.value = (uint8_t)((a >> 1) | (a << 7));
+                e.flags = (e.flags & ~SF_CY) | (a & 1);
+                break;
+            case SPEC_RAL:
+                e.value = (uint8_t)((a << 1) | (cy ? 1 : 0));
+                e.flags = (e.flags & ~SF_CY) | (a >> 7);
+                break;
+            case SPEC_RAR:
+                e.value = (uint8_t)((a >> 1) | (cy ? 0x80 : 0));
+                e.flags = (e.flags & ~SF_CY) | (a & 1);
+                break;
+            case SPEC_CMA:
+                e.value = (uint8_t)~a;
+                break;
+            case SPEC_CMC:
+                e.flags ^= SF_CY;
+                break;
+            case SPEC_STC:
+                e.flags |= SF_CY;
+                break;
+            case SPEC_MOV:
+            case SPEC_MVI:
+                e.value = get_operand(s, spec.source);
+                break;
+            case SPEC_LXI:
+                e.value = (uint16_t)(s.operand[0] | (s.operand[1] << 8));
+                break;
+            case SPEC_INX:
+                e.value = (uint16_t)(get_pair(s, spec.pair) + 1);
+                break;
+            case SPEC_DCX:
+                e.value = (uint16_t)(get_pair(s, spec.pair) - 1);
+                break;
+            case SPEC_DAD:
+            {
+                uint32_t sum = (uint32_t)get_pair(s, PAIR_HL) + get_pair(s, spec.pair);
+                e.field = pair_field(PAIR_HL);
+                e.value = sum & 0xffff;
+                e.flags = (e.flags & ~SF_CY) | (sum > 0xffff ? SF_CY : 0);
+                break;
+            }
+            case SPEC_NONE:
+                break;
+        }
+
+        return e;
+    }
+
+    static SweepState make_state(const Spec& spec, uint64_t index)
+    {
+        SweepState s;
+        uint64_t noise = mix(((uint64_t)spec.opcode << 40) ^ index);
+        uint64_t more = mix(noise);
+
+        for(int r = 0; r < 8; r ++)
+        {
+            s.regs[r] = (uint8_t)(noise >> (r * 8));
+        }
+        s.flags = flags_from_bits(more);
+        s.sp = (uint16_t)(more >> 8);
+        s.operand[0] = (uint8_t)(more >> 24);
+        s.operand[1] = (uint8_t)(more >> 32);
+        s.interrupt_enable = (more >> 40) & 1;
+        s.interrupt_mask = (more >> 41) & 0x07;
+
+        // Flags the instruction writes without reading, set to the opposite of the result below
+        uint8_t overwritten = 0;
+
+        switch(spec.space)
+        {
+            case SPACE_ALU:
+                if(spec.source == R_A)
+                {
+                    s.regs[R_A] = index & 0xff;
+                    index >>= 8;
+                }
+                else
+                {
+                    s.regs[R_A] = index & 0xff;
+                    set_operand(s, spec.source, (uint8_t)(index >> 8));
+                    index >>= 16;
+                }
+                s.flags = (s.flags & ~(SF_CY | SF_AC)) | (index & 1 ? SF_CY : 0) | (index & 2 ? SF_AC : 0);
+                overwritten = SF_S | SF_Z | SF_P;
+                break;
+            case SPACE_BYTE:
+                set_operand(s, spec.source, index & 0xff);
+                s.flags = flags_from_bits(index >> 8);
+                break;
+            case SPACE_WORD:
+                if(spec.kind == SPEC_LXI)
+                {
+                    s.operand[0] = index & 0xff;
+                    s.operand[1] = (uint8_t)(index >> 8);
+                }
+                else
+                {
+                    set_pair(s, spec.pair, (uint16_t)index);
+                }
+                break;
+            case SPACE_DAD:
+                set_pair(s, PAIR_HL, index & 0xffff);
+                if(spec.pair != PAIR_HL)
+                {
+                    set_pair(s, spec.pair, _edge_values[index >> 16]);
+                }
+                overwritten = SF_CY;
+                break;
+            case SPACE_FLAGS:
+                s.regs[R_A] = index & 0xff;
+                s.flags = flags_from_bits(index >> 8);
+                break;
+        }
+
+        // M operands are addressed through HL
+        if(spec.source == R_M || spec.dest == R_M)
+        {
+            s.regs[R_H] = M_ADDRESS >> 8;
+            s.regs[R_L] = M_ADDRESS & 0xff;
+        }
+
+        if(overwritten)
+        {
+            uint8_t expected = expect(spec, s).flags;
+            s.flags = (s.flags & ~overwritten) | (~expected & overwritten);
+        }
+
+        return s;
+    }
+
+    static void load_state(const Spec& spec, const SweepState& s, Processor& cpu, ReferenceCpu& ref)
+    {
+        uint8_t code[3] = { (uint8_t)spec.opcode, s.operand[0], s.operand[1] };
+
+        for(int i = 0; i < 3; i ++)
+        {
+            cpu.write_mem((uint16_t)(CODE_ADDRESS + i), code[i]);
+            ref.write((uint16_t)(CODE_ADDRESS + i), code[i]);
+        }
+        cpu.write_mem(M_ADDRESS, s.regs[R_M]);
+        ref.write(M_ADDRESS, s.regs[R_M]);
+
+        cpu.reg_a = s.regs[R_A];
+        cpu.reg_b = s.regs[R_B];
+        cpu.reg_c = s.regs[R_C];
+        cpu.reg_d = s.regs[R_D];
+        cpu.reg_e = s.regs[R_E];
+        cpu.reg_h = s.regs[R_H];
+        cpu.reg_l = s.regs[R_L];
+        cpu.set_flags(s.flags | 0x02);
+        cpu.stack_pointer = s.sp;
+        cpu.program_counter = CODE_ADDRESS;
+        cpu.interrupt_enable = s.interrupt_enable;
+        cpu.interrupt_mask = s.interrupt_mask;
+        cpu.interrupt_pending = 0;
+        cpu.halted = false;
+        cpu.cycles = 0;
+
+        for(int r = 0; r < 8; r ++)
+        {
+            ref.regs[r] = s.regs[r];
+        }
+        ref.flags = s.flags | 0x02;
+        ref.sp = s.sp;
+        ref.pc = CODE_ADDRESS;
+        ref.interrupt_enable = s.interrupt_enable;
+        ref.interrupt_mask = s.interrupt_mask;
+        ref.halted = false;
+        ref.cycles = 0;
+    }
+
+    static std::string hex(unsigned value, int width)
+    {
+        std::stringstream ss;
+        ss << std::hex << std::uppercase << std::setfill('0') << std::setw(width) << value << "H";
+        return ss.str();
+    }
+
+    static std::string describe(const Spec& spec, const SweepState& s)
+    {
+        static const char* reg_names[8] = { "B", "C", "D", "E", "H", "L", "M", "A" };
+        std::string text;
+
+        for(int r = 0; r < 8; r ++)
+        {
+            text += std::string(r ? " " : "") + reg_names[r] + "=" + hex(s.regs[r], 2);
+        }
+        text += " FLAGS=" + hex(s.flags | 0x02, 2) + " SP=" + hex(s.sp, 4);
+
+        if(spec.length == 2)
+        {
+            text += " operand=" + hex(s.operand[0], 2);
+        }
+        else if(spec.length == 3)
+        {
+            text += " operand=" + hex((unsigned)(s.operand[0] | (s.operand[1] << 8)), 4);
+        }
+
+        return text;
+    }
+
+    void InstructionSweep::run(const Options& options)
+    {
+        struct Block
+        {
+            size_t spec;
+            uint64_t begin, end;
+        };
+
+        _options = options;
+        _results.clear();
+
+        std::vector<Spec> specs;
+        std::vector<Block> blocks;
+
+        for(int op = 0; op <= XTHL; op ++)
+        {
+            const IsaEntry& entry = Isa::entry((uint8_t)op);
+
+            // Enum values the 8085 has no instruction for
+            if(!Isa::defined((uint8_t)op) || ReferenceCpu::length((uint8_t)op) == 0
+                    || entry.mnemonic.compare(0, options.filter.size(), options.filter) != 0)
+            {
+                continue;
+            }
+
+            Spec spec = classify((InstructionSet)op, entry);
+            uint64_t count = states_for(spec);
+
+            for(uint64_t begin = 0; begin < count; begin += BLOCK_SIZE)
+            {
+                blocks.push_back({ specs.size(), begin, std::min(count, begin + BLOCK_SIZE) });
+            }
+
+            Result result;
+            result.opcode = spec.opcode;
+            result.name = spec.name;
+            result.states = count;
+            _results.push_back(result);
+
+            specs.push_back(spec);
+        }
+
+        unsigned threads = options.threads ? options.threads : default_thread_count();
+
+        std::vector<std::unique_ptr<Processor>> cpus(threads);
+        std::vector<std::unique_ptr<ReferenceCpu>> refs(threads);
+        std::mutex mutex;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        parallel_for(blocks.size(), [&](size_t index, unsigned worker)
+        {
+            if(!cpus[worker])
+            {
+                cpus[worker].reset(new Processor());
+                refs[worker].reset(new ReferenceCpu());
+            }
+
+            Processor& cpu = *cpus[worker];
+            ReferenceCpu& ref = *refs[worker];
+
+            const Block& block = blocks[index];
+            const Spec& spec = specs[block.spec];
+            uint64_t failures = 0;
+            std::vector<std::string> reports;
+
+            for(uint64_t i = block.begin; i < block.end; i ++)
+            {
+                SweepState s = make_state(spec, i);
+                load_state(spec, s, cpu, ref);
+
+                cpu.step();
+                ref.step();
+
+                std::string message;
+
+                if(spec.kind != SPEC_NONE)
+                {
+                    Expected e = expect(spec, s);
+                    uint16_t actual = e.field.read(cpu);
+                    uint8_t actual_flags = cpu.get_flags() & SF_ALL;
+
+                    if(actual != e.value)
+                    {
+                        message = "result expected " + hex(e.value, e.field.width()) + " got " + hex(actual, e.field.width());
+                    }
+                    if(actual_flags != e.flags)
+                    {
+                        message += std::string(message.empty() ? "" : ", ") + "flags expected "
+                            + hex(e.flags | 0x02, 2) + " got " + hex(actual_flags | 0x02, 2);
+                    }
+                }
+
+                std::string reference;
+                if(!DifferentialTester::compare_state(cpu, ref, reference))
+                {
+                    message += std::string(message.empty() ? "" : "; ") + "reference: " + reference;
+                }
+
+                if(message.empty())
+                {
+                    continue;
+                }
+
+                failures++;
+                if(reports.size() < options.max_reports)
+                {
+                    reports.push_back(describe(spec, s) + ": " + message);
+                }
+
+                // Keep memory in step for the following states
+                for(int w = 0; w < ref.write_count; w ++)
+                {
+                    cpu.write_mem(ref.writes[w].address, ref.writes[w].value);
+                }
+            }
+
+            if(failures)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Result& result = _results[block.spec];
+
+                result.failures += failures;
+                for(const std::string& r : reports)
+                {
+                    if(result.reports.size() < options.max_reports)
+                    {
+                        result.reports.push_back(r);
+                    }
+                }
+            }
+        }, threads);
+
+        _elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void InstructionSweep::print_report(std::ostream& out) const
+    {
+        for(const Result& r : _results)
+        {
+            if(r.failures == 0)
+            {
+                continue;
+            }
+
+            out << r.name << ": " << r.failures << " of " << r.states << " states failed\n";
+            for(const std::string& report : r.reports)
+            {
+                out << "  " << report << "\n";
+            }
+        }
+
+        uint64_t states = state_count();
+        size_t failed = std::count_if(_results.begin(), _results.end(), [](const Result& r) { return r.failures > 0; });
+
+        out << "Opcodes: " << _results.size() << ", failed: " << failed << ", states: " << states
+            << ", " << std::fixed << std::setprecision(2) << _elapsed << " s ("
+            << std::setprecision(1) << (_elapsed > 0 ? states / _elapsed / 1e6 : 0.0) << "M states/s)\n";
+        out.unsetf(std::ios_base::fixed);
+    }
+
+    uint64_t InstructionSweep::state_count() const
+    {
+        uint64_t states = 0;
+
+        for(const Result& r : _results)
+        {
+            states += r.states;
+        }
+
+        return states;
+    }
+
+    uint64_t InstructionSweep::failure_count() const
+    {
+        uint64_t failures = 0;
+
+        for(const Result& r : _results)
+        {
+            failures += r.failures;
+        }
+
+        return failures;
+    }
+
+    const std::vector<InstructionSweep::Result>& InstructionSweep::results() const
+    {
+        return _results;
+    }
+}
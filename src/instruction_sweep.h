@@ -0,0 +1,60 @@
+#pragma once
+#include "lib8085.h"
+#include "reference_cpu.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Exhaustive single instruction verification.
+     *
+     * Every opcode is executed once from each of a set of input states chosen by
+     * its class: A x operand x CY x AC for the ALU, every operand value for INR,
+     * DCR, MOV and MVI, every 16 bit value for INX, DCX and LXI, HL against a set
+     * of edge values for DAD and A x flags for everything else.
+     *
+     * Results and the five flags of the arithmetic and data moving instructions
+     * are checked against a spec written from the datasheet formulas, and the
+     * complete state of Processor is compared to ReferenceCpu after every step.
+     * Flags the instruction sets are given the opposite of their expected value
+     * beforehand, so a flag that isn't written shows up as a failure.
+     *
+     */
+    class InstructionSweep
+    {
+        public:
+            struct Options
+            {
+                unsigned threads = 0;
+                // Mismatches printed per opcode
+                size_t max_reports = 3;
+                // Only sweep opcodes whose mnemonic starts with this
+                std::string filter;
+            };
+
+            struct Result
+            {
+                InstructionSet opcode;
+                std::string name;
+                uint64_t states = 0;
+                uint64_t failures = 0;
+                std::vector<std::string> reports;
+            };
+
+            void run(const Options& options);
+            void print_report(std::ostream& out) const;
+
+            uint64_t state_count() const;
+            uint64_t failure_count() const;
+            const std::vector<Result>& results() const;
+
+        private:
+            Options _options;
+            std::vector<Result> _results;
+            double _elapsed = 0;
+    };
+}
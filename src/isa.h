@@ -0,0 +1,400 @@
+#pragma once
+#include "instruction_set.h"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace lib8085
+{
+    enum OperandKind : uint8_t
+    {
+        OPERAND_NONE,
+        OPERAND_BYTE,
+        OPERAND_WORD
+    };
+
+    // Flags an instruction can change, in PSW bit positions
+    enum IsaFlag : uint8_t
+    {
+        FLAG_CY = 0x01,
+        FLAG_P = 0x04,
+        FLAG_AC = 0x10,
+        FLAG_Z = 0x40,
+        FLAG_S = 0x80,
+        FLAGS_INR = FLAG_S | FLAG_Z | FLAG_AC | FLAG_P,
+        FLAGS_ALL = FLAGS_INR | FLAG_CY
+    };
+
+    struct IsaEntry
+    {
+        InstructionSet opcode;
+        // MOV_A_B style, the way the assembler composes it, empty for bytes without an instruction
+        std::string_view mnemonic;
+        OperandKind operand;
+        uint8_t length;
+        // T-states, taken_cycles replaces them when a conditional branch is taken
+        uint8_t cycles;
+        uint8_t taken_cycles;
+        uint8_t flags;
+    };
+
+    /*
+     * The instruction set in one constexpr table indexed by opcode byte.
+     * The assembler, the disassembler, the cpu's cycle accounting and the
+     * tools that print instructions all read it, the lookups by mnemonic
+     * and the cycle table are derived from it at compile time.
+     *
+     */
+    class Isa
+    {
+        public:
+            static constexpr size_t OPCODE_COUNT = XTHL + 1;
+
+            static constexpr IsaEntry entries[256] =
+            {
+                { ACI,       "ACI",      OPERAND_BYTE, 2,  7,  0, FLAGS_ALL },
+                { ADC_A,     "ADC_A",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADC_B,     "ADC_B",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADC_C,     "ADC_C",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADC_D,     "ADC_D",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADC_E,     "ADC_E",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADC_H,     "ADC_H",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADC_L,     "ADC_L",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADC_M,     "ADC_M",    OPERAND_NONE, 1,  7,  0, FLAGS_ALL },
+                { ADD_A,     "ADD_A",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADD_B,     "ADD_B",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADD_C,     "ADD_C",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADD_D,     "ADD_D",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADD_E,     "ADD_E",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADD_H,     "ADD_H",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADD_L,     "ADD_L",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ADD_M,     "ADD_M",    OPERAND_NONE, 1,  7,  0, FLAGS_ALL },
+                { ADI,       "ADI",      OPERAND_BYTE, 2,  7,  0, FLAGS_ALL },
+                { ANA_A,     "ANA_A",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ANA_B,     "ANA_B",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ANA_C,     "ANA_C",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ANA_D,     "ANA_D",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ANA_E,     "ANA_E",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ANA_H,     "ANA_H",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ANA_L,     "ANA_L",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ANA_M,     "ANA_M",    OPERAND_NONE, 1,  7,  0, FLAGS_ALL },
+                { ANI,       "ANI",      OPERAND_BYTE, 2,  7,  0, FLAGS_ALL },
+                { CALL,      "CALL",     OPERAND_WORD, 3, 18,  0, 0 },
+                { CC,        "CC",       OPERAND_WORD, 3,  9, 18, 0 },
+                { CM,        "CM",       OPERAND_WORD, 3,  9, 18, 0 },
+                { CMA,       "CMA",      OPERAND_NONE, 1,  4,  0, 0 },
+                { CMC,       "CMC",      OPERAND_NONE, 1,  4,  0, FLAG_CY },
+                { CMP_A,     "CMP_A",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { CMP_B,     "CMP_B",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { CMP_C,     "CMP_C",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { CMP_D,     "CMP_D",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { CMP_E,     "CMP_E",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { CMP_H,     "CMP_H",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { CMP_L,     "CMP_L",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { CMP_M,     "CMP_M",    OPERAND_NONE, 1,  7,  0, FLAGS_ALL },
+                { CNC,       "CNC",      OPERAND_WORD, 3,  9, 18, 0 },
+                { CNZ,       "CNZ",      OPERAND_WORD, 3,  9, 18, 0 },
+                { CP,        "CP",       OPERAND_WORD, 3,  9, 18, 0 },
+                { CPE,       "CPE",      OPERAND_WORD, 3,  9, 18, 0 },
+                { CPI,       "CPI",      OPERAND_BYTE, 2,  7,  0, FLAGS_ALL },
+                { CPO,       "CPO",      OPERAND_WORD, 3,  9, 18, 0 },
+                { CZ,        "CZ",       OPERAND_WORD, 3,  9, 18, 0 },
+                { DAA,       "DAA",      OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { DAD_B,     "DAD_B",    OPERAND_NONE, 1, 10,  0, FLAG_CY },
+                { DAD_D,     "DAD_D",    OPERAND_NONE, 1, 10,  0, FLAG_CY },
+                { DAD_H,     "DAD_H",    OPERAND_NONE, 1, 10,  0, FLAG_CY },
+                { DAD_SP,    "DAD_SP",   OPERAND_NONE, 1, 10,  0, FLAG_CY },
+                { DCR_A,     "DCR_A",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { DCR_B,     "DCR_B",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { DCR_C,     "DCR_C",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { DCR_D,     "DCR_D",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { DCR_E,     "DCR_E",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { DCR_H,     "DCR_H",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { DCR_L,     "DCR_L",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { DCR_M,     "DCR_M",    OPERAND_NONE, 1, 10,  0, FLAGS_INR },
+                { DCX_B,     "DCX_B",    OPERAND_NONE, 1,  6,  0, 0 },
+                { DCX_D,     "DCX_D",    OPERAND_NONE, 1,  6,  0, 0 },
+                { DCX_H,     "DCX_H",    OPERAND_NONE, 1,  6,  0, 0 },
+                { DCX_SP,    "DCX_SP",   OPERAND_NONE, 1,  6,  0, 0 },
+                { DI,        "DI",       OPERAND_NONE, 1,  4,  0, 0 },
+                { EI,        "EI",       OPERAND_NONE, 1,  4,  0, 0 },
+                { HLT,       "HLT",      OPERAND_NONE, 1,  5,  0, 0 },
+                { IN,        "IN",       OPERAND_BYTE, 2, 10,  0, 0 },
+                { INR_A,     "INR_A",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { INR_B,     "INR_B",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { INR_C,     "INR_C",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { INR_D,     "INR_D",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { INR_E,     "INR_E",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { INR_H,     "INR_H",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { INR_L,     "INR_L",    OPERAND_NONE, 1,  4,  0, FLAGS_INR },
+                { INR_M,     "INR_M",    OPERAND_NONE, 1, 10,  0, FLAGS_INR },
+                { INX_B,     "INX_B",    OPERAND_NONE, 1,  6,  0, 0 },
+                { INX_D,     "INX_D",    OPERAND_NONE, 1,  6,  0, 0 },
+                { INX_H,     "INX_H",    OPERAND_NONE, 1,  6,  0, 0 },
+                { INX_SP,    "INX_SP",   OPERAND_NONE, 1,  6,  0, 0 },
+                { JC,        "JC",       OPERAND_WORD, 3,  7, 10, 0 },
+                { JM,        "JM",       OPERAND_WORD, 3,  7, 10, 0 },
+                { JMP,       "JMP",      OPERAND_WORD, 3, 10,  0, 0 },
+                { JNC,       "JNC",      OPERAND_WORD, 3,  7, 10, 0 },
+                { JNZ,       "JNZ",      OPERAND_WORD, 3,  7, 10, 0 },
+                { JP,        "JP",       OPERAND_WORD, 3,  7, 10, 0 },
+                { JPE,       "JPE",      OPERAND_WORD, 3,  7, 10, 0 },
+                { JPO,       "JPO",      OPERAND_WORD, 3,  7, 10, 0 },
+                { JZ,        "JZ",       OPERAND_WORD, 3,  7, 10, 0 },
+                { LDA,       "LDA",      OPERAND_WORD, 3, 13,  0, 0 },
+                { LDAX_B,    "LDAX_B",   OPERAND_NONE, 1,  7,  0, 0 },
+                { LDAX_D,    "LDAX_D",   OPERAND_NONE, 1,  7,  0, 0 },
+                { LHLD,      "LHLD",     OPERAND_WORD, 3, 16,  0, 0 },
+                { LXI_B,     "LXI_B",    OPERAND_WORD, 3, 10,  0, 0 },
+                { LXI_D,     "LXI_D",    OPERAND_WORD, 3, 10,  0, 0 },
+                { LXI_H,     "LXI_H",    OPERAND_WORD, 3, 10,  0, 0 },
+                { LXI_SP,    "LXI_SP",   OPERAND_WORD, 3, 10,  0, 0 },
+                { MOV_A_A,   "MOV_A_A",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_A_B,   "MOV_A_B",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_A_C,   "MOV_A_C",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_A_D,   "MOV_A_D",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_A_E,   "MOV_A_E",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_A_H,   "MOV_A_H",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_A_L,   "MOV_A_L",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_A_M,   "MOV_A_M",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_B_A,   "MOV_B_A",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_B_B,   "MOV_B_B",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_B_C,   "MOV_B_C",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_B_D,   "MOV_B_D",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_B_E,   "MOV_B_E",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_B_H,   "MOV_B_H",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_B_L,   "MOV_B_L",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_B_M,   "MOV_B_M",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_C_A,   "MOV_C_A",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_C_B,   "MOV_C_B",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_C_C,   "MOV_C_C",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_C_D,   "MOV_C_D",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_C_E,   "MOV_C_E",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_C_H,   "MOV_C_H",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_C_L,   "MOV_C_L",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_C_M,   "MOV_C_M",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_D_A,   "MOV_D_A",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_D_B,   "MOV_D_B",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_D_C,   "MOV_D_C",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_D_D,   "MOV_D_D",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_D_E,   "MOV_D_E",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_D_H,   "MOV_D_H",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_D_L,   "MOV_D_L",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_D_M,   "MOV_D_M",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_E_A,   "MOV_E_A",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_E_B,   "MOV_E_B",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_E_C,   "MOV_E_C",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_E_D,   "MOV_E_D",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_E_E,   "MOV_E_E",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_E_H,   "MOV_E_H",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_E_L,   "MOV_E_L",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_E_M,   "MOV_E_M",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_H_A,   "MOV_H_A",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_H_B,   "MOV_H_B",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_H_C,   "MOV_H_C",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_H_D,   "MOV_H_D",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_H_E,   "MOV_H_E",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_H_H,   "MOV_H_H",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_H_L,   "MOV_H_L",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_H_M,   "MOV_H_M",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_L_A,   "MOV_L_A",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_L_B,   "MOV_L_B",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_L_C,   "MOV_L_C",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_L_D,   "MOV_L_D",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_L_E,   "MOV_L_E",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_L_H,   "MOV_L_H",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_L_L,   "MOV_L_L",  OPERAND_NONE, 1,  4,  0, 0 },
+                { MOV_L_M,   "MOV_L_M",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_M_A,   "MOV_M_A",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_M_B,   "MOV_M_B",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_M_C,   "MOV_M_C",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_M_D,   "MOV_M_D",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_M_E,   "MOV_M_E",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_M_H,   "MOV_M_H",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MOV_M_L,   "MOV_M_L",  OPERAND_NONE, 1,  7,  0, 0 },
+                { MVI_A,     "MVI_A",    OPERAND_BYTE, 2,  7,  0, 0 },
+                { MVI_B,     "MVI_B",    OPERAND_BYTE, 2,  7,  0, 0 },
+                { MVI_C,     "MVI_C",    OPERAND_BYTE, 2,  7,  0, 0 },
+                { MVI_D,     "MVI_D",    OPERAND_BYTE, 2,  7,  0, 0 },
+                { MVI_E,     "MVI_E",    OPERAND_BYTE, 2,  7,  0, 0 },
+                { MVI_H,     "MVI_H",    OPERAND_BYTE, 2,  7,  0, 0 },
+                { MVI_L,     "MVI_L",    OPERAND_BYTE, 2,  7,  0, 0 },
+                { MVI_M,     "MVI_M",    OPERAND_BYTE, 2, 10,  0, 0 },
+                { NOP,       "NOP",      OPERAND_NONE, 1,  4,  0, 0 },
+                { ORA_A,     "ORA_A",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ORA_B,     "ORA_B",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ORA_C,     "ORA_C",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ORA_D,     "ORA_D",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ORA_E,     "ORA_E",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ORA_H,     "ORA_H",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ORA_L,     "ORA_L",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { ORA_M,     "ORA_M",    OPERAND_NONE, 1,  7,  0, FLAGS_ALL },
+                { ORI,       "ORI",      OPERAND_BYTE, 2,  7,  0, FLAGS_ALL },
+                { OUT,       "OUT",      OPERAND_BYTE, 2, 10,  0, 0 },
+                { PCHL,      "PCHL",     OPERAND_NONE, 1,  6,  0, 0 },
+                { POP_B,     "POP_B",    OPERAND_NONE, 1, 10,  0, 0 },
+                { POP_D,     "POP_D",    OPERAND_NONE, 1, 10,  0, 0 },
+                { POP_H,     "POP_H",    OPERAND_NONE, 1, 10,  0, 0 },
+                { POP_PSW,   "POP_PSW",  OPERAND_NONE, 1, 10,  0, FLAGS_ALL },
+                { PUSH_B,    "PUSH_B",   OPERAND_NONE, 1, 12,  0, 0 },
+                { PUSH_D,    "PUSH_D",   OPERAND_NONE, 1, 12,  0, 0 },
+                { PUSH_H,    "PUSH_H",   OPERAND_NONE, 1, 12,  0, 0 },
+                { PUSH_PSW,  "PUSH_PSW", OPERAND_NONE, 1, 12,  0, 0 },
+                { RAL,       "RAL",      OPERAND_NONE, 1,  4,  0, FLAG_CY },
+                { RAR,       "RAR",      OPERAND_NONE, 1,  4,  0, FLAG_CY },
+                { RC,        "RC",       OPERAND_NONE, 1,  6, 12, 0 },
+                { RET,       "RET",      OPERAND_NONE, 1, 10,  0, 0 },
+                { RIM,       "RIM",      OPERAND_NONE, 1,  4,  0, 0 },
+                { RLC,       "RLC",      OPERAND_NONE, 1,  4,  0, FLAG_CY },
+                { RM,        "RM",       OPERAND_NONE, 1,  6, 12, 0 },
+                { RNC,       "RNC",      OPERAND_NONE, 1,  6, 12, 0 },
+                { RNZ,       "RNZ",      OPERAND_NONE, 1,  6, 12, 0 },
+                { RP,        "RP",       OPERAND_NONE, 1,  6, 12, 0 },
+                { RPE,       "RPE",      OPERAND_NONE, 1,  6, 12, 0 },
+                { RPO,       "RPO",      OPERAND_NONE, 1,  6, 12, 0 },
+                { RRC,       "RRC",      OPERAND_NONE, 1,  4,  0, FLAG_CY },
+                { RST_0,     "RST_0",    OPERAND_NONE, 1, 12,  0, 0 },
+                { RST_1,     "RST_1",    OPERAND_NONE, 1, 12,  0, 0 },
+                { RST_2,     "RST_2",    OPERAND_NONE, 1, 12,  0, 0 },
+                { RST_3,     "RST_3",    OPERAND_NONE, 1, 12,  0, 0 },
+                { RST_4,     "RST_4",    OPERAND_NONE, 1, 12,  0, 0 },
+                { RST_5,     "RST_5",    OPERAND_NONE, 1, 12,  0, 0 },
+                { RST_6,     "RST_6",    OPERAND_NONE, 1, 12,  0, 0 },
+                { RST_7,     "RST_7",    OPERAND_NONE, 1, 12,  0, 0 },
+                { RZ,        "RZ",       OPERAND_NONE, 1,  6, 12, 0 },
+                { SBB_A,     "SBB_A",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SBB_B,     "SBB_B",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SBB_C,     "SBB_C",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SBB_D,     "SBB_D",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SBB_E,     "SBB_E",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SBB_H,     "SBB_H",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SBB_L,     "SBB_L",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SBB_M,     "SBB_M",    OPERAND_NONE, 1,  7,  0, FLAGS_ALL },
+                { SBI,       "SBI",      OPERAND_BYTE, 2,  7,  0, FLAGS_ALL },
+                { SHLD,      "SHLD",     OPERAND_WORD, 3, 16,  0, 0 },
+                { SIM,       "SIM",      OPERAND_NONE, 1,  4,  0, 0 },
+                { SPHL,      "SPHL",     OPERAND_NONE, 1,  6,  0, 0 },
+                { STA,       "STA",      OPERAND_WORD, 3, 13,  0, 0 },
+                { STAX_B,    "STAX_B",   OPERAND_NONE, 1,  7,  0, 0 },
+                { STAX_D,    "STAX_D",   OPERAND_NONE, 1,  7,  0, 0 },
+                { STAX_H,    "STAX_H",   OPERAND_NONE, 1,  7,  0, 0 },
+                { STC,       "STC",      OPERAND_NONE, 1,  4,  0, FLAG_CY },
+                { SUB_A,     "SUB_A",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SUB_B,     "SUB_B",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SUB_C,     "SUB_C",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SUB_D,     "SUB_D",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SUB_E,     "SUB_E",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SUB_H,     "SUB_H",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SUB_L,     "SUB_L",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { SUB_M,     "SUB_M",    OPERAND_NONE, 1,  7,  0, FLAGS_ALL },
+                { SUI,       "SUI",      OPERAND_BYTE, 2,  7,  0, FLAGS_ALL },
+                { XCHG,      "XCHG",     OPERAND_NONE, 1,  4,  0, 0 },
+                { XRA_A,     "XRA_A",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { XRA_B,     "XRA_B",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { XRA_C,     "XRA_C",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { XRA_D,     "XRA_D",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { XRA_E,     "XRA_E",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { XRA_H,     "XRA_H",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { XRA_L,     "XRA_L",    OPERAND_NONE, 1,  4,  0, FLAGS_ALL },
+                { XRA_M,     "XRA_M",    OPERAND_NONE, 1,  7,  0, FLAGS_ALL },
+                { XRI,       "XRI",      OPERAND_BYTE, 2,  7,  0, FLAGS_ALL },
+                { XTHL,      "XTHL",     OPERAND_NONE, 1, 16,  0, 0 }
+            };
+
+            static constexpr const IsaEntry& entry(uint8_t opcode)
+            {
+                return entries[opcode];
+            }
+
+            static constexpr bool defined(uint8_t opcode)
+            {
+                return entries[opcode].length != 0;
+            }
+
+            // Entry for a composed mnemonic such as "MOV_A_B", nullptr when there is none
+            static constexpr const IsaEntry* find(std::string_view mnemonic)
+            {
+                size_t low = 0, high = OPCODE_COUNT;
+
+                while(low < high)
+                {
+                    size_t mid = (low + high) / 2;
+                    const IsaEntry& e = entries[by_mnemonic[mid]];
+
+                    if(e.mnemonic < mnemonic)
+                    {
+                        low = mid + 1;
+                    }
+                    else if(mnemonic < e.mnemonic)
+                    {
+                        high = mid;
+                    }
+                    else
+                    {
+                        return &e;
+                    }
+                }
+
+                return nullptr;
+            }
+
+            static constexpr std::array<uint8_t, OPCODE_COUNT> sort_by_mnemonic()
+            {
+                std::array<uint8_t, OPCODE_COUNT> order {};
+
+                for(size_t i = 0; i < OPCODE_COUNT; i ++)
+                {
+                    size_t j = i;
+                    for(; j > 0 && entries[i].mnemonic < entries[order[j - 1]].mnemonic; j --)
+                    {
+                        order[j] = order[j - 1];
+                    }
+                    order[j] = (uint8_t)i;
+                }
+
+                return order;
+            }
+
+            static constexpr std::array<uint8_t, 256> build_cycle_table()
+            {
+                std::array<uint8_t, 256> cycles {};
+
+                for(size_t i = 0; i < 256; i ++)
+                {
+                    cycles[i] = entries[i].cycles;
+                }
+
+                return cycles;
+            }
+
+            static constexpr bool consistent()
+            {
+                for(size_t i = 0; i < OPCODE_COUNT; i ++)
+                {
+                    const IsaEntry& e = entries[i];
+                    uint8_t operand_length = e.operand == OPERAND_WORD ? 2 : e.operand == OPERAND_BYTE ? 1 : 0;
+
+                    if((size_t)e.opcode != i || e.mnemonic.empty() || e.length != 1 + operand_length)
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+            // Opcodes ordered by mnemonic for find()
+            static const std::array<uint8_t, OPCODE_COUNT> by_mnemonic;
+
+            // Untaken T-states by opcode, compact for the cpu's dispatch loop
+            static const std::array<uint8_t, 256> cycle_table;
+    };
+
+    constexpr std::array<uint8_t, Isa::OPCODE_COUNT> Isa::by_mnemonic = Isa::sort_by_mnemonic();
+    constexpr std::array<uint8_t, 256> Isa::cycle_table = Isa::build_cycle_table();
+
+    static_assert(Isa::consistent(), "Isa entries must be in opcode order with lengths matching their operands");
+    static_assert(Isa::find("MOV_A_B")->opcode == MOV_A_B && Isa::find("XTHL")->opcode == XTHL && !Isa::find("MOV"),
+            "Isa mnemonic lookup is broken");
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace lib8085
+{
+    enum KeywordType : uint8_t
+    {
+        KEYWORD_NONE,
+        KEYWORD_OPCODE,
+        KEYWORD_REG
+    };
+
+    struct Keyword
+    {
+        std::string_view str;
+        KeywordType type;
+    };
+
+    /*
+     * Mnemonics and register names the assembler recognises,
+     * looked up through a perfect hash that is built and checked at compile
+     * time. Matching ignores case, finding a token is one hash and one compare.
+     *
+     * KEYWORD_SEED was searched offline so that every keyword gets its own
+     * slot, the static_assert below fails when a keyword added later collides
+     * and a new seed is needed.
+     *
+     */
+    class Keywords
+    {
+        public:
+            static constexpr size_t TABLE_SIZE = 512;
+            static constexpr uint32_t KEYWORD_SEED = 99257;
+            static constexpr uint8_t EMPTY_SLOT = 0xff;
+
+            static constexpr Keyword keywords[] =
+            {
+                { "ACI", KEYWORD_OPCODE }, { "ADC", KEYWORD_OPCODE }, { "ADD", KEYWORD_OPCODE }, { "ADI", KEYWORD_OPCODE },
+                { "ANA", KEYWORD_OPCODE }, { "ANI", KEYWORD_OPCODE }, { "CALL", KEYWORD_OPCODE }, { "CC", KEYWORD_OPCODE },
+                { "CM", KEYWORD_OPCODE }, { "CMA", KEYWORD_OPCODE }, { "CMC", KEYWORD_OPCODE }, { "CMP", KEYWORD_OPCODE },
+                { "CNC", KEYWORD_OPCODE }, { "CNZ", KEYWORD_OPCODE }, { "CP", KEYWORD_OPCODE }, { "CPE", KEYWORD_OPCODE },
+                { "CPI", KEYWORD_OPCODE }, { "CPO", KEYWORD_OPCODE }, { "CZ", KEYWORD_OPCODE }, { "DAA", KEYWORD_OPCODE },
+                { "DAD", KEYWORD_OPCODE }, { "DCR", KEYWORD_OPCODE }, { "DCX", KEYWORD_OPCODE }, { "DI", KEYWORD_OPCODE },
+                { "EI", KEYWORD_OPCODE }, { "HLT", KEYWORD_OPCODE }, { "IN", KEYWORD_OPCODE }, { "INR", KEYWORD_OPCODE },
+                { "INX", KEYWORD_OPCODE }, { "JC", KEYWORD_OPCODE }, { "JM", KEYWORD_OPCODE }, { "JMP", KEYWORD_OPCODE },
+                { "JNC", KEYWORD_OPCODE }, { "JNZ", KEYWORD_OPCODE }, { "JP", KEYWORD_OPCODE }, { "JPE", KEYWORD_OPCODE },
+                { "JPO", KEYWORD_OPCODE }, { "JZ", KEYWORD_OPCODE }, { "LDA", KEYWORD_OPCODE }, { "LDAX", KEYWORD_OPCODE },
+                { "LHLD", KEYWORD_OPCODE }, { "LXI", KEYWORD_OPCODE }, { "MOV", KEYWORD_OPCODE }, { "MVI", KEYWORD_OPCODE },
+                { "NOP", KEYWORD_OPCODE }, { "ORA", KEYWORD_OPCODE }, { "ORI", KEYWORD_OPCODE }, { "OUT", KEYWORD_OPCODE },
+                { "PCHL", KEYWORD_OPCODE }, { "POP", KEYWORD_OPCODE }, { "PUSH", KEYWORD_OPCODE }, { "RAL", KEYWORD_OPCODE },
+                { "RAR", KEYWORD_OPCODE }, { "RC", KEYWORD_OPCODE }, { "RET", KEYWORD_OPCODE }, { "RIM", KEYWORD_OPCODE },
+                { "RLC", KEYWORD_OPCODE }, { "RM", KEYWORD_OPCODE }, { "RNC", KEYWORD_OPCODE }, { "RNZ", KEYWORD_OPCODE },
+                { "RP", KEYWORD_OPCODE }, { "RPE", KEYWORD_OPCODE }, { "RPO", KEYWORD_OPCODE }, { "RRC", KEYWORD_OPCODE },
+                { "RST", KEYWORD_OPCODE }, { "RZ", KEYWORD_OPCODE }, { "SBB", KEYWORD_OPCODE }, { "SBI", KEYWORD_OPCODE },
+                { "SHLD", KEYWORD_OPCODE }, { "SIM", KEYWORD_OPCODE }, { "SPHL", KEYWORD_OPCODE }, { "STA", KEYWORD_OPCODE },
+                { "STAX", KEYWORD_OPCODE }, { "STC", KEYWORD_OPCODE }, { "SUB", KEYWORD_OPCODE }, { "SUI", KEYWORD_OPCODE },
+                { "XCHG", KEYWORD_OPCODE }, { "XRA", KEYWORD_OPCODE }, { "XRI", KEYWORD_OPCODE }, { "XTHL", KEYWORD_OPCODE },
+
+                // Restarts as the instruction tables name them
+                { "RST_0", KEYWORD_OPCODE }, { "RST_1", KEYWORD_OPCODE }, { "RST_2", KEYWORD_OPCODE }, { "RST_3", KEYWORD_OPCODE },
+                { "RST_4", KEYWORD_OPCODE }, { "RST_5", KEYWORD_OPCODE }, { "RST_6", KEYWORD_OPCODE }, { "RST_7", KEYWORD_OPCODE },
+
+                { "A", KEYWORD_REG }, { "B", KEYWORD_REG }, { "C", KEYWORD_REG }, { "D", KEYWORD_REG }, { "E", KEYWORD_REG },
+                { "H", KEYWORD_REG }, { "L", KEYWORD_REG }, { "M", KEYWORD_REG }, { "SP", KEYWORD_REG }, { "PSW", KEYWORD_REG }
+            };
+
+            static constexpr size_t KEYWORD_COUNT = sizeof(keywords) / sizeof(keywords[0]);
+            static constexpr size_t MAX_LENGTH = 5;
+
+            static constexpr char fold(char c)
+            {
+                return c >= 'a' && c <= 'z' ? (char)(c - 'a' + 'A') : c;
+            }
+
+            static constexpr uint32_t hash(std::string_view str)
+            {
+                uint32_t h = KEYWORD_SEED;
+                for(char c : str)
+                {
+                    h = (h ^ (uint8_t)fold(c)) * 16777619u;
+                }
+                return (h ^ (h >> 15)) & (TABLE_SIZE - 1);
+            }
+
+            // Type of str, KEYWORD_NONE when it isn't a keyword
+            static constexpr KeywordType find(std::string_view str)
+            {
+                if(str.empty() || str.size() > MAX_LENGTH)
+                {
+                    return KEYWORD_NONE;
+                }
+
+                uint8_t index = table[hash(str)];
+                if(index == EMPTY_SLOT)
+                {
+                    return KEYWORD_NONE;
+                }
+
+                const std::string_view key = keywords[index].str;
+                if(key.size() != str.size())
+                {
+                    return KEYWORD_NONE;
+                }
+
+                for(size_t i = 0; i < key.size(); i ++)
+                {
+                    if(fold(str[i]) != key[i])
+                    {
+                        return KEYWORD_NONE;
+                    }
+                }
+
+                return keywords[index].type;
+            }
+
+            static constexpr std::array<uint8_t, TABLE_SIZE> build_table()
+            {
+                std::array<uint8_t, TABLE_SIZE> slots {};
+                for(size_t i = 0; i < TABLE_SIZE; i ++)
+                {
+                    slots[i] = EMPTY_SLOT;
+                }
+
+                for(size_t i = 0; i < KEYWORD_COUNT; i ++)
+                {
+                    slots[hash(keywords[i].str)] = (uint8_t)i;
+                }
+
+                return slots;
+            }
+
+            static constexpr bool collision_free()
+            {
+                std::array<uint8_t, TABLE_SIZE> slots = build_table();
+
+                for(size_t i = 0; i < KEYWORD_COUNT; i ++)
+                {
+                    if(slots[hash(keywords[i].str)] != i || keywords[i].str.size() > MAX_LENGTH)
+                    {
+                        return false;
+                    }
+                }
+
+                return true;
+            }
+
+        private:
+            // Keyword index for each slot, EMPTY_SLOT where none hashes
+            static const std::array<uint8_t, TABLE_SIZE> table;
+    };
+
+    constexpr std::array<uint8_t, Keywords::TABLE_SIZE> Keywords::table = Keywords::build_table();
+
+    static_assert(Keywords::KEYWORD_COUNT < Keywords::EMPTY_SLOT, "Keyword indices must fit a table slot");
+    static_assert(Keywords::collision_free(), "Keywords collide, search a new KEYWORD_SEED");
+}
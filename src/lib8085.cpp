@@ -1,21 +1,320 @@
 #include "lib8085.h"
+#include "memory_pool.h"
+#include "profiler.h"
+#include "call_graph.h"
+#include "coverage.h"
+#include "trace.h"
+#include "isa.h"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
-#define get_hbyte(w) (w >> 8)
-#define get_lbyte(w) ((w << 8) >> 8)
+#define get_hbyte(w) (((w) >> 8) & 0xff)
+#define get_lbyte(w) ((w) & 0xff)
 
 namespace lib8085
 {
-    Processor::Processor()
+    // Every unwritten RAM page reads from here
+    static const uint8_t _zero_page[MEM_PAGE_SIZE] = {};
+
+    RomImage::RomImage(uint16_t base_address, const uint8_t* data, size_t size) : _base_address(base_address)
+    {
+        size_t max_size = (1 << 16) - base_address;
+        if(size > max_size)
+        {
+            size = max_size;
+        }
+
+        size_t pages = (size + MEM_PAGE_SIZE - 1) / MEM_PAGE_SIZE;
+        _data.assign(pages * MEM_PAGE_SIZE, 0);
+        std::copy(data, data + size, _data.begin());
+    }
+
+    uint16_t RomImage::base_address() const
+    {
+        return _base_address;
+    }
+
+    size_t RomImage::page_count() const
+    {
+        return _data.size() / MEM_PAGE_SIZE;
+    }
+
+    const uint8_t* RomImage::page(size_t index) const
+    {
+        return _data.data() + index * MEM_PAGE_SIZE;
+    }
+
+    Processor::Processor(MemoryPool* pool)
+        : _ram(nullptr), _pool(pool), _bus(nullptr), _bus_event_cycle(UINT64_MAX), _interrupt_requests(0),
+          _profiler(nullptr), _call_graph(nullptr), _coverage(nullptr), _trace(nullptr), _interrupts_serviced(0)
     {
-        mem = new uint8_t[1 << 16];
+        for(size_t page = 0; page < MEM_PAGE_COUNT; page ++)
+        {
+            _read_pages[page]  = _zero_page;
+            _write_pages[page] = nullptr;
+        }
+
         reset();
     }
 
     Processor::~Processor()
     {
-        delete mem;
+        free_ram();
+    }
+
+    Processor::Processor(Processor&& other) : _ram(nullptr), _pool(nullptr), _interrupt_requests(0), _profiler(nullptr),
+          _call_graph(nullptr), _coverage(nullptr), _trace(nullptr), _interrupts_serviced(0)
+    {
+        move_from(other);
+    }
+
+    Processor& Processor::operator=(Processor&& other)
+    {
+        if(this != &other)
+        {
+            free_ram();
+            move_from(other);
+        }
+        return *this;
+    }
+
+    void Processor::move_from(Processor& other)
+    {
+        reg_a = other.reg_a;
+        reg_b = other.reg_b;
+        reg_c = other.reg_c;
+        reg_d = other.reg_d;
+        reg_e = other.reg_e;
+        reg_h = other.reg_h;
+        reg_l = other.reg_l;
+
+        program_counter = other.program_counter;
+        stack_pointer   = other.stack_pointer;
+
+        sign            = other.sign;
+        zero            = other.zero;
+        parity          = other.parity;
+        carry           = other.carry;
+        auxiliary_carry = other.auxiliary_carry;
+
+        interrupt_enable  = other.interrupt_enable;
+        interrupt_mask    = other.interrupt_mask;
+        interrupt_pending = other.interrupt_pending;
+        serial_output     = other.serial_output;
+        halted            = other.halted;
+        cycles            = other.cycles;
+
+        // RAM and ROM pages live outside the object, only the ROM write sink has to be re-pointed
+        for(size_t page = 0; page < MEM_PAGE_COUNT; page ++)
+        {
+            _read_pages[page]  = other._read_pages[page];
+            _write_pages[page] = other.is_rom_page(page) ? _rom_write_sink : other._write_pages[page];
+        }
+
+        _ram  = other._ram;
+        _pool = other._pool;
+        _rom  = std::move(other._rom);
+        _shared_memory = std::move(other._shared_memory);
+
+        _bus               = other._bus;
+        _bus_event_cycle   = other._bus_event_cycle;
+        _interrupt_shadow  = other._interrupt_shadow;
+        _interrupt_requests.store(other._interrupt_requests.exchange(0));
+        _profiler          = other._profiler;
+        _call_graph        = other._call_graph;
+        _coverage          = other._coverage;
+        _trace             = other._trace;
+
+        // Leave other as an empty, reset processor
+        other._ram = nullptr;
+        other._bus = nullptr;
+        other._profiler = nullptr;
+        other._call_graph = nullptr;
+        other._coverage = nullptr;
+        other._trace = nullptr;
+        other._bus_event_cycle = UINT64_MAX;
+        for(size_t page = 0; page < MEM_PAGE_COUNT; page ++)
+        {
+            other.release_page(page);
+        }
+        other.reset();
+    }
+
+    void Processor::free_ram()
+    {
+        if(!_ram)
+        {
+            return;
+        }
+
+        if(_pool)
+        {
+            _pool->release(_ram);
+        }
+        else
+        {
+            delete[] _ram;
+        }
+
+        _ram = nullptr;
+    }
+
+    uint8_t* Processor::materialize_page(size_t page, const uint8_t* contents)
+    {
+        if(!_ram)
+        {
+            _ram = _pool ? _pool->acquire() : new uint8_t[1 << 16];
+        }
+
+        uint8_t* storage = _ram + page * MEM_PAGE_SIZE;
+
+        // Unused pages read the zero page, shared ones their savestate page
+        const uint8_t* source = contents ? contents : _read_pages[page];
+        std::copy(source, source + MEM_PAGE_SIZE, storage);
+
+        _read_pages[page]  = storage;
+        _write_pages[page] = storage;
+
+        return storage;
+    }
+
+    void Processor::share_page(size_t page, const uint8_t* contents)
+    {
+        _read_pages[page]  = contents;
+        _write_pages[page] = nullptr;
+    }
+
+    void Processor::release_page(size_t page)
+    {
+        _read_pages[page]  = _zero_page;
+        _write_pages[page] = nullptr;
+    }
+
+    void Processor::release_ram_pages()
+    {
+        for(size_t page = 0; page < MEM_PAGE_COUNT; page ++)
+        {
+            if(is_ram_page_used(page))
+            {
+                release_page(page);
+            }
+        }
+    }
+
+    bool Processor::map_rom(std::shared_ptr<const RomImage> rom)
+    {
+        if(!rom || rom->base_address() % MEM_PAGE_SIZE != 0)
+        {
+            return false;
+        }
+
+        unmap_rom();
+
+        size_t first = rom->base_address() / MEM_PAGE_SIZE;
+        for(size_t i = 0; i < rom->page_count(); i ++)
+        {
+            _read_pages[first + i]  = rom->page(i);
+            _write_pages[first + i] = _rom_write_sink;
+        }
+
+        _rom = rom;
+        return true;
+    }
+
+    void Processor::unmap_rom()
+    {
+        if(!_rom)
+        {
+            return;
+        }
+
+        size_t first = _rom->base_address() / MEM_PAGE_SIZE;
+        for(size_t i = 0; i < _rom->page_count(); i ++)
+        {
+            release_page(first + i);
+        }
+
+        _rom.reset();
+    }
+
+    bool Processor::is_rom_page(size_t page) const
+    {
+        return _write_pages[page] == _rom_write_sink;
+    }
+
+    bool Processor::is_ram_page_used(size_t page) const
+    {
+        return _read_pages[page] != _zero_page && !is_rom_page(page);
+    }
+
+    const uint8_t* Processor::get_page(size_t page) const
+    {
+        return _read_pages[page];
+    }
+
+    void Processor::load_memory(uint16_t address, const uint8_t* data, size_t size)
+    {
+        for(size_t i = 0; i < size; i ++)
+        {
+            write_mem((uint16_t)(address + i), data[i]);
+        }
+    }
+
+    void Processor::attach_bus(IoBus* bus)
+    {
+        _bus = bus;
+        _bus_event_cycle = _bus ? _bus->next_event_cycle() : UINT64_MAX;
+    }
+
+    IoBus* Processor::get_bus() const
+    {
+        return _bus;
+    }
+
+    void Processor::attach_profiler(Profiler* profiler)
+    {
+        _profiler = profiler;
+    }
+
+    Profiler* Processor::get_profiler() const
+    {
+        return _profiler;
+    }
+
+    void Processor::attach_call_graph(CallGraph* call_graph)
+    {
+        _call_graph = call_graph;
+    }
+
+    CallGraph* Processor::get_call_graph() const
+    {
+        return _call_graph;
+    }
+
+    void Processor::attach_coverage(Coverage* coverage)
+    {
+        _coverage = coverage;
+    }
+
+    Coverage* Processor::get_coverage() const
+    {
+        return _coverage;
+    }
+
+    void Processor::attach_trace(TraceWriter* trace)
+    {
+        _trace = trace;
+    }
+
+    TraceWriter* Processor::get_trace() const
+    {
+        return _trace;
+    }
+
+    void Processor::raise_interrupt(uint8_t lines)
+    {
+        _interrupt_requests.fetch_or(lines, std::memory_order_relaxed);
     }
 
     void Processor::reset()
@@ -31,21 +330,29 @@ namespace lib8085
         stack_pointer   = 0;
         program_counter = 0;
 
-        for(int i = 0; i < (1 << 16); i ++)
-        {
-            mem[i] = 0;
-        }
+        release_ram_pages();
+        _shared_memory.reset();
 
         sign   = false;
         zero   = false;
         parity = false;
         carry  = false;
         auxiliary_carry = false;
+
+        interrupt_enable  = false;
+        interrupt_mask    = 0x07;
+        interrupt_pending = 0;
+        serial_output     = false;
+        halted            = false;
+        _interrupt_shadow = false;
+        _interrupt_requests.store(0);
+
+        cycles = 0;
     }
 
     uint8_t Processor::get_imm()
     {
-        return mem[program_counter++];
+        return read_mem(program_counter++);
     }
 
     uint16_t Processor::get_word(uint8_t a, uint8_t b)
@@ -59,41 +366,222 @@ namespace lib8085
 
     uint16_t Processor::get_imm_16()
     {
-        uint8_t b = mem[program_counter++];
-        uint8_t a = mem[program_counter++];
+        uint8_t b = read_mem(program_counter++);
+        uint8_t a = read_mem(program_counter++);
         return get_word(a, b);
     }
 
     void Processor::push_stack(uint8_t val)
     {
-        mem[--stack_pointer] = val;
+        write_mem(--stack_pointer, val);
     }
 
     void Processor::push_stack_16(uint16_t val)
     {
-        mem[--stack_pointer] = get_lbyte(val);
-        mem[--stack_pointer] = get_hbyte(val);
+        // Low byte ends up at the lower address
+        write_mem(--stack_pointer, get_hbyte(val));
+        write_mem(--stack_pointer, get_lbyte(val));
     }
 
     uint8_t Processor::pop_stack()
     {
-        return mem[stack_pointer++];
+        return read_mem(stack_pointer++);
     }
 
     uint16_t Processor::pop_stack_16()
     {
-        return get_word(mem[stack_pointer++], mem[stack_pointer++]);
+        uint8_t low = read_mem(stack_pointer++);
+        uint8_t high = read_mem(stack_pointer++);
+
+        return get_word(high, low);
     }
 
     void Processor::exec(int no_of_instructions)
     {
-        uint16_t op_code = mem[program_counter++];
+        for(int i = 0; i < no_of_instructions; i ++)
+        {
+            step();
+        }
+    }
+
+    uint64_t Processor::run(uint64_t max_instructions, uint64_t max_cycles)
+    {
+        uint64_t executed = 0;
+        uint64_t end_cycle = cycles + max_cycles < cycles ? UINT64_MAX : cycles + max_cycles;
+
+        if(_profiler || _call_graph || _coverage || _trace)
+        {
+            if(_call_graph)
+            {
+                _call_graph->begin(program_counter, cycles);
+            }
+            if(_trace)
+            {
+                _trace->begin(*this);
+            }
+
+            // Kept apart so the plain loop pays nothing for profiling
+            while(executed < max_instructions && cycles < end_cycle && !halted)
+            {
+                uint16_t address = program_counter;
+                uint16_t sp = stack_pointer;
+                uint8_t opcode = read_mem(address);
+                uint64_t start = cycles;
+                uint64_t interrupts = _interrupts_serviced;
+
+                step();
+                executed++;
+
+                // An interrupt entry runs instead of the instruction at address
+                bool interrupted = interrupts != _interrupts_serviced;
+
+                if(_profiler && !interrupted)
+                {
+                    _profiler->record(address, opcode, cycles - start);
+                }
+                if(_call_graph)
+                {
+                    _call_graph->step(*this, opcode, sp, interrupted);
+                }
+                if(_coverage && !interrupted)
+                {
+                    _coverage->record(address, opcode, program_counter);
+                }
+                if(_trace)
+                {
+                    _trace->record(*this, address, opcode, sp, interrupted);
+                }
+            }
+
+            if(_call_graph)
+            {
+                _call_graph->end(cycles);
+            }
+
+            return executed;
+        }
+
+        while(executed < max_instructions && cycles < end_cycle && !halted)
+        {
+            step();
+            executed++;
+        }
+
+        return executed;
+    }
+
+    void Processor::latch_interrupts()
+    {
+        uint8_t raised = _interrupt_requests.exchange(0, std::memory_order_relaxed);
+
+        if(_bus)
+        {
+            raised = _bus->interrupts(cycles, raised);
+            _bus_event_cycle = _bus->next_event_cycle();
+        }
+
+        interrupt_pending |= raised;
+    }
+
+    bool Processor::service_interrupts()
+    {
+        uint16_t address;
+
+        if(interrupt_pending & INT_TRAP)
+        {
+            // Non maskable
+            interrupt_pending &= ~INT_TRAP;
+            address = 0x24;
+        }
+        else
+        {
+            if(!interrupt_enable || _interrupt_shadow)
+            {
+                return false;
+            }
+
+            uint8_t unmasked = interrupt_pending & ~(interrupt_mask & 0x07);
+
+            if(unmasked & INT_RST7_5)
+            {
+                interrupt_pending &= ~INT_RST7_5;
+                address = 0x3c;
+            }
+            else if(unmasked & INT_RST6_5)
+            {
+                interrupt_pending &= ~INT_RST6_5;
+                address = 0x34;
+            }
+            else if(unmasked & INT_RST5_5)
+            {
+                interrupt_pending &= ~INT_RST5_5;
+                address = 0x2c;
+            }
+            else if(unmasked & INT_INTR)
+            {
+                interrupt_pending &= ~INT_INTR;
+                uint8_t rst = 7;
+
+                if(_bus)
+                {
+                    rst = _bus->acknowledge() & 0x07;
+                    _bus_event_cycle = _bus->next_event_cycle();
+                }
+
+                address = rst * 8;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        interrupt_enable = false;
+        cycles += 12;
+        restart(address);
+        _interrupts_serviced++;
+
+        return true;
+    }
+
+    void Processor::restart(uint16_t address)
+    {
+        halted = false;
+        push_stack_16(program_counter);
+        program_counter = address;
+    }
+
+    void Processor::step()
+    {
+        if(cycles >= _bus_event_cycle || _interrupt_requests.load(std::memory_order_relaxed))
+        {
+            latch_interrupts();
+        }
+
+        if(interrupt_pending && service_interrupts())
+        {
+            return;
+        }
+
+        _interrupt_shadow = false;
+
+        if(halted)
+        {
+            // Idle until an interrupt wakes the cpu up
+            cycles++;
+            return;
+        }
+
+        uint16_t op_code = read_mem(program_counter++);
+        // Conditional jumps, calls and returns add the extra cycles of the taken path when they branch
+        cycles += Isa::cycle_table[op_code];
 
         switch(op_code)
         {
             case ACI:
                 {
                     uint8_t operand = get_imm();
+
                     add(operand, true);
                 }
                 break;
@@ -134,8 +622,7 @@ namespace lib8085
                 break;
             case ADC_M:
                 {
-                    uint16_t hl = get_word(reg_h, reg_l);
-                    uint8_t operand = mem[hl];
+                    uint8_t operand = read_mem(get_word(reg_h, reg_l));
 
                     add(operand, true);
                 }
@@ -177,128 +664,73 @@ namespace lib8085
                 break;
             case ADD_M:
                 {
-                    uint16_t hl = get_word(reg_h, reg_l);
-                    uint8_t operand = mem[hl];
+                    uint8_t operand = read_mem(get_word(reg_h, reg_l));
 
                     add(operand, false);
                 }
                 break;
             case ADI:
                 {
-                    uint8_t addend = get_imm();
+                    uint8_t operand = get_imm();
 
-                    add(addend, false);
+                    add(operand, false);
                 }
                 break;
             case ANA_A:
                 {
-                    reg_a &= reg_a;
-
-                    sign = reg_a < 0 ? true : false;
-                    zero = reg_a == 0 ? true : false;
-
-                    carry = false;
-                    auxiliary_carry = false;
+                    ana(reg_a);
                 }
                 break;
             case ANA_B:
                 {
-                    reg_a &= reg_b;
-
-                    sign = reg_a < 0 ? true : false;
-                    zero = reg_a == 0 ? true : false;
-
-                    carry = false;
-                    auxiliary_carry = false;
+                    ana(reg_b);
                 }
                 break;
             case ANA_C:
                 {
-                    reg_a &= reg_c;
-
-                    sign = reg_a < 0 ? true : false;
-                    zero = reg_a == 0 ? true : false;
-
-                    carry = false;
-                    auxiliary_carry = false;
+                    ana(reg_c);
                 }
                 break;
             case ANA_D:
                 {
-                    reg_a &= reg_d;
-
-                    sign = reg_a < 0 ? true : false;
-                    zero = reg_a == 0 ? true : false;
-
-                    carry = false;
-                    auxiliary_carry = false;
+                    ana(reg_d);
                 }
                 break;
             case ANA_E:
                 {
-                    reg_a &= reg_e;
-
-                    sign = reg_a < 0 ? true : false;
-                    zero = reg_a == 0 ? true : false;
-
-                    carry = false;
-                    auxiliary_carry = false;
+                    ana(reg_e);
                 }
                 break;
             case ANA_H:
                 {
-                    reg_a &= reg_h;
-
-                    sign = reg_a < 0 ? true : false;
-                    zero = reg_a == 0 ? true : false;
-
-                    carry = false;
-                    auxiliary_carry = false;
+                    ana(reg_h);
                 }
                 break;
             case ANA_L:
                 {
-                    reg_a &= reg_l;
-
-                    sign = reg_a < 0 ? true : false;
-                    zero = reg_a == 0 ? true : false;
-
-                    carry = false;
-                    auxiliary_carry = false;
+                    ana(reg_l);
                 }
                 break;
             case ANA_M:
                 {
-                    uint16_t hl = get_word(reg_h, reg_l);
-                    uint8_t operand = mem[hl];
-
-                    reg_a &= operand;
-
-                    sign = reg_a < 0 ? true : false;
-                    zero = reg_a == 0 ? true : false;
+                    uint8_t operand = read_mem(get_word(reg_h, reg_l));
 
-                    carry = false;
-                    auxiliary_carry = false;
+                    ana(operand);
                 }
                 break;
             case ANI:
                 {
-                    reg_a &= get_imm();
-
-                    sign = reg_a < 0 ? true : false;
-                    zero = reg_a == 0 ? true : false;
+                    uint8_t operand = get_imm();
 
-                    carry = false;
-                    auxiliary_carry = false;
+                    ana(operand);
                 }
                 break;
             case CALL:
                 {
                     uint16_t address = get_imm_16();
-                    uint16_t next_ins = program_counter + 1;
-                    program_counter = address;
 
-                    push_stack_16(next_ins);
+                    push_stack_16(program_counter);
+                    program_counter = address;
                 }
                 break;
             case CC:
@@ -306,10 +738,10 @@ namespace lib8085
                     if(carry)
                     {
                         uint16_t address = get_imm_16();
-                        uint16_t next_ins = program_counter + 1;
-                        program_counter = address;
 
-                        push_stack_16(next_ins);
+                        push_stack_16(program_counter);
+                        program_counter = address;
+                        cycles += 9;
                     }
                     else
                     {
@@ -317,10 +749,26 @@ namespace lib8085
                     }
                 }
                 break;
-            case CMA:
-                {
-                    reg_a ^= 11111111;
+            // Call on minus
+            case CM:
+                {
+                    if(sign)
+                    {
+                        uint16_t address = get_imm_16();
 
+                        push_stack_16(program_counter);
+                        program_counter = address;
+                        cycles += 9;
+                    }
+                    else
+                    {
+                        program_counter += 2;
+                    }
+                }
+                break;
+            case CMA:
+                {
+                    reg_a = ~reg_a;
                 }
                 break;
             case CMC:
@@ -330,7 +778,7 @@ namespace lib8085
                 break;
             case CMP_A:
                 {
-                    zero = true;
+                    cmp(reg_a, reg_a);
                 }
                 break;
             case CMP_B:
@@ -365,8 +813,7 @@ namespace lib8085
                 break;
             case CMP_M:
                 {
-                    uint16_t hl = get_word(reg_h, reg_l);
-                    uint8_t operand = mem[hl];
+                    uint8_t operand = read_mem(get_word(reg_h, reg_l));
 
                     cmp(reg_a, operand);
                 }
@@ -376,10 +823,10 @@ namespace lib8085
                     if(!carry)
                     {
                         uint16_t address = get_imm_16();
-                        uint16_t next_ins = program_counter + 1;
-                        program_counter = address;
 
-                        push_stack_16(next_ins);
+                        push_stack_16(program_counter);
+                        program_counter = address;
+                        cycles += 9;
                     }
                     else
                     {
@@ -392,10 +839,10 @@ namespace lib8085
                     if(!zero)
                     {
                         uint16_t address = get_imm_16();
-                        uint16_t next_ins = program_counter + 1;
-                        program_counter = address;
 
-                        push_stack_16(next_ins);
+                        push_stack_16(program_counter);
+                        program_counter = address;
+                        cycles += 9;
                     }
                     else
                     {
@@ -408,43 +855,10 @@ namespace lib8085
                     if(!sign)
                     {
                         uint16_t address = get_imm_16();
-                        uint16_t next_ins = program_counter + 1;
-                        program_counter = address;
 
-                        push_stack_16(next_ins);
-                    }
-                    else
-                    {
-                        program_counter += 2;
-                    }
-                }
-                break;
-            // Call on minus
-            case CM:
-                {
-                    if(sign)
-                    {
-                        uint16_t address = get_imm_16();
-                        uint16_t next_ins = program_counter + 1;
+                        push_stack_16(program_counter);
                         program_counter = address;
-
-                        push_stack_16(next_ins);
-                    }
-                    else
-                    {
-                        program_counter += 2;
-                    }
-                }
-                break;
-            case CZ:
-                {
-                    if(zero)
-                    {
-                        uint16_t address = get_imm_16();
-                        uint16_t next_ins = program_counter + 1;
-                        program_counter = address;
-
-                        push_stack_16(next_ins);
+                        cycles += 9;
                     }
                     else
                     {
@@ -457,10 +871,10 @@ namespace lib8085
                     if(parity)
                     {
                         uint16_t address = get_imm_16();
-                        uint16_t next_ins = program_counter + 1;
-                        program_counter = address;
 
-                        push_stack_16(next_ins);
+                        push_stack_16(program_counter);
+                        program_counter = address;
+                        cycles += 9;
                     }
                     else
                     {
@@ -480,10 +894,10 @@ namespace lib8085
                     if(!parity)
                     {
                         uint16_t address = get_imm_16();
-                        uint16_t next_ins = program_counter + 1;
-                        program_counter = address;
 
-                        push_stack_16(next_ins);
+                        push_stack_16(program_counter);
+                        program_counter = address;
+                        cycles += 9;
                     }
                     else
                     {
@@ -491,486 +905,719 @@ namespace lib8085
                     }
                 }
                 break;
-            case DAA:
+            case CZ:
                 {
-                    uint8_t msn = (reg_a & 11110000) >> 4;
-                    uint8_t lsn = reg_a >> 4;
-
-                    if(lsn > 9)
+                    if(zero)
                     {
-                        auxiliary_carry = true;
-                        lsn += 6;
-                    }
+                        uint16_t address = get_imm_16();
 
-                    if(msn > 9 || carry)
+                        push_stack_16(program_counter);
+                        program_counter = address;
+                        cycles += 9;
+                    }
+                    else
                     {
-                        msn += 6;
+                        program_counter += 2;
                     }
-
+                }
+                break;
+            case DAA:
+                {
+                    daa();
                 }
                 break;
             case DAD_B:
                 {
-                    uint16_t res = reg_b;
-                    res <<= 4;
-                    res |= reg_c;
-
-                    uint16_t hl = reg_h;
-                    hl <<= 4;
-                    hl |= reg_l;
-
-                    res += hl;
-                    reg_h = res >> 4;
-                    reg_l = (res << 4) >> 4;
+                    dad(get_word(reg_b, reg_c));
                 }
                 break;
             case DAD_D:
                 {
-                    uint16_t res = reg_d;
-                    res <<= 4;
-                    res |= reg_e;
-
-                    uint16_t hl = reg_h;
-                    hl <<= 4;
-                    hl |= reg_l;
-
-                    res += hl;
-                    reg_h = res >> 4;
-                    reg_l = (res << 4) >> 4;
+                    dad(get_word(reg_d, reg_e));
                 }
                 break;
             case DAD_H:
                 {
-                    uint16_t res = reg_h;
-                    res <<= 4;
-                    res |= reg_l;
-
-                    res = res * 2;
-                    reg_h = res >> 4;
-                    reg_l = (res << 4) >> 4;
+                    dad(get_word(reg_h, reg_l));
                 }
                 break;
             case DAD_SP:
                 {
-                    uint16_t res = reg_h;
-                    res <<= 4;
-                    res |= reg_l;
-
-                    res = stack_pointer + res;
-                    reg_h = res >> 4;
-                    reg_l = (res << 4) >> 4;
+                    dad(stack_pointer);
                 }
                 break;
             case DCR_A:
                 {
-                    reg_a--;
+                    reg_a = dcr(reg_a);
                 }
                 break;
             case DCR_B:
                 {
-                    reg_b--;
+                    reg_b = dcr(reg_b);
                 }
                 break;
             case DCR_C:
                 {
-                    reg_c--;
+                    reg_c = dcr(reg_c);
                 }
                 break;
             case DCR_D:
                 {
-                    reg_d--;
+                    reg_d = dcr(reg_d);
                 }
                 break;
             case DCR_E:
                 {
-                    reg_e--;
+                    reg_e = dcr(reg_e);
                 }
                 break;
             case DCR_H:
                 {
-                    reg_h--;
+                    reg_h = dcr(reg_h);
                 }
                 break;
             case DCR_L:
                 {
-                    reg_l--;
+                    reg_l = dcr(reg_l);
                 }
                 break;
             case DCR_M:
                 {
                     uint16_t hl = get_word(reg_h, reg_l);
-                    uint8_t address = mem[hl];
-
-                    mem[address]--;
+                    write_mem(hl, dcr(read_mem(hl)));
                 }
                 break;
             case DCX_B:
                 {
-                    uint16_t rp = reg_b;
-                    rp <<= 4;
-                    rp |= reg_c;
+                    uint16_t rp = get_word(reg_b, reg_c) - 1;
 
-                    rp --;
-                    reg_b = rp >> 4;
-                    reg_c = (rp << 4) >> 4;
+                    reg_b = rp >> 8;
+                    reg_c = rp & 0xff;
                 }
                 break;
             case DCX_D:
                 {
-                    uint16_t rp = reg_d;
-                    rp <<= 4;
-                    rp |= reg_e;
+                    uint16_t rp = get_word(reg_d, reg_e) - 1;
 
-                    rp --;
-                    reg_d = rp >> 4;
-                    reg_e = (rp << 4) >> 4;
+                    reg_d = rp >> 8;
+                    reg_e = rp & 0xff;
                 }
                 break;
             case DCX_H:
                 {
-                    uint16_t rp = reg_h;
-                    rp <<= 4;
-                    rp |= reg_l;
+                    uint16_t rp = get_word(reg_h, reg_l) - 1;
 
-                    rp --;
-                    reg_h = rp >> 4;
-                    reg_l = (rp << 4) >> 4;
+                    reg_h = rp >> 8;
+                    reg_l = rp & 0xff;
                 }
                 break;
             case DCX_SP:
                 {
-                    stack_pointer --;
+                    stack_pointer -= 1;
                 }
                 break;
             case DI:
                 {
-                    throw std::exception("Not implemented yet");
+                    interrupt_enable = false;
                 }
                 break;
             case EI:
                 {
-                    throw std::exception("Not implemented yet");
+                    // Interrupts are accepted after the instruction following EI
+                    interrupt_enable = true;
+                    _interrupt_shadow = true;
                 }
                 break;
             case HLT:
                 {
-                    throw std::exception("Not implemented yet");
+                    halted = true;
                 }
                 break;
             case IN:
                 {
                     uint8_t operand = get_imm();
-                    throw std::exception("Not implemented yet");
+
+                    if(_bus)
+                    {
+                        reg_a = _bus->in(operand);
+                        _bus_event_cycle = _bus->next_event_cycle();
+                    }
+                    else
+                    {
+                        // Nothing is driving the data bus
+                        reg_a = 0xff;
+                    }
                 }
                 break;
             case INR_A:
                 {
-                    reg_a++;
+                    reg_a = inr(reg_a);
                 }
                 break;
             case INR_B:
                 {
-                    reg_b++;
+                    reg_b = inr(reg_b);
                 }
                 break;
             case INR_C:
                 {
-                    reg_c++;
+                    reg_c = inr(reg_c);
                 }
                 break;
             case INR_D:
                 {
-                    reg_d++;
+                    reg_d = inr(reg_d);
                 }
                 break;
             case INR_E:
                 {
-                    reg_e++;
+                    reg_e = inr(reg_e);
                 }
                 break;
             case INR_H:
                 {
-                    reg_h++;
+                    reg_h = inr(reg_h);
                 }
                 break;
             case INR_L:
                 {
-                    reg_l++;
+                    reg_l = inr(reg_l);
                 }
                 break;
             case INR_M:
                 {
-                    uint16_t hl = get_word(reg_h, reg_l);
-                    uint8_t address = mem[hl];
-
-                    mem[address]++;
+                    uint16_t hl = get_word(reg_h, reg_l);
+                    write_mem(hl, inr(read_mem(hl)));
+                }
+                break;
+            case INX_B:
+                {
+                    uint16_t rp = get_word(reg_b, reg_c) + 1;
+
+                    reg_b = rp >> 8;
+                    reg_c = rp & 0xff;
+                }
+                break;
+            case INX_D:
+                {
+                    uint16_t rp = get_word(reg_d, reg_e) + 1;
+
+                    reg_d = rp >> 8;
+                    reg_e = rp & 0xff;
+                }
+                break;
+            case INX_H:
+                {
+                    uint16_t rp = get_word(reg_h, reg_l) + 1;
+
+                    reg_h = rp >> 8;
+                    reg_l = rp & 0xff;
+                }
+                break;
+            case INX_SP:
+                {
+                    stack_pointer += 1;
+                }
+                break;
+            case JC:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    if(carry)
+                    {
+                        program_counter = operand;
+                        cycles += 3;
+                    }
+                }
+                break;
+            case JM:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    if(sign)
+                    {
+                        program_counter = operand;
+                        cycles += 3;
+                    }
+                }
+                break;
+            case JMP:
+                {
+                    program_counter = get_imm_16();
+                }
+                break;
+            case JNC:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    if(!carry)
+                    {
+                        program_counter = operand;
+                        cycles += 3;
+                    }
+                }
+                break;
+            case JNZ:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    if(!zero)
+                    {
+                        program_counter = operand;
+                        cycles += 3;
+                    }
+                }
+                break;
+            case JP:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    if(!sign)
+                    {
+                        program_counter = operand;
+                        cycles += 3;
+                    }
+                }
+                break;
+            case JPE:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    if(parity)
+                    {
+                        program_counter = operand;
+                        cycles += 3;
+                    }
+                }
+                break;
+            case JPO:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    if(!parity)
+                    {
+                        program_counter = operand;
+                        cycles += 3;
+                    }
+                }
+                break;
+            case JZ:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    if(zero)
+                    {
+                        program_counter = operand;
+                        cycles += 3;
+                    }
+                }
+                break;
+            case LDA:
+                {
+                    reg_a = read_mem(get_imm_16());
+                }
+                break;
+            case LDAX_B:
+                {
+                    reg_a = read_mem(get_word(reg_b, reg_c));
+                }
+                break;
+            case LDAX_D:
+                {
+                    reg_a = read_mem(get_word(reg_d, reg_e));
+                }
+                break;
+            case LHLD:
+                {
+                    uint16_t address = get_imm_16();
+
+                    reg_l = read_mem(address);
+                    reg_h = read_mem(address + 1);
+                }
+                break;
+            case LXI_B:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    reg_b = operand >> 8;
+                    reg_c = operand & 0xff;
+                }
+                break;
+            case LXI_D:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    reg_d = operand >> 8;
+                    reg_e = operand & 0xff;
+                }
+                break;
+            case LXI_H:
+                {
+                    uint16_t operand = get_imm_16();
+
+                    reg_h = operand >> 8;
+                    reg_l = operand & 0xff;
+                }
+                break;
+            case LXI_SP:
+                {
+                    stack_pointer = get_imm_16();
+                }
+                break;
+            case MOV_A_A:
+                {
+                    reg_a = reg_a;
+                }
+                break;
+            case MOV_A_B:
+                {
+                    reg_a = reg_b;
+                }
+                break;
+            case MOV_A_C:
+                {
+                    reg_a = reg_c;
+                }
+                break;
+            case MOV_A_D:
+                {
+                    reg_a = reg_d;
+                }
+                break;
+            case MOV_A_E:
+                {
+                    reg_a = reg_e;
+                }
+                break;
+            case MOV_A_H:
+                {
+                    reg_a = reg_h;
+                }
+                break;
+            case MOV_A_L:
+                {
+                    reg_a = reg_l;
+                }
+                break;
+            case MOV_A_M:
+                {
+                    reg_a = read_mem(get_word(reg_h, reg_l));
+                }
+                break;
+            case MOV_B_A:
+                {
+                    reg_b = reg_a;
+                }
+                break;
+            case MOV_B_B:
+                {
+                    reg_b = reg_b;
+                }
+                break;
+            case MOV_B_C:
+                {
+                    reg_b = reg_c;
+                }
+                break;
+            case MOV_B_D:
+                {
+                    reg_b = reg_d;
+                }
+                break;
+            case MOV_B_E:
+                {
+                    reg_b = reg_e;
+                }
+                break;
+            case MOV_B_H:
+                {
+                    reg_b = reg_h;
+                }
+                break;
+            case MOV_B_L:
+                {
+                    reg_b = reg_l;
+                }
+                break;
+            case MOV_B_M:
+                {
+                    reg_b = read_mem(get_word(reg_h, reg_l));
+                }
+                break;
+            case MOV_C_A:
+                {
+                    reg_c = reg_a;
+                }
+                break;
+            case MOV_C_B:
+                {
+                    reg_c = reg_b;
+                }
+                break;
+            case MOV_C_C:
+                {
+                    reg_c = reg_c;
+                }
+                break;
+            case MOV_C_D:
+                {
+                    reg_c = reg_d;
+                }
+                break;
+            case MOV_C_E:
+                {
+                    reg_c = reg_e;
+                }
+                break;
+            case MOV_C_H:
+                {
+                    reg_c = reg_h;
+                }
+                break;
+            case MOV_C_L:
+                {
+                    reg_c = reg_l;
+                }
+                break;
+            case MOV_C_M:
+                {
+                    reg_c = read_mem(get_word(reg_h, reg_l));
+                }
+                break;
+            case MOV_D_A:
+                {
+                    reg_d = reg_a;
+                }
+                break;
+            case MOV_D_B:
+                {
+                    reg_d = reg_b;
+                }
+                break;
+            case MOV_D_C:
+                {
+                    reg_d = reg_c;
+                }
+                break;
+            case MOV_D_D:
+                {
+                    reg_d = reg_d;
+                }
+                break;
+            case MOV_D_E:
+                {
+                    reg_d = reg_e;
+                }
+                break;
+            case MOV_D_H:
+                {
+                    reg_d = reg_h;
+                }
+                break;
+            case MOV_D_L:
+                {
+                    reg_d = reg_l;
+                }
+                break;
+            case MOV_D_M:
+                {
+                    reg_d = read_mem(get_word(reg_h, reg_l));
+                }
+                break;
+            case MOV_E_A:
+                {
+                    reg_e = reg_a;
+                }
+                break;
+            case MOV_E_B:
+                {
+                    reg_e = reg_b;
+                }
+                break;
+            case MOV_E_C:
+                {
+                    reg_e = reg_c;
+                }
+                break;
+            case MOV_E_D:
+                {
+                    reg_e = reg_d;
+                }
+                break;
+            case MOV_E_E:
+                {
+                    reg_e = reg_e;
                 }
                 break;
-            case INX_B:
+            case MOV_E_H:
                 {
-                    uint16_t rp = reg_b;
-                    rp <<= 4;
-                    rp |= reg_c;
-
-                    rp ++;
-                    reg_b = rp >> 4;
-                    reg_c = (rp << 4) >> 4;
+                    reg_e = reg_h;
                 }
                 break;
-            case INX_D:
+            case MOV_E_L:
                 {
-                    uint16_t rp = reg_d;
-                    rp <<= 4;
-                    rp |= reg_e;
-
-                    rp ++;
-                    reg_d = rp >> 4;
-                    reg_e = (rp << 4) >> 4;
+                    reg_e = reg_l;
                 }
                 break;
-            case INX_H:
+            case MOV_E_M:
                 {
-                    uint16_t rp = reg_h;
-                    rp <<= 4;
-                    rp |= reg_l;
-
-                    rp ++;
-                    reg_h = rp >> 4;
-                    reg_l = (rp << 4) >> 4;
+                    reg_e = read_mem(get_word(reg_h, reg_l));
                 }
                 break;
-            case INX_SP:
+            case MOV_H_A:
                 {
-                    stack_pointer ++;
+                    reg_h = reg_a;
                 }
                 break;
-            case JC:
+            case MOV_H_B:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    if(carry)
-                    {
-                        program_counter = operand;
-                    }
+                    reg_h = reg_b;
                 }
                 break;
-            case JNC:
+            case MOV_H_C:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    if(!carry)
-                    {
-                        program_counter = operand;
-                    }
+                    reg_h = reg_c;
                 }
                 break;
-            case JP:
+            case MOV_H_D:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    if(!sign)
-                    {
-                        program_counter = operand;
-                    }
+                    reg_h = reg_d;
                 }
                 break;
-            case JMP:
+            case MOV_H_E:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    program_counter = operand;
+                    reg_h = reg_e;
                 }
                 break;
-            case JM:
+            case MOV_H_H:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    if(sign)
-                    {
-                        program_counter = operand;
-                    }
+                    reg_h = reg_h;
                 }
                 break;
-            case JZ:
+            case MOV_H_L:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    if(zero)
-                    {
-                        program_counter = operand;
-                    }
+                    reg_h = reg_l;
                 }
                 break;
-            case JNZ:
+            case MOV_H_M:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    if(!zero)
-                    {
-                        program_counter = operand;
-                    }
+                    reg_h = read_mem(get_word(reg_h, reg_l));
                 }
                 break;
-            case JPE:
+            case MOV_L_A:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    if(parity)
-                    {
-                        program_counter = operand;
-                    }
+                    reg_l = reg_a;
                 }
                 break;
-            case JPO:
+            case MOV_L_B:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    if(!parity)
-                    {
-                        program_counter = operand;
-                    }
+                    reg_l = reg_b;
                 }
                 break;
-            case LDA:
+            case MOV_L_C:
                 {
-                    uint16_t operand = get_imm_16();
-
-                    reg_a = mem[operand];
+                    reg_l = reg_c;
                 }
                 break;
-            case LDAX_B:
+            case MOV_L_D:
                 {
-                    uint16_t address = reg_b;
-                    address <<= 4;
-                    address |= reg_c;
-
-                    reg_a = mem[address];
+                    reg_l = reg_d;
                 }
                 break;
-            case LDAX_D:
+            case MOV_L_E:
                 {
-                    uint16_t address = reg_d;
-                    address <<= 4;
-                    address |= reg_e;
-
-                    reg_a = mem[address];
+                    reg_l = reg_e;
                 }
                 break;
-            case LHLD:
+            case MOV_L_H:
                 {
-                    uint16_t address = get_imm_16();
-
-                    reg_l = mem[address];
-                    reg_h = mem[address+1];
+                    reg_l = reg_h;
                 }
                 break;
-            case LXI_B:
+            case MOV_L_L:
                 {
-                    uint16_t address = get_imm_16();
-
-                    reg_b = mem[address];
-                    reg_c = mem[address+1];
+                    reg_l = reg_l;
                 }
                 break;
-            case LXI_D:
+            case MOV_L_M:
                 {
-                    uint16_t address = get_imm_16();
-
-                    reg_d = mem[address];
-                    reg_e = mem[address+1];
+                    reg_l = read_mem(get_word(reg_h, reg_l));
                 }
                 break;
-            case LXI_H:
+            case MOV_M_A:
                 {
-                    uint16_t address = get_imm_16();
-
-                    reg_h = mem[address];
-                    reg_l = mem[address+1];
+                    write_mem(get_word(reg_h, reg_l), reg_a);
                 }
                 break;
-            case LXI_SP:
+            case MOV_M_B:
                 {
-                    uint16_t address = get_imm_16();
-
-                    stack_pointer = mem[address];
-                    stack_pointer <<= 8;
-                    stack_pointer |= mem[address+1];
+                    write_mem(get_word(reg_h, reg_l), reg_b);
                 }
                 break;
-            case MOV_A_A:
+            case MOV_M_C:
                 {
-                    reg_a = reg_a;
+                    write_mem(get_word(reg_h, reg_l), reg_c);
                 }
                 break;
-            case MOV_A_B:
+            case MOV_M_D:
                 {
-                    reg_a = reg_b;
+                    write_mem(get_word(reg_h, reg_l), reg_d);
                 }
                 break;
-            case MOV_C_A:
+            case MOV_M_E:
                 {
-                    reg_c = reg_a;
+                    write_mem(get_word(reg_h, reg_l), reg_e);
                 }
                 break;
-            case MOV_C_B:
+            case MOV_M_H:
                 {
-                    reg_c = reg_b;
+                    write_mem(get_word(reg_h, reg_l), reg_h);
                 }
                 break;
-            case MOV_A_M:
+            case MOV_M_L:
                 {
-                    uint16_t address = get_word(reg_h, reg_l);
-                    reg_a = mem[address];
+                    write_mem(get_word(reg_h, reg_l), reg_l);
                 }
                 break;
             case MVI_A:
                 {
-                    uint8_t operand = get_imm();
-                    reg_a = operand;
+                    reg_a = get_imm();
                 }
                 break;
             case MVI_B:
                 {
-                    uint8_t operand = get_imm();
-                    reg_b = operand;
+                    reg_b = get_imm();
                 }
                 break;
             case MVI_C:
                 {
-                    uint8_t operand = get_imm();
-                    reg_c = operand;
+                    reg_c = get_imm();
                 }
                 break;
             case MVI_D:
                 {
-                    uint8_t operand = get_imm();
-                    reg_d = operand;
+                    reg_d = get_imm();
                 }
                 break;
             case MVI_E:
                 {
-                    uint8_t operand = get_imm();
-                    reg_e = operand;
+                    reg_e = get_imm();
                 }
                 break;
             case MVI_H:
                 {
-                    uint8_t operand = get_imm();
-                    reg_h = operand;
+                    reg_h = get_imm();
                 }
                 break;
             case MVI_L:
                 {
-                    uint8_t operand = get_imm();
-                    reg_l = operand;
+                    reg_l = get_imm();
                 }
                 break;
             case MVI_M:
                 {
-                    uint16_t hl = get_word(reg_h, reg_l);
-                    uint8_t operand = mem[hl];
-
-                    reg_a = operand;
+                    uint8_t operand = get_imm();
+                    write_mem(get_word(reg_h, reg_l), operand);
                 }
                 break;
             case NOP:
@@ -979,188 +1626,178 @@ namespace lib8085
                 break;
             case ORA_A:
                 {
-                    or(reg_a, reg_a);
+                    ora(reg_a);
                 }
                 break;
             case ORA_B:
                 {
-                    or(reg_a, reg_b);
+                    ora(reg_b);
                 }
                 break;
             case ORA_C:
                 {
-                    or(reg_a, reg_c);
+                    ora(reg_c);
                 }
                 break;
             case ORA_D:
                 {
-                    or(reg_a, reg_d);
+                    ora(reg_d);
                 }
                 break;
             case ORA_E:
                 {
-                    or(reg_a, reg_e);
+                    ora(reg_e);
                 }
                 break;
             case ORA_H:
                 {
-                    or(reg_a, reg_h);
+                    ora(reg_h);
                 }
                 break;
             case ORA_L:
                 {
-                    or(reg_a, reg_l);
+                    ora(reg_l);
                 }
                 break;
             case ORA_M:
                 {
-                    uint16_t hl = get_word(reg_h, reg_l);
-                    uint8_t operand = mem[hl];
+                    uint8_t operand = read_mem(get_word(reg_h, reg_l));
 
-                    or(reg_a, operand);
+                    ora(operand);
+                }
+                break;
+            case ORI:
+                {
+                    uint8_t operand = get_imm();
+
+                    ora(operand);
                 }
                 break;
             case OUT:
                 {
                     uint8_t operand = get_imm();
-                    throw std::exception("Not implemented yet");
+
+                    if(_bus)
+                    {
+                        _bus->out(operand, reg_a);
+                    }
                 }
                 break;
             case PCHL:
                 {
-                    uint16_t hl = get_word(reg_h, reg_l);
-                    program_counter = hl;
+                    program_counter = get_word(reg_h, reg_l);
                 }
                 break;
             case POP_B:
                 {
-                    uint16_t data = mem[stack_pointer++];
-                    reg_c = data;
+                    uint16_t data = pop_stack_16();
 
-                    data = mem[stack_pointer++];
-                    reg_b = data;
+                    reg_b = data >> 8;
+                    reg_c = data & 0xff;
                 }
                 break;
             case POP_D:
                 {
-                    uint16_t data = mem[stack_pointer++];
-                    reg_e = data;
+                    uint16_t data = pop_stack_16();
 
-                    data = mem[stack_pointer++];
-                    reg_d = data;
+                    reg_d = data >> 8;
+                    reg_e = data & 0xff;
                 }
                 break;
             case POP_H:
                 {
-                    uint16_t data = mem[stack_pointer++];
-                    reg_l = data;
+                    uint16_t data = pop_stack_16();
 
-                    data = mem[stack_pointer++];
-                    reg_h = data;
+                    reg_h = data >> 8;
+                    reg_l = data & 0xff;
                 }
                 break;
             case POP_PSW:
                 {
-                    uint16_t data = mem[stack_pointer++];
-
-                    if(data & 10000000 == 10000000)
-                        sign = true;
-                    else
-                        sign = false;
-                    if(data & 01000000 == 01000000)
-                        zero = true;
-                    else
-                        zero = false;
-
-                    if(data & 00010000 == 00010000)
-                        auxiliary_carry = true;
-                    else
-                        auxiliary_carry = false;
-
-                    if(data & 00000100 == 00000100)
-                        parity = true;
-                    else
-                        parity = false;
+                    uint16_t data = pop_stack_16();
 
-                    if(data & 00000001 == 00000001)
-                        carry = true;
-                    else
-                        carry = false;
+                    reg_a = data >> 8;
+                    set_flags(data & 0xff);
+                }
+                break;
+            case PUSH_B:
+                {
+                    push_stack_16(get_word(reg_b, reg_c));
+                }
+                break;
+            case PUSH_D:
+                {
+                    push_stack_16(get_word(reg_d, reg_e));
+                }
+                break;
+            case PUSH_H:
+                {
+                    push_stack_16(get_word(reg_h, reg_l));
+                }
+                break;
+            case PUSH_PSW:
+                {
+                    push_stack_16(get_word(reg_a, get_flags()));
                 }
                 break;
             case RAL:
                 {
-                    if(reg_a & 10000000)
-                    {
-                        carry = true;
-                    }
-                    else
-                    {
-                        carry = false;
-                    }
+                    bool carry_in = carry;
 
-                    reg_a <<= 1;
+                    carry = (reg_a & 0x80) != 0;
+                    reg_a = (reg_a << 1) | (carry_in ? 0x01 : 0x00);
                 }
                 break;
             case RAR:
                 {
-                    reg_a >>= 1;
+                    bool carry_in = carry;
 
-                    if(carry)
-                    {
-                        reg_a |= 10000000;
-                    }
-                    else
-                    {
-                        reg_a ^= (reg_a >> 7) << 7;
-                    }
+                    carry = (reg_a & 0x01) != 0;
+                    reg_a = (reg_a >> 1) | (carry_in ? 0x80 : 0x00);
                 }
                 break;
             case RC:
                 {
                     if(carry)
                     {
-                        // TODO: Check for overflow errors
-                        program_counter = get_word(mem[stack_pointer++], mem[stack_pointer++]);
+                        program_counter = pop_stack_16();
+                        cycles += 6;
                     }
                 }
                 break;
             case RET:
                 {
-                    // TODO: Check for overflow errors
-                    program_counter = get_word(mem[stack_pointer++], mem[stack_pointer++]);
+                    program_counter = pop_stack_16();
                 }
                 break;
             case RIM:
                 {
-                    throw std::exception("Not implemented yet");
-                }
-                break;
-            case RLC:
-                {
-                    uint8_t tmp = reg_a;
+                    bool sid = false;
 
-                    reg_a <<= 1;
-
-                    if(tmp & 10000000)
-                    {
-                        carry = true;
-                        reg_a |= 00000001;
-                    }
-                    else
+                    if(_bus)
                     {
-                        carry = false;
-                        reg_a ^= (reg_a << 7) >> 7;
+                        sid = _bus->sid();
+                        _bus_event_cycle = _bus->next_event_cycle();
                     }
 
+                    reg_a = (sid ? 0x80 : 0x00)
+                        | ((interrupt_pending & (INT_RST7_5 | INT_RST6_5 | INT_RST5_5)) << 4)
+                        | (interrupt_enable ? 0x08 : 0x00)
+                        | (interrupt_mask & 0x07);
+                }
+                break;
+            case RLC:
+                {
+                    carry = (reg_a & 0x80) != 0;
+                    reg_a = (reg_a << 1) | (carry ? 0x01 : 0x00);
                 }
                 break;
             case RM:
                 {
                     if(sign)
                     {
-                        // TODO: Check for overflow errors
-                        program_counter = get_word(mem[stack_pointer++], mem[stack_pointer++]);
+                        program_counter = pop_stack_16();
+                        cycles += 6;
                     }
                 }
                 break;
@@ -1168,8 +1805,8 @@ namespace lib8085
                 {
                     if(!carry)
                     {
-                        // TODO: Check for overflow errors
-                        program_counter = get_word(mem[stack_pointer++], mem[stack_pointer++]);
+                        program_counter = pop_stack_16();
+                        cycles += 6;
                     }
                 }
                 break;
@@ -1177,8 +1814,8 @@ namespace lib8085
                 {
                     if(!zero)
                     {
-                        // TODO: Check for overflow errors
-                        program_counter = get_word(mem[stack_pointer++], mem[stack_pointer++]);
+                        program_counter = pop_stack_16();
+                        cycles += 6;
                     }
                 }
                 break;
@@ -1186,8 +1823,8 @@ namespace lib8085
                 {
                     if(!sign)
                     {
-                        // TODO: Check for overflow errors
-                        program_counter = get_word(mem[stack_pointer++], mem[stack_pointer++]);
+                        program_counter = pop_stack_16();
+                        cycles += 6;
                     }
                 }
                 break;
@@ -1195,8 +1832,8 @@ namespace lib8085
                 {
                     if(parity)
                     {
-                        // TODO: Check for overflow errors
-                        program_counter = get_word(mem[stack_pointer++], mem[stack_pointer++]);
+                        program_counter = pop_stack_16();
+                        cycles += 6;
                     }
                 }
                 break;
@@ -1204,75 +1841,63 @@ namespace lib8085
                 {
                     if(!parity)
                     {
-                        // TODO: Check for overflow errors
-                        program_counter = get_word(mem[stack_pointer++], mem[stack_pointer++]);
+                        program_counter = pop_stack_16();
+                        cycles += 6;
                     }
                 }
                 break;
             case RRC:
                 {
-                    uint8_t tmp = reg_a;
-
-                    reg_a <<= 1;
-
-                    if(tmp & 00000001)
-                    {
-                        carry = true;
-                        reg_a |= 00000001;
-                    }
-                    else
-                    {
-                        carry = false;
-                        reg_a ^= (reg_a >> 7) << 7;
-                    }
+                    carry = (reg_a & 0x01) != 0;
+                    reg_a = (reg_a >> 1) | (carry ? 0x80 : 0x00);
                 }
                 break;
             case RST_0:
                 {
-                    throw std::exception("Not implemented yet");
+                    restart(0x00);
                 }
                 break;
             case RST_1:
                 {
-                    throw std::exception("Not implemented yet");
+                    restart(0x08);
                 }
                 break;
             case RST_2:
                 {
-                    throw std::exception("Not implemented yet");
+                    restart(0x10);
                 }
                 break;
             case RST_3:
                 {
-                    throw std::exception("Not implemented yet");
+                    restart(0x18);
                 }
                 break;
             case RST_4:
                 {
-                    throw std::exception("Not implemented yet");
+                    restart(0x20);
                 }
                 break;
             case RST_5:
                 {
-                    throw std::exception("Not implemented yet");
+                    restart(0x28);
                 }
                 break;
             case RST_6:
                 {
-                    throw std::exception("Not implemented yet");
+                    restart(0x30);
                 }
                 break;
             case RST_7:
                 {
-                    throw std::exception("Not implemented yet");
+                    restart(0x38);
                 }
                 break;
             case RZ:
                 {
                     if(zero)
                     {
-                        // TODO: Check for overflow errors
-                        program_counter = get_word(mem[stack_pointer++], mem[stack_pointer++]);
+                        program_counter = pop_stack_16();
+                        cycles += 6;
                     }
                 }
                 break;
@@ -1313,58 +1938,70 @@ namespace lib8085
                 break;
             case SBB_M:
                 {
-                    uint8_t operand = mem[get_word(reg_h, reg_l)];
+                    uint8_t operand = read_mem(get_word(reg_h, reg_l));
+
                     sub(operand, true);
                 }
                 break;
             case SBI:
                 {
                     uint8_t operand = get_imm();
+
                     sub(operand, true);
                 }
                 break;
             case SHLD:
                 {
                     uint16_t address = get_imm_16();
-                    mem[address] = reg_l;
-                    mem[address++] = reg_h;
+
+                    write_mem(address, reg_l);
+                    write_mem(address + 1, reg_h);
                 }
                 break;
             case SIM:
                 {
-                    throw std::exception("Not implemented yet");
+                    // Mask set enable
+                    if(reg_a & 0x08)
+                    {
+                        interrupt_mask = reg_a & 0x07;
+                    }
+
+                    // Reset the RST 7.5 flip flop
+                    if(reg_a & 0x10)
+                    {
+                        interrupt_pending &= ~INT_RST7_5;
+                    }
+
+                    // Serial output enable
+                    if(reg_a & 0x40)
+                    {
+                        serial_output = (reg_a & 0x80) != 0;
+                    }
                 }
                 break;
             case SPHL:
                 {
-                    stack_pointer = reg_h;
-                    stack_pointer <<= 8;
-                    stack_pointer &= 0xff00;
-                    stack_pointer |= reg_l;
+                    stack_pointer = get_word(reg_h, reg_l);
                 }
                 break;
             case STA:
                 {
-                    uint16_t address = get_imm_16();
-                    mem[address] = reg_a;
+                    write_mem(get_imm_16(), reg_a);
                 }
                 break;
             case STAX_B:
                 {
-                    uint16_t address = get_word(reg_b, reg_c);
-                    mem[address] = reg_a;
+                    write_mem(get_word(reg_b, reg_c), reg_a);
                 }
                 break;
             case STAX_D:
                 {
-                    uint16_t address = get_word(reg_d, reg_e);
-                    mem[address] = reg_a;
+                    write_mem(get_word(reg_d, reg_e), reg_a);
                 }
                 break;
             case STAX_H:
                 {
-                    uint16_t address = get_word(reg_h, reg_l);
-                    mem[address] = reg_a;
+                    write_mem(get_word(reg_h, reg_l), reg_a);
                 }
                 break;
             case STC:
@@ -1409,14 +2046,15 @@ namespace lib8085
                 break;
             case SUB_M:
                 {
-                    uint16_t address = get_word(reg_h, reg_l);
+                    uint8_t operand = read_mem(get_word(reg_h, reg_l));
 
-                    sub(mem[address], false);
+                    sub(operand, false);
                 }
                 break;
             case SUI:
                 {
                     uint8_t operand = get_imm();
+
                     sub(operand, false);
                 }
                 break;
@@ -1433,59 +2071,61 @@ namespace lib8085
                 break;
             case XRA_A:
                 {
-                    xor(reg_a, reg_a);
+                    xra(reg_a);
                 }
                 break;
             case XRA_B:
                 {
-                    xor(reg_a, reg_b);
+                    xra(reg_b);
                 }
                 break;
             case XRA_C:
                 {
-                    xor(reg_a, reg_c);
+                    xra(reg_c);
                 }
                 break;
             case XRA_D:
                 {
-                    xor(reg_a, reg_d);
+                    xra(reg_d);
                 }
                 break;
             case XRA_E:
                 {
-                    xor(reg_a, reg_e);
+                    xra(reg_e);
                 }
                 break;
             case XRA_H:
                 {
-                    xor(reg_a, reg_h);
+                    xra(reg_h);
                 }
                 break;
             case XRA_L:
                 {
-                    xor(reg_a, reg_l);
+                    xra(reg_l);
                 }
                 break;
             case XRA_M:
                 {
-                    uint8_t operand = mem[get_word(reg_h, reg_l)];
-                    xor(reg_a, operand);
+                    uint8_t operand = read_mem(get_word(reg_h, reg_l));
+
+                    xra(operand);
                 }
                 break;
             case XRI:
                 {
                     uint8_t operand = get_imm();
-                    xor(reg_a, operand);
+
+                    xra(operand);
                 }
                 break;
             case XTHL:
                 {
-                    uint8_t tmp = mem[stack_pointer];
-                    mem[stack_pointer] = reg_l;
+                    uint8_t tmp = read_mem(stack_pointer);
+                    write_mem(stack_pointer, reg_l);
                     reg_l = tmp;
 
-                    tmp = mem[stack_pointer+1];
-                    mem[stack_pointer+1] = reg_h;
+                    tmp = read_mem(stack_pointer + 1);
+                    write_mem(stack_pointer + 1, reg_h);
                     reg_h = tmp;
                 }
                 break;
@@ -1497,131 +2137,165 @@ namespace lib8085
         }
     }
 
-    uint8_t Processor::xor(uint8_t a, uint8_t b)
+    uint8_t Processor::get_flags() const
     {
-        a ^= b;
+        return (sign ? 0x80 : 0) | (zero ? 0x40 : 0) | (auxiliary_carry ? 0x10 : 0) | (parity ? 0x04 : 0) | 0x02 | (carry ? 0x01 : 0);
+    }
 
-        if(a < 0)
-        {
-            sign = true;
-            zero = false;
-        }
-        else if(a > 0)
-        {
-            sign = false; 
-            zero = false;
-        }
-        else if(a == 0)
-        {
-            sign = false;
-            zero = true;
-        }
+    void Processor::set_flags(uint8_t flags)
+    {
+        sign = (flags & 0x80) != 0;
+        zero = (flags & 0x40) != 0;
+        auxiliary_carry = (flags & 0x10) != 0;
+        parity = (flags & 0x04) != 0;
+        carry = (flags & 0x01) != 0;
+    }
+
+    void Processor::set_szp(uint8_t value)
+    {
+        uint8_t bits = value ^ (value >> 4);
+        bits ^= bits >> 2;
+        bits ^= bits >> 1;
+
+        sign = (value & 0x80) != 0;
+        zero = value == 0;
+        // Even number of set bits
+        parity = (bits & 0x01) == 0;
+    }
+
+    void Processor::add(uint8_t addend, bool with_carry)
+    {
+        uint8_t carry_in = with_carry && carry ? 1 : 0;
+        uint16_t res = reg_a + addend + carry_in;
 
-        carry = 0;
-        auxiliary_carry = 0;
+        auxiliary_carry = ((reg_a & 0x0f) + (addend & 0x0f) + carry_in) > 0x0f;
+        carry = res > 0xff;
 
-        return a;
+        reg_a = (uint8_t)(res & 0x00ff);
+        set_szp(reg_a);
     }
 
-    void Processor::add(int addend, bool with_carry)
+    void Processor::sub(uint8_t subtrahend, bool with_carry)
     {
-        if(with_carry)
-        {
-            uint16_t res = reg_a + addend + carry;
+        // Two's complement addition, the borrow is the inverted carry out
+        uint8_t carry_in = with_carry && carry ? 0 : 1;
+        uint8_t complement = ~subtrahend;
+        uint16_t res = reg_a + complement + carry_in;
 
-            if(res > 0xff)
-            {
-                carry = true;
-            }
+        auxiliary_carry = ((reg_a & 0x0f) + (complement & 0x0f) + carry_in) > 0x0f;
+        carry = res <= 0xff;
 
-            // Remove higher nibble and store value to reg_a
-            reg_a = (uint8_t)(res & 0x00ff);
-        }
-        else
-        {
-            reg_a += addend;
-        }
+        reg_a = (uint8_t)(res & 0x00ff);
+        set_szp(reg_a);
+    }
 
-        if(reg_a & 0xf0)
-        {
-            sign = true;
-        }
-        else
-        {
-            sign = false;
-        }
+    void Processor::cmp(uint8_t a, uint8_t b)
+    {
+        uint8_t res = a - b;
 
-        if(reg_a == 0)
-        {
-            zero = true;
-        }
-        else
-        {
-            zero = false;
-        }
+        auxiliary_carry = ((a & 0x0f) + (~b & 0x0f) + 1) > 0x0f;
+        carry = a < b;
+        set_szp(res);
     }
 
-    void Processor::sub(uint8_t subtrahend, bool with_carry)
+    void Processor::ana(uint8_t value)
+    {
+        // The 8085 always sets AC on a logical and
+        auxiliary_carry = true;
+        reg_a &= value;
+        carry = false;
+        set_szp(reg_a);
+    }
+
+    void Processor::ora(uint8_t value)
     {
-        uint16_t res = reg_a + ~subtrahend + 1;
+        reg_a |= value;
+        carry = false;
+        auxiliary_carry = false;
+        set_szp(reg_a);
+    }
 
-        reg_a = reg_a + ~subtrahend + 1;
+    void Processor::xra(uint8_t value)
+    {
+        reg_a ^= value;
+        carry = false;
+        auxiliary_carry = false;
+        set_szp(reg_a);
+    }
 
-        if(with_carry)
-        {
-            reg_a += carry;
-        }
+    uint8_t Processor::inr(uint8_t value)
+    {
+        // Carry is left untouched
+        auxiliary_carry = (value & 0x0f) == 0x0f;
+        value++;
+        set_szp(value);
 
-        if(res > 0xff)
-        {
-            carry = false;
-        }
-        else
-        {
-            carry = true;
-        }
+        return value;
     }
 
-    uint8_t Processor::or(uint8_t a, uint8_t b)
+    uint8_t Processor::dcr(uint8_t value)
     {
-        a |= b;
+        auxiliary_carry = (value & 0x0f) != 0x00;
+        value--;
+        set_szp(value);
 
-        if(a < 0)
-        {
-            sign = true;
-            zero = false;
-        }
-        else if(a > 0)
-        {
-            sign = false; 
-            zero = false;
-        }
-        else if(a == 0)
-        {
-            sign = false;
-            zero = true;
-        }
+        return value;
+    }
 
-        carry = 0;
-        auxiliary_carry = 0;
+    void Processor::dad(uint16_t value)
+    {
+        uint32_t res = get_word(reg_h, reg_l) + value;
 
-        return a;
+        carry = res > 0xffff;
+        reg_h = (res >> 8) & 0xff;
+        reg_l = res & 0xff;
     }
 
-    void Processor::cmp(uint8_t a, uint8_t b)
+    void Processor::daa()
     {
-        if(a == b)
-        {
-            zero = true;
-        }
-        else if(a < b)
+        uint8_t correction = 0;
+        bool carry_out = carry;
+
+        if((reg_a & 0x0f) > 0x09 || auxiliary_carry)
         {
-            carry = 1;
+            correction |= 0x06;
         }
-        else if(a > b)
+
+        if(reg_a > 0x99 || carry)
         {
-            carry = 0; zero = 0;
+            correction |= 0x60;
+            carry_out = true;
         }
+
+        auxiliary_carry = ((reg_a & 0x0f) + (correction & 0x0f)) > 0x0f;
+        reg_a += correction;
+        carry = carry_out;
+        set_szp(reg_a);
+    }
+
+    void Processor::print()
+    {
+        std::ios_base::fmtflags fmt = std::cout.flags();
+        char fill = std::cout.fill('0');
+
+        std::cout << std::hex << std::uppercase;
+        std::cout << "-------------\n";
+        std::cout << "A: " << std::setw(2) << (int)reg_a << "H  ";
+        std::cout << "B: " << std::setw(2) << (int)reg_b << "H  ";
+        std::cout << "C: " << std::setw(2) << (int)reg_c << "H  ";
+        std::cout << "D: " << std::setw(2) << (int)reg_d << "H\n";
+        std::cout << "E: " << std::setw(2) << (int)reg_e << "H  ";
+        std::cout << "H: " << std::setw(2) << (int)reg_h << "H  ";
+        std::cout << "L: " << std::setw(2) << (int)reg_l << "H\n";
+        std::cout << "PC: " << std::setw(4) << program_counter << "H  ";
+        std::cout << "SP: " << std::setw(4) << stack_pointer << "H\n";
+        std::cout << "-------------\n";
+        std::cout << "S Z AC P CY\n";
+        std::cout << sign << ' ' << zero << ' ' << auxiliary_carry << "  " << parity << ' ' << carry << '\n';
+        std::cout << "-------------\n";
+
+        std::cout.flags(fmt);
+        std::cout.fill(fill);
     }
 
 #if 0
@@ -1,18 +1,88 @@
 #pragma once
 #include <cstdint>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include "instruction_set.h"
 #include <iostream>
 
 namespace lib8085
 {
+    // Interrupt lines, the maskable RST lines share bit positions with the SIM/RIM masks
+    enum Interrupt : uint8_t
+    {
+        INT_RST5_5 = 0x01,
+        INT_RST6_5 = 0x02,
+        INT_RST7_5 = 0x04,
+        INT_INTR   = 0x08,
+        INT_TRAP   = 0x10
+    };
+
+    /*
+     * Everything the processor consumes from the outside world goes through the bus.
+     * Devices implement in/out, a recorder or replayer can sit in between.
+     *
+     */
+    class IoBus
+    {
+        public:
+            virtual ~IoBus() {}
+
+            virtual uint8_t in(uint8_t port) = 0;
+            virtual void out(uint8_t port, uint8_t value) = 0;
+
+            // Serial input data line, sampled by RIM
+            virtual bool sid() { return false; }
+
+            // Called on an instruction boundary with the lines raised since the last call,
+            // returns the lines the cpu should latch
+            virtual uint8_t interrupts(uint64_t cycle, uint8_t raised) { return raised; }
+
+            // Restart number (0-7) placed on the bus when INTR is acknowledged
+            virtual uint8_t acknowledge() { return 7; }
+
+            // Cycle at which interrupts() should be called even if no line was raised
+            virtual uint64_t next_event_cycle() const { return UINT64_MAX; }
+
+            // Device state carried in savestates
+            virtual void save_state(std::vector<uint8_t>& out) const {}
+            virtual bool load_state(const uint8_t* data, size_t size) { return size == 0; }
+    };
+
+    static const size_t MEM_PAGE_SIZE  = 256;
+    static const size_t MEM_PAGE_COUNT = (1 << 16) / MEM_PAGE_SIZE;
+
+    class MemoryPool;
+    class Profiler;
+    class CallGraph;
+    class Coverage;
+    class TraceWriter;
+
+    /*
+     * Immutable memory image that any number of processors can map as ROM.
+     * The image is copied once and padded to whole pages.
+     *
+     */
+    class RomImage
+    {
+        public:
+            RomImage(uint16_t base_address, const uint8_t* data, size_t size);
+
+            uint16_t base_address() const;
+            size_t page_count() const;
+            const uint8_t* page(size_t index) const;
+
+        private:
+            uint16_t _base_address;
+            std::vector<uint8_t> _data;
+    };
+
 	class Processor
 	{
 		public:
 		uint8_t reg_a, reg_b, reg_c, reg_d, reg_e, reg_h, reg_l;
 		uint16_t program_counter, stack_pointer;
 
-		uint8_t* mem;
-
 		// Flags
 		bool sign; // Set on if 7th bit of acc is on, otherwise off
 		bool zero;
@@ -20,14 +90,88 @@ namespace lib8085
 		bool carry;
 		bool auxiliary_carry;
 
-        Processor();
+        // Interrupt state
+        bool interrupt_enable;
+        uint8_t interrupt_mask;    // M7.5, M6.5, M5.5 as set by SIM
+        uint8_t interrupt_pending; // Latched Interrupt lines
+        bool serial_output;        // SOD
+        bool halted;
+
+        // T-states executed since reset
+        uint64_t cycles;
+
+        // RAM is taken from pool when given, otherwise from the heap
+        explicit Processor(MemoryPool* pool = nullptr);
 
         ~Processor();
 
+        Processor(const Processor&) = delete;
+        Processor& operator=(const Processor&) = delete;
+
+        Processor(Processor&& other);
+        Processor& operator=(Processor&& other);
+
 		void exec(int no_of_instructions);
+        void step();
+
+        // Executes until HLT, until max_instructions ran or until max_cycles T-states
+        // passed, returns the number of instructions executed
+        uint64_t run(uint64_t max_instructions, uint64_t max_cycles = UINT64_MAX);
         void reset();
         void print();
 
+        void attach_bus(IoBus* bus);
+        IoBus* get_bus() const;
+
+        // run() records every instruction in profiler while attached, nullptr detaches
+        void attach_profiler(Profiler* profiler);
+        Profiler* get_profiler() const;
+
+        // run() reports calls, returns and interrupt entries to call_graph while attached
+        void attach_call_graph(CallGraph* call_graph);
+        CallGraph* get_call_graph() const;
+
+        // run() marks executed addresses and branch outcomes in coverage while attached
+        void attach_coverage(Coverage* coverage);
+        Coverage* get_coverage() const;
+
+        // run() streams every instruction to trace while attached, attach once the trace is open
+        void attach_trace(TraceWriter* trace);
+        TraceWriter* get_trace() const;
+
+        // Safe to call from device threads, lines are latched on the next instruction boundary
+        void raise_interrupt(uint8_t lines);
+
+        // Memory is mapped in 256 byte pages. RAM pages read as zero, or as the
+        // savestate they were restored from, and get private storage on first
+        // write. ROM pages are shared and ignore writes.
+        uint8_t read_mem(uint16_t address) const
+        {
+            return _read_pages[address >> 8][address & 0xff];
+        }
+
+        void write_mem(uint16_t address, uint8_t value)
+        {
+            uint8_t* page = _write_pages[address >> 8];
+
+            if(!page)
+            {
+                page = materialize_page(address >> 8);
+            }
+
+            page[address & 0xff] = value;
+        }
+
+        void load_memory(uint16_t address, const uint8_t* data, size_t size);
+
+        // Maps rom over its pages until unmapped, the rom must start on a page boundary
+        bool map_rom(std::shared_ptr<const RomImage> rom);
+        void unmap_rom();
+
+        const uint8_t* get_page(size_t page) const;
+        bool is_rom_page(size_t page) const;
+        bool is_ram_page_used(size_t page) const;
+
         uint8_t get_imm();
         uint16_t get_imm_16();
 
@@ -39,14 +183,62 @@ namespace lib8085
         uint8_t pop_stack();
         uint16_t pop_stack_16();
 
+        // Flags in PSW layout: S Z 0 AC 0 P 1 CY
+        uint8_t get_flags() const;
+        void set_flags(uint8_t flags);
+
         // friend std::ostream& operator<<(std::ostream&, const Processor&);
 
         private:
-        void add(int addend, bool with_carry);
-        void cmp(uint8_t a, uint8_t b);
-        uint8_t or(uint8_t a, uint8_t b);
+        friend class SaveState;
+
+        const uint8_t* _read_pages[MEM_PAGE_COUNT];
+        uint8_t* _write_pages[MEM_PAGE_COUNT];
+
+        // Private RAM, allocated on the first write and only cleared a page at a time
+        uint8_t* _ram;
+        MemoryPool* _pool;
+        std::shared_ptr<const RomImage> _rom;
+        uint8_t _rom_write_sink[MEM_PAGE_SIZE];
+
+        // Pages restored from a savestate are read from its mapping until written
+        std::shared_ptr<const void> _shared_memory;
+
+        // Copies contents, or what the page reads as, into private RAM
+        uint8_t* materialize_page(size_t page, const uint8_t* contents = nullptr);
+        void share_page(size_t page, const uint8_t* contents);
+        void release_page(size_t page);
+        void release_ram_pages();
+        void free_ram();
+        void move_from(Processor& other);
+
+        IoBus* _bus;
+        uint64_t _bus_event_cycle;
+        std::atomic<uint8_t> _interrupt_requests;
+        bool _interrupt_shadow;
+
+        Profiler* _profiler;
+        CallGraph* _call_graph;
+        Coverage* _coverage;
+        TraceWriter* _trace;
+        // Lets the instrumented run loop tell interrupt entries from instructions
+        uint64_t _interrupts_serviced;
+
+        void latch_interrupts();
+        bool service_interrupts();
+        void restart(uint16_t address);
+
+        void set_szp(uint8_t value);
+        void add(uint8_t addend, bool with_carry);
         void sub(uint8_t subtrahend, bool with_carry);
-        uint8_t xor(uint8_t a, uint8_t b);
+        void cmp(uint8_t a, uint8_t b);
+        void ana(uint8_t value);
+        void ora(uint8_t value);
+        void xra(uint8_t value);
+        uint8_t inr(uint8_t value);
+        uint8_t dcr(uint8_t value);
+        void dad(uint16_t value);
+        void daa();
     };
 
 }
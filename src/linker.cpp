@@ -0,0 +1,227 @@
+#include "linker.h"
+#include "source_map.h"
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+namespace lib8085
+{
+    // Diagnostic codes, stable so tools can match on them
+    static const char* const DIAG_UNDEFINED_SYMBOL = "L001";
+    static const char* const DIAG_AMBIGUOUS_SYMBOL = "L002";
+    static const char* const DIAG_SECTION_OVERLAP = "L003";
+    static const char* const DIAG_ADDRESS_RANGE = "L004";
+
+    void Linker::add(const ObjectModule& module, const std::string& name)
+    {
+        _modules.push_back(Module{ module, name, false, 0, {} });
+    }
+
+    void Linker::add(const ObjectModule& module, const std::string& name, uint16_t origin)
+    {
+        _modules.push_back(Module{ module, name, true, origin, {} });
+    }
+
+    bool Linker::place_sections()
+    {
+        struct Placement
+        {
+            uint32_t start;
+            uint32_t end;
+            const Module* module;
+            const ObjectSection* section;
+        };
+
+        std::vector<Placement> placements;
+        uint32_t next = 0;
+
+        for(Module& m : _modules)
+        {
+            m.addresses.clear();
+
+            for(size_t i = 0; i < m.object.sections.size(); i ++)
+            {
+                const ObjectSection& section = m.object.sections[i];
+                uint32_t address = next;
+
+                if(section.has_origin)
+                {
+                    address = section.origin;
+                }
+                else if(i == 0 && m.has_origin)
+                {
+                    address = m.origin;
+                }
+
+                next = address + (uint32_t)section.data.size();
+                m.addresses.push_back(address);
+
+                if(next > 0x10000)
+                {
+                    _diagnostics.set_file(m.name);
+                    _diagnostics.error(DIAG_ADDRESS_RANGE, 0, 0, "Section \'" + section.name + "\' placed at "
+                            + format_address((uint16_t)address) + " runs past FFFFH");
+                }
+
+                if(!section.data.empty())
+                {
+                    placements.push_back(Placement{ address, next, &m, &section });
+                }
+            }
+        }
+
+        std::sort(placements.begin(), placements.end(), [](const Placement& a, const Placement& b)
+        {
+            return a.start < b.start;
+        });
+
+        for(size_t i = 1; i < placements.size(); i ++)
+        {
+            const Placement& before = placements[i - 1];
+            const Placement& p = placements[i];
+
+            if(p.start < before.end)
+            {
+                _diagnostics.set_file(p.module->name);
+                _diagnostics.error(DIAG_SECTION_OVERLAP, 0, 0, "Section \'" + p.section->name + "\' at "
+                        + format_address((uint16_t)p.start) + " overlaps section \'" + before.section->name
+                        + "\' of \'" + before.module->name + "\'");
+            }
+        }
+
+        _image.assign(placements.empty() ? 0 : std::min<uint32_t>(0x10000, std::max_element(placements.begin(), placements.end(),
+                [](const Placement& a, const Placement& b) { return a.end < b.end; })->end), 0);
+
+        return !_diagnostics.has_errors();
+    }
+
+    bool Linker::link()
+    {
+        _diagnostics.clear();
+        _image.clear();
+
+        if(!place_sections())
+        {
+            return false;
+        }
+
+        // Modules exporting each name, with the linked address
+        std::unordered_map<std::string, std::vector<std::pair<const Module*, uint16_t>>> exports;
+
+        for(const Module& m : _modules)
+        {
+            for(size_t i = 0; i < m.object.sections.size(); i ++)
+            {
+                const ObjectSection& section = m.object.sections[i];
+                std::copy(section.data.begin(), section.data.end(), _image.begin() + m.addresses[i]);
+            }
+
+            for(const ObjectSymbol& symbol : m.object.symbols)
+            {
+                if(symbol.defined)
+                {
+                    exports[symbol.name].push_back({ &m, (uint16_t)(m.addresses[symbol.section] + symbol.value) });
+                }
+            }
+        }
+
+        for(const Module& m : _modules)
+        {
+            _diagnostics.set_file(m.name);
+
+            // Each missing import is reported once per module
+            std::set<uint32_t> reported;
+
+            for(const Relocation& relocation : m.object.relocations)
+            {
+                uint16_t address = 0;
+
+                if(relocation.symbol == Relocation::SECTION)
+                {
+                    address = (uint16_t)m.addresses[relocation.section];
+                }
+                else if(m.object.symbols[relocation.symbol].defined)
+                {
+                    const ObjectSymbol& symbol = m.object.symbols[relocation.symbol];
+                    address = (uint16_t)(m.addresses[symbol.section] + symbol.value);
+                }
+                else
+                {
+                    const ObjectSymbol& symbol = m.object.symbols[relocation.symbol];
+                    auto it = exports.find(symbol.name);
+
+                    if(it == exports.end() || it->second.size() > 1)
+                    {
+                        if(reported.insert(relocation.symbol).second)
+                        {
+                            if(it == exports.end())
+                            {
+                                _diagnostics.error(DIAG_UNDEFINED_SYMBOL, 0, 0, "Undefined symbol \'" + symbol.name + "\'");
+                            }
+                            else
+                            {
+                                _diagnostics.error(DIAG_AMBIGUOUS_SYMBOL, 0, 0, "Symbol \'" + symbol.name + "\' is exported by both \'"
+                                        + it->second[0].first->name + "\' and \'" + it->second[1].first->name + "\'");
+                            }
+                        }
+                        continue;
+                    }
+
+                    address = it->second[0].second;
+                }
+
+                address += relocation.addend;
+
+                // Low byte first like the assembler writes them
+                const uint32_t at = m.addresses[relocation.section] + relocation.offset;
+                _image[at] = (address & 0x00ff);
+                _image[at + 1] = (address & 0xff00) >> 8;
+            }
+        }
+
+        return !_diagnostics.has_errors();
+    }
+
+    const std::vector<uint8_t>& Linker::image() const
+    {
+        return _image;
+    }
+
+    std::map<uint16_t, std::string> Linker::get_labels() const
+    {
+        std::map<uint16_t, std::string> labels;
+
+        for(const Module& m : _modules)
+        {
+            for(const ObjectSymbol& symbol : m.object.symbols)
+            {
+                if(!symbol.defined || symbol.section >= m.addresses.size())
+                {
+                    continue;
+                }
+
+                const uint16_t address = (uint16_t)(m.addresses[symbol.section] + symbol.value);
+                std::map<uint16_t, std::string>::iterator l = labels.find(address);
+
+                // Alphabetical first keeps the choice stable
+                if(l == labels.end() || symbol.name < l->second)
+                {
+                    labels[address] = symbol.name;
+                }
+            }
+        }
+
+        return labels;
+    }
+
+    Diagnostics& Linker::diagnostics()
+    {
+        return _diagnostics;
+    }
+
+    const Diagnostics& Linker::diagnostics() const
+    {
+        return _diagnostics;
+    }
+}
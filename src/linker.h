@@ -0,0 +1,59 @@
+#pragma once
+#include "diagnostics.h"
+#include "object.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Combines object modules into one program. Sections with an origin go
+     * there, the others follow the section placed before them, starting at
+     * address 0 unless their module was added with an origin.
+     *
+     * Symbols resolve within their own module first, imports against what
+     * the other modules export. A name exported by more than one module can't
+     * be imported, a module that changed is reassembled on its own and linked
+     * again with the objects of the rest.
+     *
+     */
+    class Linker
+    {
+        public:
+            // name identifies the module in diagnostics, usually the object's path
+            void add(const ObjectModule& module, const std::string& name);
+            // The module's first section is placed at origin
+            void add(const ObjectModule& module, const std::string& name, uint16_t origin);
+
+            // False with diagnostics on undefined or ambiguous imports and sections that overlap
+            bool link();
+
+            // Linked program from address 0 to the end of the last section, gaps are zero
+            const std::vector<uint8_t>& image() const;
+            // Exported label names by linked address, alphabetical first when several share one
+            std::map<uint16_t, std::string> get_labels() const;
+
+            Diagnostics& diagnostics();
+            const Diagnostics& diagnostics() const;
+
+        private:
+            struct Module
+            {
+                ObjectModule object;
+                std::string name;
+                bool has_origin = false;
+                uint16_t origin = 0;
+                // Linked address of each section
+                std::vector<uint32_t> addresses;
+            };
+
+            std::vector<Module> _modules;
+            std::vector<uint8_t> _image;
+            Diagnostics _diagnostics;
+
+            bool place_sections();
+    };
+}
@@ -0,0 +1,233 @@
+#include "memory_pool.h"
+
+#include <new>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace lib8085
+{
+    static void* allocate_slab(size_t size, bool& huge_pages)
+    {
+#ifdef _WIN32
+        // Large pages need SeLockMemoryPrivilege, fall back to normal pages without it
+        size_t large_page = GetLargePageMinimum();
+        if(large_page && size % large_page == 0)
+        {
+            void* p = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if(p)
+            {
+                huge_pages = true;
+                return p;
+            }
+        }
+
+        huge_pages = false;
+        return VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+        void* p;
+
+#ifdef MAP_HUGETLB
+        // The kernel rounds hugetlb mappings up to whole pages and munmap() with the size
+        // asked for would then fail, so only sizes that are already a multiple try them
+        const size_t huge_page = 2 << 20;
+        if(size % huge_page == 0)
+        {
+            p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+            if(p != MAP_FAILED)
+            {
+                huge_pages = true;
+                return p;
+            }
+        }
+#endif
+        huge_pages = false;
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p == MAP_FAILED)
+        {
+            return nullptr;
+        }
+
+#ifdef MADV_HUGEPAGE
+        madvise(p, size, MADV_HUGEPAGE);
+#endif
+        // Fault the slab in now rather than on the first write of every instance
+        for(size_t i = 0; i < size; i += 4096)
+        {
+            static_cast<volatile uint8_t*>(p)[i] = 0;
+        }
+
+        return p;
+#endif
+    }
+
+    static void free_slab(void* base, size_t size)
+    {
+#ifdef _WIN32
+        VirtualFree(base, 0, MEM_RELEASE);
+#else
+        munmap(base, size);
+#endif
+    }
+
+    MemoryPool::MemoryPool(size_t images_per_slab) : _images_per_slab(images_per_slab ? images_per_slab : 1)
+    {
+    }
+
+    MemoryPool::~MemoryPool()
+    {
+        for(Slab& slab : _slabs)
+        {
+            free_slab(slab.base, slab.size);
+        }
+    }
+
+    void MemoryPool::grow()
+    {
+        Slab slab;
+        slab.size = _images_per_slab * IMAGE_SIZE;
+        slab.base = allocate_slab(slab.size, slab.huge_pages);
+
+        if(!slab.base)
+        {
+            throw std::bad_alloc();
+        }
+
+        _slabs.push_back(slab);
+
+        uint8_t* image = static_cast<uint8_t*>(slab.base);
+        for(size_t i = 0; i < _images_per_slab; i ++)
+        {
+            _free.push_back(image + (_images_per_slab - 1 - i) * IMAGE_SIZE);
+        }
+    }
+
+    uint8_t* MemoryPool::acquire()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        if(_free.empty())
+        {
+            grow();
+        }
+
+        uint8_t* image = _free.back();
+        _free.pop_back();
+
+        return image;
+    }
+
+    void MemoryPool::release(uint8_t* image)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _free.push_back(image);
+    }
+
+    void MemoryPool::reserve(size_t count)
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        while(_free.size() < count)
+        {
+            grow();
+        }
+    }
+
+    size_t MemoryPool::slab_count() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _slabs.size();
+    }
+
+    size_t MemoryPool::huge_page_slab_count() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+
+        size_t count = 0;
+        for(const Slab& slab : _slabs)
+        {
+            count += slab.huge_pages ? 1 : 0;
+        }
+        return count;
+    }
+
+    void ProcessorPool::Releaser::operator()(Processor* cpu) const
+    {
+        pool->release(cpu);
+    }
+
+    ProcessorPool::ProcessorPool(size_t images_per_slab) : _memory(images_per_slab)
+    {
+    }
+
+    Processor* ProcessorPool::create()
+    {
+        _processors.emplace_back(new Processor(&_memory));
+        return _processors.back().get();
+    }
+
+    ProcessorPool::Handle ProcessorPool::acquire()
+    {
+        Processor* cpu;
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+
+            if(_free.empty())
+            {
+                cpu = create();
+            }
+            else
+            {
+                cpu = _free.back();
+                _free.pop_back();
+            }
+        }
+
+        return Handle(cpu, Releaser{ this });
+    }
+
+    void ProcessorPool::release(Processor* cpu)
+    {
+        // Only drops page mappings, the RAM image stays with the processor.
+        // Instrumentation belongs to the previous user and may be gone by the next run
+        cpu->attach_bus(nullptr);
+        cpu->attach_profiler(nullptr);
+        cpu->attach_call_graph(nullptr);
+        cpu->attach_coverage(nullptr);
+        cpu->attach_trace(nullptr);
+        cpu->unmap_rom();
+        cpu->reset();
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _free.push_back(cpu);
+    }
+
+    void ProcessorPool::reserve(size_t count)
+    {
+        _memory.reserve(count);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        while(_processors.size() < count)
+        {
+            Processor* cpu = create();
+
+            // Claim the RAM image now so the first write doesn't touch the pool
+            cpu->write_mem(0, 0);
+            cpu->reset();
+
+            _free.push_back(cpu);
+        }
+    }
+
+    size_t ProcessorPool::size() const
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _processors.size();
+    }
+}
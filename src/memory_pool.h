@@ -0,0 +1,98 @@
+#pragma once
+#include "lib8085.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Hands out 64 KiB memory images carved from large slabs.
+     *
+     * Slabs are backed by huge pages where the OS allows it and their size is a
+     * multiple of the huge page size, 32 images per slab is. They are faulted in
+     * when created, released images go on a free list and are handed out again
+     * as they are. Processors only clear the pages they actually use.
+     *
+     */
+    class MemoryPool
+    {
+        public:
+            static const size_t IMAGE_SIZE = 1 << 16;
+
+            explicit MemoryPool(size_t images_per_slab = 32);
+            ~MemoryPool();
+
+            MemoryPool(const MemoryPool&) = delete;
+            MemoryPool& operator=(const MemoryPool&) = delete;
+
+            uint8_t* acquire();
+            void release(uint8_t* image);
+
+            // Makes sure count images can be acquired without growing
+            void reserve(size_t count);
+
+            size_t slab_count() const;
+            size_t huge_page_slab_count() const;
+
+        private:
+            struct Slab
+            {
+                void* base;
+                size_t size;
+                bool huge_pages;
+            };
+
+            mutable std::mutex _mutex;
+            std::vector<Slab> _slabs;
+            std::vector<uint8_t*> _free;
+            size_t _images_per_slab;
+
+            void grow();
+    };
+
+    /*
+     * Recycles whole Processor objects together with their RAM images.
+     *
+     * acquire() returns a reset processor with no bus, ROM or instrumentation
+     * attached, it goes back to the pool when the handle is destroyed. The pool
+     * must outlive every handle it gave out.
+     *
+     */
+    class ProcessorPool
+    {
+        public:
+            struct Releaser
+            {
+                ProcessorPool* pool;
+                void operator()(Processor* cpu) const;
+            };
+
+            typedef std::unique_ptr<Processor, Releaser> Handle;
+
+            explicit ProcessorPool(size_t images_per_slab = 32);
+
+            ProcessorPool(const ProcessorPool&) = delete;
+            ProcessorPool& operator=(const ProcessorPool&) = delete;
+
+            Handle acquire();
+
+            // Creates processors (and their RAM) up front so acquire never allocates
+            void reserve(size_t count);
+
+            size_t size() const;
+
+        private:
+            // Declared first so it is destroyed after the processors that use it
+            MemoryPool _memory;
+
+            mutable std::mutex _mutex;
+            std::vector<std::unique_ptr<Processor>> _processors;
+            std::vector<Processor*> _free;
+
+            Processor* create();
+            void release(Processor* cpu);
+    };
+}
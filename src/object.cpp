@@ -0,0 +1,258 @@
+#include "object.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace lib8085
+{
+    static const char _object_magic[4] = { 'R', '8', '5', 'O' };
+    static const uint8_t _object_version = 2;
+
+    static void put_16(std::vector<uint8_t>& out, uint16_t v)
+    {
+        out.push_back((uint8_t)v);
+        out.push_back((uint8_t)(v >> 8));
+    }
+
+    static void put_32(std::vector<uint8_t>& out, uint32_t v)
+    {
+        for(int i = 0; i < 4; i ++)
+        {
+            out.push_back((uint8_t)(v >> (i * 8)));
+        }
+    }
+
+    static void put_name(std::vector<uint8_t>& out, const std::string& name)
+    {
+        put_16(out, (uint16_t)name.size());
+        out.insert(out.end(), name.begin(), name.begin() + std::min<size_t>(name.size(), 0xffff));
+    }
+
+    // Reads fields in file order, every read fails once the data ran out
+    class ObjectReader
+    {
+        public:
+            ObjectReader(const std::vector<uint8_t>& data) : _data(data), _offset(0)
+            {
+            }
+
+            bool get_8(uint8_t& v)
+            {
+                if(_offset + 1 > _data.size())
+                {
+                    return false;
+                }
+                v = _data[_offset++];
+                return true;
+            }
+
+            bool get_16(uint16_t& v)
+            {
+                if(_offset + 2 > _data.size())
+                {
+                    return false;
+                }
+                v = (uint16_t)(_data[_offset] | (_data[_offset + 1] << 8));
+                _offset += 2;
+                return true;
+            }
+
+            bool get_32(uint32_t& v)
+            {
+                if(_offset + 4 > _data.size())
+                {
+                    return false;
+                }
+                v = 0;
+                for(int i = 3; i >= 0; i --)
+                {
+                    v = (v << 8) | _data[_offset + i];
+                }
+                _offset += 4;
+                return true;
+            }
+
+            bool get_bytes(size_t size, std::vector<uint8_t>& bytes)
+            {
+                if(size > _data.size() - _offset)
+                {
+                    return false;
+                }
+                bytes.assign(_data.begin() + _offset, _data.begin() + _offset + size);
+                _offset += size;
+                return true;
+            }
+
+            bool get_name(std::string& name)
+            {
+                uint16_t size;
+                if(!get_16(size) || size > _data.size() - _offset)
+                {
+                    return false;
+                }
+                name.assign(_data.begin() + _offset, _data.begin() + _offset + size);
+                _offset += size;
+                return true;
+            }
+
+            // Counts are checked against what is left so a corrupt one can't allocate much
+            bool get_count(uint32_t& count, size_t min_size)
+            {
+                return get_32(count) && (size_t)count <= (_data.size() - _offset) / min_size;
+            }
+
+        private:
+            const std::vector<uint8_t>& _data;
+            size_t _offset;
+    };
+
+    void ObjectModule::clear()
+    {
+        sections.clear();
+        symbols.clear();
+        relocations.clear();
+    }
+
+    void ObjectModule::serialize(std::vector<uint8_t>& data) const
+    {
+        data.assign(_object_magic, _object_magic + sizeof(_object_magic));
+        data.push_back(_object_version);
+
+        put_32(data, (uint32_t)sections.size());
+        for(const ObjectSection& section : sections)
+        {
+            put_name(data, section.name);
+            data.push_back(section.has_origin ? 1 : 0);
+            put_16(data, section.origin);
+            put_32(data, (uint32_t)section.data.size());
+            data.insert(data.end(), section.data.begin(), section.data.end());
+        }
+
+        put_32(data, (uint32_t)symbols.size());
+        for(const ObjectSymbol& symbol : symbols)
+        {
+            put_name(data, symbol.name);
+            data.push_back(symbol.defined ? 1 : 0);
+            put_16(data, symbol.section);
+            put_16(data, symbol.value);
+        }
+
+        put_32(data, (uint32_t)relocations.size());
+        for(const Relocation& relocation : relocations)
+        {
+            put_16(data, relocation.section);
+            put_16(data, relocation.offset);
+            put_32(data, relocation.symbol);
+            put_16(data, relocation.addend);
+        }
+    }
+
+    bool ObjectModule::deserialize(const std::vector<uint8_t>& data)
+    {
+        clear();
+
+        if(data.size() < 5
+                || !std::equal(_object_magic, _object_magic + 4, data.begin())
+                || data[4] != _object_version)
+        {
+            return false;
+        }
+
+        ObjectReader reader(data);
+        std::vector<uint8_t> magic;
+        uint32_t count;
+        uint8_t flag = 0;
+        bool valid = reader.get_bytes(5, magic) && reader.get_count(count, 9);
+
+        for(uint32_t i = 0; valid && i < count; i ++)
+        {
+            ObjectSection section;
+            uint32_t size;
+
+            valid = reader.get_name(section.name) && reader.get_8(flag) && reader.get_16(section.origin)
+                && reader.get_32(size) && reader.get_bytes(size, section.data);
+            section.has_origin = flag != 0;
+
+            sections.push_back(std::move(section));
+        }
+
+        valid = valid && reader.get_count(count, 7);
+        for(uint32_t i = 0; valid && i < count; i ++)
+        {
+            ObjectSymbol symbol;
+
+            valid = reader.get_name(symbol.name) && reader.get_8(flag) && reader.get_16(symbol.section)
+                && reader.get_16(symbol.value);
+            symbol.defined = flag != 0;
+            valid = valid && (!symbol.defined || symbol.section < sections.size());
+
+            symbols.push_back(std::move(symbol));
+        }
+
+        valid = valid && reader.get_count(count, 10);
+        for(uint32_t i = 0; valid && i < count; i ++)
+        {
+            Relocation relocation;
+
+            valid = reader.get_16(relocation.section) && reader.get_16(relocation.offset) && reader.get_32(relocation.symbol)
+                && reader.get_16(relocation.addend) && relocation.section < sections.size()
+                && (relocation.symbol < symbols.size() || relocation.symbol == Relocation::SECTION)
+                && (size_t)relocation.offset + 2 <= sections[relocation.section].data.size();
+
+            relocations.push_back(relocation);
+        }
+
+        if(!valid)
+        {
+            clear();
+        }
+
+        return valid;
+    }
+
+    bool ObjectModule::save(const char* path, std::ostream& err) const
+    {
+        std::ofstream file(path, std::ios::out | std::ios::binary);
+
+        if(!file.good() || !file.is_open())
+        {
+            err << "Error writing object \'" << path << "\'\n";
+            return false;
+        }
+
+        std::vector<uint8_t> data;
+        serialize(data);
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+        if(!file.good())
+        {
+            err << "Error writing object \'" << path << "\'\n";
+            return false;
+        }
+
+        return true;
+    }
+
+    bool ObjectModule::load(const char* path, std::ostream& err)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+
+        if(!file.good() || !file.is_open())
+        {
+            err << "Error reading object \'" << path << "\'\n";
+            return false;
+        }
+
+        std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+        if(!deserialize(data))
+        {
+            err << "\'" << path << "\' is not a supported object or is truncated\n";
+            return false;
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    // Code of a module that is placed as a whole
+    struct ObjectSection
+    {
+        std::string name;
+        // Sections without an origin go where the linker puts them
+        bool has_origin = false;
+        uint16_t origin = 0;
+        std::vector<uint8_t> data;
+    };
+
+    // Defined symbols are exported, the rest are imports resolved against other modules
+    struct ObjectSymbol
+    {
+        std::string name;
+        bool defined = false;
+        uint16_t section = 0;
+        // Offset into the section when defined
+        uint16_t value = 0;
+    };
+
+    // Word in a section that receives the linked address of a symbol plus addend, low byte first
+    struct Relocation
+    {
+        // Symbol of relocations relative to the address of their own section
+        static const uint32_t SECTION = 0xffffffff;
+
+        uint16_t section = 0;
+        uint16_t offset = 0;
+        uint32_t symbol = 0;
+        uint16_t addend = 0;
+    };
+
+    /*
+     * Relocatable output of assembling one module, combined into a program by
+     * the Linker.
+     *
+     * Layout (little endian):
+     *   magic "R85O", version
+     *   sections      - count, then name, has origin, origin, size and bytes
+     *   symbols       - count, then name, defined, section and value
+     *   relocations   - count, then section, offset, symbol index and addend
+     *
+     * Counts and sizes are 32 bit, names a 16 bit length and the characters.
+     *
+     */
+    class ObjectModule
+    {
+        public:
+            std::vector<ObjectSection> sections;
+            std::vector<ObjectSymbol> symbols;
+            std::vector<Relocation> relocations;
+
+            void clear();
+
+            void serialize(std::vector<uint8_t>& data) const;
+            // False when data isn't a complete object of this version
+            bool deserialize(const std::vector<uint8_t>& data);
+
+            // Failures are described on err, pass a buffer when running next to other jobs
+            bool save(const char* path, std::ostream& err = std::cerr) const;
+            bool load(const char* path, std::ostream& err = std::cerr);
+    };
+}
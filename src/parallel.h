@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace lib8085
+{
+    inline unsigned default_thread_count()
+    {
+        unsigned threads = std::thread::hardware_concurrency();
+        return threads ? threads : 1;
+    }
+
+    /*
+     * Calls fn(index, worker) for every index in [0, count) on up to threads
+     * workers (0 = one per core). Work is handed out in chunks from a shared
+     * counter, worker is in [0, threads) so callers can keep per-worker state.
+     * The first exception thrown by fn is rethrown once all workers stopped.
+     *
+     */
+    template <typename Fn>
+    void parallel_for(size_t count, Fn fn, unsigned threads = 0)
+    {
+        if(threads == 0)
+        {
+            threads = default_thread_count();
+        }
+        if(threads > count)
+        {
+            threads = count ? (unsigned)count : 1;
+        }
+
+        size_t chunk = std::max<size_t>(1, std::min<size_t>(64, count / (threads * 16)));
+
+        std::atomic<size_t> next(0);
+        std::atomic<bool> failed(false);
+        std::exception_ptr error;
+
+        auto worker = [&](unsigned id)
+        {
+            try
+            {
+                while(!failed.load(std::memory_order_relaxed))
+                {
+                    size_t begin = next.fetch_add(chunk);
+                    if(begin >= count)
+                    {
+                        break;
+                    }
+
+                    size_t end = std::min(begin + chunk, count);
+                    for(size_t i = begin; i < end; i ++)
+                    {
+                        fn(i, id);
+                    }
+                }
+            }
+            catch(...)
+            {
+                if(!failed.exchange(true))
+                {
+                    error = std::current_exception();
+                }
+            }
+        };
+
+        std::vector<std::thread> workers;
+        for(unsigned id = 1; id < threads; id ++)
+        {
+            workers.emplace_back(worker, id);
+        }
+
+        worker(0);
+
+        for(std::thread& t : workers)
+        {
+            t.join();
+        }
+
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
@@ -0,0 +1,188 @@
+#include "profiler.h"
+#include "isa.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <map>
+
+namespace lib8085
+{
+    struct HotspotRow
+    {
+        uint64_t cycles;
+        uint64_t executions;
+        uint32_t key;
+    };
+
+    static void sort_rows(std::vector<HotspotRow>& rows, size_t top)
+    {
+        std::sort(rows.begin(), rows.end(), [](const HotspotRow& a, const HotspotRow& b)
+        {
+            return a.cycles != b.cycles ? a.cycles > b.cycles : a.key < b.key;
+        });
+
+        if(rows.size() > top)
+        {
+            rows.resize(top);
+        }
+    }
+
+    static void print_counts(std::ostream& out, const HotspotRow& row, uint64_t total_cycles)
+    {
+        out << std::setw(12) << row.cycles << " " << std::setw(6)
+            << std::fixed << std::setprecision(2) << (total_cycles ? row.cycles * 100.0 / total_cycles : 0.0) << "% "
+            << std::setw(12) << row.executions << " ";
+        out.unsetf(std::ios_base::fixed);
+    }
+
+    Profiler::Profiler()
+        : _executions(1 << 16), _cycles(1 << 16), _opcode_executions(256), _opcode_cycles(256)
+    {
+    }
+
+    void Profiler::reset()
+    {
+        std::fill(_executions.begin(), _executions.end(), 0);
+        std::fill(_cycles.begin(), _cycles.end(), 0);
+        std::fill(_opcode_executions.begin(), _opcode_executions.end(), 0);
+        std::fill(_opcode_cycles.begin(), _opcode_cycles.end(), 0);
+    }
+
+    void Profiler::merge(const Profiler& other)
+    {
+        for(size_t i = 0; i < _executions.size(); i ++)
+        {
+            _executions[i] += other._executions[i];
+            _cycles[i] += other._cycles[i];
+        }
+
+        for(size_t i = 0; i < _opcode_executions.size(); i ++)
+        {
+            _opcode_executions[i] += other._opcode_executions[i];
+            _opcode_cycles[i] += other._opcode_cycles[i];
+        }
+    }
+
+    uint64_t Profiler::executions(uint16_t address) const
+    {
+        return _executions[address];
+    }
+
+    uint64_t Profiler::cycles(uint16_t address) const
+    {
+        return _cycles[address];
+    }
+
+    uint64_t Profiler::total_executions() const
+    {
+        uint64_t total = 0;
+
+        for(uint64_t count : _opcode_executions)
+        {
+            total += count;
+        }
+
+        return total;
+    }
+
+    uint64_t Profiler::total_cycles() const
+    {
+        uint64_t total = 0;
+
+        for(uint64_t count : _opcode_cycles)
+        {
+            total += count;
+        }
+
+        return total;
+    }
+
+    void Profiler::print_report(std::ostream& out, const SourceMap& source, size_t top) const
+    {
+        uint64_t total_cycles = this->total_cycles();
+
+        out << "Instructions: " << total_executions() << ", cycles: " << total_cycles << "\n";
+
+        std::vector<HotspotRow> addresses;
+        std::map<uint32_t, HotspotRow> routines;
+
+        for(uint32_t address = 0; address < _executions.size(); address ++)
+        {
+            if(_executions[address] == 0)
+            {
+                continue;
+            }
+
+            addresses.push_back({ _cycles[address], _executions[address], address });
+
+            // Code before the first label is grouped under its own address
+            uint16_t start;
+            uint32_t key = source.routine((uint16_t)address, start) ? start : 0x10000;
+
+            HotspotRow& routine = routines.insert({ key, HotspotRow{ 0, 0, key } }).first->second;
+            routine.cycles += _cycles[address];
+            routine.executions += _executions[address];
+        }
+
+        sort_rows(addresses, top);
+
+        out << "\nHotspots by address\n";
+        out << "      Cycles        %   Executions  Address  Location              Line  Source\n";
+        for(const HotspotRow& row : addresses)
+        {
+            uint16_t address = (uint16_t)row.key;
+            int line = source.line(address);
+
+            print_counts(out, row, total_cycles);
+            out << format_address(address) << "    " << std::left << std::setw(20) << source.location(address) << std::right
+                << " " << std::setw(5);
+
+            if(line)
+            {
+                out << line << "  " << source.text(line);
+            }
+            else
+            {
+                out << "-";
+            }
+            out << "\n";
+        }
+
+        if(!source.labels().empty())
+        {
+            std::vector<HotspotRow> rows;
+            for(const auto& it : routines)
+            {
+                rows.push_back(it.second);
+            }
+            sort_rows(rows, top);
+
+            out << "\nHotspots by label\n";
+            out << "      Cycles        %   Executions  Label\n";
+            for(const HotspotRow& row : rows)
+            {
+                print_counts(out, row, total_cycles);
+                out << (row.key > 0xffff ? "(before first label)" : source.labels().at((uint16_t)row.key)) << "\n";
+            }
+        }
+
+        std::vector<HotspotRow> opcodes;
+
+        for(uint32_t opcode = 0; opcode < _opcode_executions.size(); opcode ++)
+        {
+            if(_opcode_executions[opcode])
+            {
+                opcodes.push_back({ _opcode_cycles[opcode], _opcode_executions[opcode], opcode });
+            }
+        }
+        sort_rows(opcodes, top);
+
+        out << "\nHotspots by opcode\n";
+        out << "      Cycles        %   Executions  Opcode\n";
+        for(const HotspotRow& row : opcodes)
+        {
+            print_counts(out, row, total_cycles);
+            out << (Isa::defined((uint8_t)row.key) ? Isa::entry((uint8_t)row.key).mnemonic : "?") << "\n";
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include "source_map.h"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Execution profile of one or more runs, counts and T-states per address and
+     * per opcode kept in flat arrays so recording is two increments each.
+     *
+     * Attach to a Processor with attach_profiler, run() then records every
+     * instruction under the address it started at. Profiles of several runs
+     * can be merged before reporting.
+     *
+     */
+    class Profiler
+    {
+        public:
+            Profiler();
+
+            void record(uint16_t address, uint8_t opcode, uint64_t cycles)
+            {
+                _executions[address]++;
+                _cycles[address] += cycles;
+                _opcode_executions[opcode]++;
+                _opcode_cycles[opcode] += cycles;
+            }
+
+            void reset();
+            void merge(const Profiler& other);
+
+            uint64_t executions(uint16_t address) const;
+            uint64_t cycles(uint16_t address) const;
+            uint64_t total_executions() const;
+            uint64_t total_cycles() const;
+
+            // Hottest addresses, labels and opcodes by T-states, top rows of each
+            void print_report(std::ostream& out, const SourceMap& source, size_t top = 20) const;
+
+        private:
+            std::vector<uint64_t> _executions;
+            std::vector<uint64_t> _cycles;
+            std::vector<uint64_t> _opcode_executions;
+            std::vector<uint64_t> _opcode_cycles;
+    };
+}
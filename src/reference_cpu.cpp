@@ -0,0 +1,715 @@
+#include "reference_cpu.h"
+
+#include <cstring>
+
+namespace lib8085
+{
+    enum ReferenceKind
+    {
+        K_NONE,
+        K_MOV, K_MVI, K_LXI, K_ALU, K_INR, K_DCR, K_INX, K_DCX, K_DAD,
+        K_LDAX, K_STAX, K_LDA, K_STA, K_LHLD, K_SHLD, K_XCHG, K_XTHL, K_SPHL, K_PCHL,
+        K_PUSH, K_POP, K_JMP, K_CALL, K_RET, K_RST, K_ROTATE,
+        K_DAA, K_CMA, K_CMC, K_STC, K_NOP, K_HLT, K_IN, K_OUT, K_EI, K_DI, K_RIM, K_SIM
+    };
+
+    // Register pairs, PUSH and POP use the SP slot for PSW
+    enum ReferencePair { P_BC, P_DE, P_HL, P_SP, P_PSW = P_SP };
+
+    enum ReferenceCondition { C_NZ, C_Z, C_NC, C_C, C_PO, C_PE, C_P, C_M, C_ALWAYS };
+
+    enum ReferenceAlu { ALU_ADD, ALU_ADC, ALU_SUB, ALU_SBB, ALU_ANA, ALU_XRA, ALU_ORA, ALU_CMP };
+
+    enum ReferenceRotate { ROT_RLC, ROT_RRC, ROT_RAL, ROT_RAR };
+
+    enum ReferenceFlag : uint8_t
+    {
+        F_CY = 0x01, F_ONE = 0x02, F_P = 0x04, F_AC = 0x10, F_Z = 0x40, F_S = 0x80
+    };
+
+    struct Decoded
+    {
+        InstructionSet opcode;
+        ReferenceKind kind;
+        int a, b;
+        int length;
+        int cycles;
+        // Cycles when a conditional branch is taken, 0 otherwise
+        int taken_cycles;
+    };
+
+    // T-states from the 8085 datasheet
+    static const Decoded _decode_list[] = {
+        { ACI,      K_ALU,    ALU_ADC,  R_IMM, 2,  7,  0 },
+        { ADC_A,    K_ALU,    ALU_ADC,  R_A,   1,  4,  0 },
+        { ADC_B,    K_ALU,    ALU_ADC,  R_B,   1,  4,  0 },
+        { ADC_C,    K_ALU,    ALU_ADC,  R_C,   1,  4,  0 },
+        { ADC_D,    K_ALU,    ALU_ADC,  R_D,   1,  4,  0 },
+        { ADC_E,    K_ALU,    ALU_ADC,  R_E,   1,  4,  0 },
+        { ADC_H,    K_ALU,    ALU_ADC,  R_H,   1,  4,  0 },
+        { ADC_L,    K_ALU,    ALU_ADC,  R_L,   1,  4,  0 },
+        { ADC_M,    K_ALU,    ALU_ADC,  R_M,   1,  7,  0 },
+        { ADD_A,    K_ALU,    ALU_ADD,  R_A,   1,  4,  0 },
+        { ADD_B,    K_ALU,    ALU_ADD,  R_B,   1,  4,  0 },
+        { ADD_C,    K_ALU,    ALU_ADD,  R_C,   1,  4,  0 },
+        { ADD_D,    K_ALU,    ALU_ADD,  R_D,   1,  4,  0 },
+        { ADD_E,    K_ALU,    ALU_ADD,  R_E,   1,  4,  0 },
+        { ADD_H,    K_ALU,    ALU_ADD,  R_H,   1,  4,  0 },
+        { ADD_L,    K_ALU,    ALU_ADD,  R_L,   1,  4,  0 },
+        { ADD_M,    K_ALU,    ALU_ADD,  R_M,   1,  7,  0 },
+        { ADI,      K_ALU,    ALU_ADD,  R_IMM, 2,  7,  0 },
+        { ANA_A,    K_ALU,    ALU_ANA,  R_A,   1,  4,  0 },
+        { ANA_B,    K_ALU,    ALU_ANA,  R_B,   1,  4,  0 },
+        { ANA_C,    K_ALU,    ALU_ANA,  R_C,   1,  4,  0 },
+        { ANA_D,    K_ALU,    ALU_ANA,  R_D,   1,  4,  0 },
+        { ANA_E,    K_ALU,    ALU_ANA,  R_E,   1,  4,  0 },
+        { ANA_H,    K_ALU,    ALU_ANA,  R_H,   1,  4,  0 },
+        { ANA_L,    K_ALU,    ALU_ANA,  R_L,   1,  4,  0 },
+        { ANA_M,    K_ALU,    ALU_ANA,  R_M,   1,  7,  0 },
+        { ANI,      K_ALU,    ALU_ANA,  R_IMM, 2,  7,  0 },
+        { CALL,     K_CALL,   C_ALWAYS, 0,     3, 18,  0 },
+        { CC,       K_CALL,   C_C,      0,     3,  9, 18 },
+        { CM,       K_CALL,   C_M,      0,     3,  9, 18 },
+        { CMA,      K_CMA,    0,        0,     1,  4,  0 },
+        { CMC,      K_CMC,    0,        0,     1,  4,  0 },
+        { CMP_A,    K_ALU,    ALU_CMP,  R_A,   1,  4,  0 },
+        { CMP_B,    K_ALU,    ALU_CMP,  R_B,   1,  4,  0 },
+        { CMP_C,    K_ALU,    ALU_CMP,  R_C,   1,  4,  0 },
+        { CMP_D,    K_ALU,    ALU_CMP,  R_D,   1,  4,  0 },
+        { CMP_E,    K_ALU,    ALU_CMP,  R_E,   1,  4,  0 },
+        { CMP_H,    K_ALU,    ALU_CMP,  R_H,   1,  4,  0 },
+        { CMP_L,    K_ALU,    ALU_CMP,  R_L,   1,  4,  0 },
+        { CMP_M,    K_ALU,    ALU_CMP,  R_M,   1,  7,  0 },
+        { CNC,      K_CALL,   C_NC,     0,     3,  9, 18 },
+        { CNZ,      K_CALL,   C_NZ,     0,     3,  9, 18 },
+        { CP,       K_CALL,   C_P,      0,     3,  9, 18 },
+        { CPE,      K_CALL,   C_PE,     0,     3,  9, 18 },
+        { CPI,      K_ALU,    ALU_CMP,  R_IMM, 2,  7,  0 },
+        { CPO,      K_CALL,   C_PO,     0,     3,  9, 18 },
+        { CZ,       K_CALL,   C_Z,      0,     3,  9, 18 },
+        { DAA,      K_DAA,    0,        0,     1,  4,  0 },
+        { DAD_B,    K_DAD,    P_BC,     0,     1, 10,  0 },
+        { DAD_D,    K_DAD,    P_DE,     0,     1, 10,  0 },
+        { DAD_H,    K_DAD,    P_HL,     0,     1, 10,  0 },
+        { DAD_SP,   K_DAD,    P_SP,     0,     1, 10,  0 },
+        { DCR_A,    K_DCR,    R_A,      0,     1,  4,  0 },
+        { DCR_B,    K_DCR,    R_B,      0,     1,  4,  0 },
+        { DCR_C,    K_DCR,    R_C,      0,     1,  4,  0 },
+        { DCR_D,    K_DCR,    R_D,      0,     1,  4,  0 },
+        { DCR_E,    K_DCR,    R_E,      0,     1,  4,  0 },
+        { DCR_H,    K_DCR,    R_H,      0,     1,  4,  0 },
+        { DCR_L,    K_DCR,    R_L,      0,     1,  4,  0 },
+        { DCR_M,    K_DCR,    R_M,      0,     1, 10,  0 },
+        { DCX_B,    K_DCX,    P_BC,     0,     1,  6,  0 },
+        { DCX_D,    K_DCX,    P_DE,     0,     1,  6,  0 },
+        { DCX_H,    K_DCX,    P_HL,     0,     1,  6,  0 },
+        { DCX_SP,   K_DCX,    P_SP,     0,     1,  6,  0 },
+        { DI,       K_DI,     0,        0,     1,  4,  0 },
+        { EI,       K_EI,     0,        0,     1,  4,  0 },
+        { HLT,      K_HLT,    0,        0,     1,  5,  0 },
+        { IN,       K_IN,     0,        0,     2, 10,  0 },
+        { INR_A,    K_INR,    R_A,      0,     1,  4,  0 },
+        { INR_B,    K_INR,    R_B,      0,     1,  4,  0 },
+        { INR_C,    K_INR,    R_C,      0,     1,  4,  0 },
+        { INR_D,    K_INR,    R_D,      0,     1,  4,  0 },
+        { INR_E,    K_INR,    R_E,      0,     1,  4,  0 },
+        { INR_H,    K_INR,    R_H,      0,     1,  4,  0 },
+        { INR_L,    K_INR,    R_L,      0,     1,  4,  0 },
+        { INR_M,    K_INR,    R_M,      0,     1, 10,  0 },
+        { INX_B,    K_INX,    P_BC,     0,     1,  6,  0 },
+        { INX_D,    K_INX,    P_DE,     0,     1,  6,  0 },
+        { INX_H,    K_INX,    P_HL,     0,     1,  6,  0 },
+        { INX_SP,   K_INX,    P_SP,     0,     1,  6,  0 },
+        { JC,       K_JMP,    C_C,      0,     3,  7, 10 },
+        { JM,       K_JMP,    C_M,      0,     3,  7, 10 },
+        { JMP,      K_JMP,    C_ALWAYS, 0,     3, 10,  0 },
+        { JNC,      K_JMP,    C_NC,     0,     3,  7, 10 },
+        { JNZ,      K_JMP,    C_NZ,     0,     3,  7, 10 },
+        { JP,       K_JMP,    C_P,      0,     3,  7, 10 },
+        { JPE,      K_JMP,    C_PE,     0,     3,  7, 10 },
+        { JPO,      K_JMP,    C_PO,     0,     3,  7, 10 },
+        { JZ,       K_JMP,    C_Z,      0,     3,  7, 10 },
+        { LDA,      K_LDA,    0,        0,     3, 13,  0 },
+        { LDAX_B,   K_LDAX,   P_BC,     0,     1,  7,  0 },
+        { LDAX_D,   K_LDAX,   P_DE,     0,     1,  7,  0 },
+        { LHLD,     K_LHLD,   0,        0,     3, 16,  0 },
+        { LXI_B,    K_LXI,    P_BC,     0,     3, 10,  0 },
+        { LXI_D,    K_LXI,    P_DE,     0,     3, 10,  0 },
+        { LXI_H,    K_LXI,    P_HL,     0,     3, 10,  0 },
+        { LXI_SP,   K_LXI,    P_SP,     0,     3, 10,  0 },
+        { MOV_A_A,  K_MOV,    R_A,      R_A,   1,  4,  0 },
+        { MOV_A_B,  K_MOV,    R_A,      R_B,   1,  4,  0 },
+        { MOV_A_C,  K_MOV,    R_A,      R_C,   1,  4,  0 },
+        { MOV_A_D,  K_MOV,    R_A,      R_D,   1,  4,  0 },
+        { MOV_A_E,  K_MOV,    R_A,      R_E,   1,  4,  0 },
+        { MOV_A_H,  K_MOV,    R_A,      R_H,   1,  4,  0 },
+        { MOV_A_L,  K_MOV,    R_A,      R_L,   1,  4,  0 },
+        { MOV_A_M,  K_MOV,    R_A,      R_M,   1,  7,  0 },
+        { MOV_B_A,  K_MOV,    R_B,      R_A,   1,  4,  0 },
+        { MOV_B_B,  K_MOV,    R_B,      R_B,   1,  4,  0 },
+        { MOV_B_C,  K_MOV,    R_B,      R_C,   1,  4,  0 },
+        { MOV_B_D,  K_MOV,    R_B,      R_D,   1,  4,  0 },
+        { MOV_B_E,  K_MOV,    R_B,      R_E,   1,  4,  0 },
+        { MOV_B_H,  K_MOV,    R_B,      R_H,   1,  4,  0 },
+        { MOV_B_L,  K_MOV,    R_B,      R_L,   1,  4,  0 },
+        { MOV_B_M,  K_MOV,    R_B,      R_M,   1,  7,  0 },
+        { MOV_C_A,  K_MOV,    R_C,      R_A,   1,  4,  0 },
+        { MOV_C_B,  K_MOV,    R_C,      R_B,   1,  4,  0 },
+        { MOV_C_C,  K_MOV,    R_C,      R_C,   1,  4,  0 },
+        { MOV_C_D,  K_MOV,    R_C,      R_D,   1,  4,  0 },
+        { MOV_C_E,  K_MOV,    R_C,      R_E,   1,  4,  0 },
+        { MOV_C_H,  K_MOV,    R_C,      R_H,   1,  4,  0 },
+        { MOV_C_L,  K_MOV,    R_C,      R_L,   1,  4,  0 },
+        { MOV_C_M,  K_MOV,    R_C,      R_M,   1,  7,  0 },
+        { MOV_D_A,  K_MOV,    R_D,      R_A,   1,  4,  0 },
+        { MOV_D_B,  K_MOV,    R_D,      R_B,   1,  4,  0 },
+        { MOV_D_C,  K_MOV,    R_D,      R_C,   1,  4,  0 },
+        { MOV_D_D,  K_MOV,    R_D,      R_D,   1,  4,  0 },
+        { MOV_D_E,  K_MOV,    R_D,      R_E,   1,  4,  0 },
+        { MOV_D_H,  K_MOV,    R_D,      R_H,   1,  4,  0 },
+        { MOV_D_L,  K_MOV,    R_D,      R_L,   1,  4,  0 },
+        { MOV_D_M,  K_MOV,    R_D,      R_M,   1,  7,  0 },
+        { MOV_E_A,  K_MOV,    R_E,      R_A,   1,  4,  0 },
+        { MOV_E_B,  K_MOV,    R_E,      R_B,   1,  4,  0 },
+        { MOV_E_C,  K_MOV,    R_E,      R_C,   1,  4,  0 },
+        { MOV_E_D,  K_MOV,    R_E,      R_D,   1,  4,  0 },
+        { MOV_E_E,  K_MOV,    R_E,      R_E,   1,  4,  0 },
+        { MOV_E_H,  K_MOV,    R_E,      R_H,   1,  4,  0 },
+        { MOV_E_L,  K_MOV,    R_E,      R_L,   1,  4,  0 },
+        { MOV_E_M,  K_MOV,    R_E,      R_M,   1,  7,  0 },
+        { MOV_H_A,  K_MOV,    R_H,      R_A,   1,  4,  0 },
+        { MOV_H_B,  K_MOV,    R_H,      R_B,   1,  4,  0 },
+        { MOV_H_C,  K_MOV,    R_H,      R_C,   1,  4,  0 },
+        { MOV_H_D,  K_MOV,    R_H,      R_D,   1,  4,  0 },
+        { MOV_H_E,  K_MOV,    R_H,      R_E,   1,  4,  0 },
+        { MOV_H_H,  K_MOV,    R_H,      R_H,   1,  4,  0 },
+        { MOV_H_L,  K_MOV,    R_H,      R_L,   1,  4,  0 },
+        { MOV_H_M,  K_MOV,    R_H,      R_M,   1,  7,  0 },
+        { MOV_L_A,  K_MOV,    R_L,      R_A,   1,  4,  0 },
+        { MOV_L_B,  K_MOV,    R_L,      R_B,   1,  4,  0 },
+        { MOV_L_C,  K_MOV,    R_L,      R_C,   1,  4,  0 },
+        { MOV_L_D,  K_MOV,    R_L,      R_D,   1,  4,  0 },
+        { MOV_L_E,  K_MOV,    R_L,      R_E,   1,  4,  0 },
+        { MOV_L_H,  K_MOV,    R_L,      R_H,   1,  4,  0 },
+        { MOV_L_L,  K_MOV,    R_L,      R_L,   1,  4,  0 },
+        { MOV_L_M,  K_MOV,    R_L,      R_M,   1,  7,  0 },
+        { MOV_M_A,  K_MOV,    R_M,      R_A,   1,  7,  0 },
+        { MOV_M_B,  K_MOV,    R_M,      R_B,   1,  7,  0 },
+        { MOV_M_C,  K_MOV,    R_M,      R_C,   1,  7,  0 },
+        { MOV_M_D,  K_MOV,    R_M,      R_D,   1,  7,  0 },
+        { MOV_M_E,  K_MOV,    R_M,      R_E,   1,  7,  0 },
+        { MOV_M_H,  K_MOV,    R_M,      R_H,   1,  7,  0 },
+        { MOV_M_L,  K_MOV,    R_M,      R_L,   1,  7,  0 },
+        { MVI_A,    K_MVI,    R_A,      0,     2,  7,  0 },
+        { MVI_B,    K_MVI,    R_B,      0,     2,  7,  0 },
+        { MVI_C,    K_MVI,    R_C,      0,     2,  7,  0 },
+        { MVI_D,    K_MVI,    R_D,      0,     2,  7,  0 },
+        { MVI_E,    K_MVI,    R_E,      0,     2,  7,  0 },
+        { MVI_H,    K_MVI,    R_H,      0,     2,  7,  0 },
+        { MVI_L,    K_MVI,    R_L,      0,     2,  7,  0 },
+        { MVI_M,    K_MVI,    R_M,      0,     2, 10,  0 },
+        { NOP,      K_NOP,    0,        0,     1,  4,  0 },
+        { ORA_A,    K_ALU,    ALU_ORA,  R_A,   1,  4,  0 },
+        { ORA_B,    K_ALU,    ALU_ORA,  R_B,   1,  4,  0 },
+        { ORA_C,    K_ALU,    ALU_ORA,  R_C,   1,  4,  0 },
+        { ORA_D,    K_ALU,    ALU_ORA,  R_D,   1,  4,  0 },
+        { ORA_E,    K_ALU,    ALU_ORA,  R_E,   1,  4,  0 },
+        { ORA_H,    K_ALU,    ALU_ORA,  R_H,   1,  4,  0 },
+        { ORA_L,    K_ALU,    ALU_ORA,  R_L,   1,  4,  0 },
+        { ORA_M,    K_ALU,    ALU_ORA,  R_M,   1,  7,  0 },
+        { ORI,      K_ALU,    ALU_ORA,  R_IMM, 2,  7,  0 },
+        { OUT,      K_OUT,    0,        0,     2, 10,  0 },
+        { PCHL,     K_PCHL,   0,        0,     1,  6,  0 },
+        { POP_B,    K_POP,    P_BC,     0,     1, 10,  0 },
+        { POP_D,    K_POP,    P_DE,     0,     1, 10,  0 },
+        { POP_H,    K_POP,    P_HL,     0,     1, 10,  0 },
+        { POP_PSW,  K_POP,    P_PSW,    0,     1, 10,  0 },
+        { PUSH_B,   K_PUSH,   P_BC,     0,     1, 12,  0 },
+        { PUSH_D,   K_PUSH,   P_DE,     0,     1, 12,  0 },
+        { PUSH_H,   K_PUSH,   P_HL,     0,     1, 12,  0 },
+        { PUSH_PSW, K_PUSH,   P_PSW,    0,     1, 12,  0 },
+        { RAL,      K_ROTATE, ROT_RAL,  0,     1,  4,  0 },
+        { RAR,      K_ROTATE, ROT_RAR,  0,     1,  4,  0 },
+        { RC,       K_RET,    C_C,      0,     1,  6, 12 },
+        { RET,      K_RET,    C_ALWAYS, 0,     1, 10,  0 },
+        { RIM,      K_RIM,    0,        0,     1,  4,  0 },
+        { RLC,      K_ROTATE, ROT_RLC,  0,     1,  4,  0 },
+        { RM,       K_RET,    C_M,      0,     1,  6, 12 },
+        { RNC,      K_RET,    C_NC,     0,     1,  6, 12 },
+        { RNZ,      K_RET,    C_NZ,     0,     1,  6, 12 },
+        { RP,       K_RET,    C_P,      0,     1,  6, 12 },
+        { RPE,      K_RET,    C_PE,     0,     1,  6, 12 },
+        { RPO,      K_RET,    C_PO,     0,     1,  6, 12 },
+        { RRC,      K_ROTATE, ROT_RRC,  0,     1,  4,  0 },
+        { RST_0,    K_RST,    0,        0,     1, 12,  0 },
+        { RST_1,    K_RST,    1,        0,     1, 12,  0 },
+        { RST_2,    K_RST,    2,        0,     1, 12,  0 },
+        { RST_3,    K_RST,    3,        0,     1, 12,  0 },
+        { RST_4,    K_RST,    4,        0,     1, 12,  0 },
+        { RST_5,    K_RST,    5,        0,     1, 12,  0 },
+        { RST_6,    K_RST,    6,        0,     1, 12,  0 },
+        { RST_7,    K_RST,    7,        0,     1, 12,  0 },
+        { RZ,       K_RET,    C_Z,      0,     1,  6, 12 },
+        { SBB_A,    K_ALU,    ALU_SBB,  R_A,   1,  4,  0 },
+        { SBB_B,    K_ALU,    ALU_SBB,  R_B,   1,  4,  0 },
+        { SBB_C,    K_ALU,    ALU_SBB,  R_C,   1,  4,  0 },
+        { SBB_D,    K_ALU,    ALU_SBB,  R_D,   1,  4,  0 },
+        { SBB_E,    K_ALU,    ALU_SBB,  R_E,   1,  4,  0 },
+        { SBB_H,    K_ALU,    ALU_SBB,  R_H,   1,  4,  0 },
+        { SBB_L,    K_ALU,    ALU_SBB,  R_L,   1,  4,  0 },
+        { SBB_M,    K_ALU,    ALU_SBB,  R_M,   1,  7,  0 },
+        { SBI,      K_ALU,    ALU_SBB,  R_IMM, 2,  7,  0 },
+        { SHLD,     K_SHLD,   0,        0,     3, 16,  0 },
+        { SIM,      K_SIM,    0,        0,     1,  4,  0 },
+        { SPHL,     K_SPHL,   0,        0,     1,  6,  0 },
+        { STA,      K_STA,    0,        0,     3, 13,  0 },
+        { STAX_B,   K_STAX,   P_BC,     0,     1,  7,  0 },
+        { STAX_D,   K_STAX,   P_DE,     0,     1,  7,  0 },
+        { STAX_H,   K_STAX,   P_HL,     0,     1,  7,  0 },
+        { STC,      K_STC,    0,        0,     1,  4,  0 },
+        { SUB_A,    K_ALU,    ALU_SUB,  R_A,   1,  4,  0 },
+        { SUB_B,    K_ALU,    ALU_SUB,  R_B,   1,  4,  0 },
+        { SUB_C,    K_ALU,    ALU_SUB,  R_C,   1,  4,  0 },
+        { SUB_D,    K_ALU,    ALU_SUB,  R_D,   1,  4,  0 },
+        { SUB_E,    K_ALU,    ALU_SUB,  R_E,   1,  4,  0 },
+        { SUB_H,    K_ALU,    ALU_SUB,  R_H,   1,  4,  0 },
+        { SUB_L,    K_ALU,    ALU_SUB,  R_L,   1,  4,  0 },
+        { SUB_M,    K_ALU,    ALU_SUB,  R_M,   1,  7,  0 },
+        { SUI,      K_ALU,    ALU_SUB,  R_IMM, 2,  7,  0 },
+        { XCHG,     K_XCHG,   0,        0,     1,  4,  0 },
+        { XRA_A,    K_ALU,    ALU_XRA,  R_A,   1,  4,  0 },
+        { XRA_B,    K_ALU,    ALU_XRA,  R_B,   1,  4,  0 },
+        { XRA_C,    K_ALU,    ALU_XRA,  R_C,   1,  4,  0 },
+        { XRA_D,    K_ALU,    ALU_XRA,  R_D,   1,  4,  0 },
+        { XRA_E,    K_ALU,    ALU_XRA,  R_E,   1,  4,  0 },
+        { XRA_H,    K_ALU,    ALU_XRA,  R_H,   1,  4,  0 },
+        { XRA_L,    K_ALU,    ALU_XRA,  R_L,   1,  4,  0 },
+        { XRA_M,    K_ALU,    ALU_XRA,  R_M,   1,  7,  0 },
+        { XRI,      K_ALU,    ALU_XRA,  R_IMM, 2,  7,  0 },
+        { XTHL,     K_XTHL,   0,        0,     1, 16,  0 },
+    };
+
+    struct DecodeTable
+    {
+        Decoded entries[256];
+        uint8_t szp[256];
+
+        DecodeTable()
+        {
+            for(int i = 0; i < 256; i ++)
+            {
+                // Bytes past the last opcode are skipped without taking time, like Processor does
+                entries[i] = Decoded{ NOP, K_NONE, 0, 0, 1, 0, 0 };
+
+                int bits = 0;
+                for(int b = 0; b < 8; b ++)
+                {
+                    bits += (i >> b) & 1;
+                }
+
+                szp[i] = (i & 0x80 ? F_S : 0) | (i == 0 ? F_Z : 0) | (bits % 2 == 0 ? F_P : 0);
+            }
+
+            for(const Decoded& d : _decode_list)
+            {
+                entries[d.opcode] = d;
+            }
+        }
+    };
+
+    static const DecodeTable _table;
+
+    ReferenceCpu::ReferenceCpu() : _memory(65536, 0)
+    {
+        std::memset(_dirty, 0, sizeof(_dirty));
+        reset();
+    }
+
+    void ReferenceCpu::reset()
+    {
+        std::memset(regs, 0, sizeof(regs));
+        flags = F_ONE;
+        pc = 0;
+        sp = 0;
+        interrupt_enable = false;
+        interrupt_mask = 0x07;
+        serial_output = false;
+        halted = false;
+        cycles = 0;
+        write_count = 0;
+    }
+
+    void ReferenceCpu::clear_memory()
+    {
+        for(int page = 0; page < 256; page ++)
+        {
+            if(_dirty[page])
+            {
+                std::memset(&_memory[page * 256], 0, 256);
+                _dirty[page] = false;
+            }
+        }
+    }
+
+    uint8_t ReferenceCpu::read(uint16_t address) const
+    {
+        return _memory[address];
+    }
+
+    void ReferenceCpu::write(uint16_t address, uint8_t value)
+    {
+        _memory[address] = value;
+        _dirty[address >> 8] = true;
+
+        if(write_count < 2)
+        {
+            writes[write_count++] = Write{ address, value };
+        }
+    }
+
+    const uint8_t* ReferenceCpu::page(int page) const
+    {
+        return &_memory[page * 256];
+    }
+
+    int ReferenceCpu::length(uint8_t opcode)
+    {
+        return _table.entries[opcode].kind == K_NONE ? 0 : _table.entries[opcode].length;
+    }
+
+    uint8_t ReferenceCpu::fetch()
+    {
+        return _memory[pc++];
+    }
+
+    uint16_t ReferenceCpu::fetch16()
+    {
+        uint8_t low = fetch();
+        return (uint16_t)(low | (fetch() << 8));
+    }
+
+    uint16_t ReferenceCpu::get_pair(int pair) const
+    {
+        if(pair == P_SP)
+        {
+            return sp;
+        }
+        return (uint16_t)((regs[pair * 2] << 8) | regs[pair * 2 + 1]);
+    }
+
+    void ReferenceCpu::set_pair(int pair, uint16_t value)
+    {
+        if(pair == P_SP)
+        {
+            sp = value;
+            return;
+        }
+        regs[pair * 2] = value >> 8;
+        regs[pair * 2 + 1] = value & 0xff;
+    }
+
+    bool ReferenceCpu::condition(int cond) const
+    {
+        // Odd conditions test for a set flag, even ones for a clear flag
+        static const uint8_t cond_flag[4] = { F_Z, F_CY, F_P, F_S };
+
+        if(cond == C_ALWAYS)
+        {
+            return true;
+        }
+
+        bool set = (flags & cond_flag[cond / 2]) != 0;
+        return (cond & 1) ? set : !set;
+    }
+
+    void ReferenceCpu::push(uint16_t value)
+    {
+        write(--sp, value >> 8);
+        write(--sp, value & 0xff);
+    }
+
+    uint16_t ReferenceCpu::pop()
+    {
+        uint16_t value = _memory[sp++];
+        return value | (_memory[sp++] << 8);
+    }
+
+    void ReferenceCpu::alu(int op, uint8_t value)
+    {
+        uint8_t a = regs[R_A];
+        unsigned carry_in = flags & F_CY;
+        unsigned result;
+        uint8_t new_flags = F_ONE;
+
+        switch(op)
+        {
+            case ALU_ADD:
+            case ALU_ADC:
+                result = a + value + (op == ALU_ADC ? carry_in : 0);
+                new_flags |= (result > 0xff ? F_CY : 0) | ((a ^ value ^ result) & 0x10 ? F_AC : 0);
+                break;
+            case ALU_SUB:
+            case ALU_SBB:
+            case ALU_CMP:
+            {
+                // Added as a + ~value + 1 - borrow, AC is the carry out of bit 3 of that sum
+                unsigned borrow = op == ALU_SBB ? carry_in : 0;
+                uint8_t complement = (uint8_t)~value;
+                result = a + complement + 1 - borrow;
+                new_flags |= (a < value + borrow ? F_CY : 0) | ((a ^ complement ^ result) & 0x10 ? F_AC : 0);
+                break;
+            }
+            case ALU_ANA:
+                result = a & value;
+                new_flags |= F_AC;
+                break;
+            case ALU_XRA:
+                result = a ^ value;
+                break;
+            default:
+                result = a | value;
+                break;
+        }
+
+        result &= 0xff;
+        flags = new_flags | _table.szp[result];
+
+        if(op != ALU_CMP)
+        {
+            regs[R_A] = (uint8_t)result;
+        }
+    }
+
+    void ReferenceCpu::step()
+    {
+        write_count = 0;
+
+        if(halted)
+        {
+            cycles++;
+            return;
+        }
+
+        const Decoded& d = _table.entries[fetch()];
+        uint16_t hl = get_pair(P_HL);
+        cycles += d.cycles;
+
+        switch(d.kind)
+        {
+            case K_MOV:
+            {
+                uint8_t value = d.b == R_M ? read(hl) : regs[d.b];
+                if(d.a == R_M) write(hl, value); else regs[d.a] = value;
+                break;
+            }
+            case K_MVI:
+            {
+                uint8_t value = fetch();
+                if(d.a == R_M) write(hl, value); else regs[d.a] = value;
+                break;
+            }
+            case K_LXI:
+                set_pair(d.a, fetch16());
+                break;
+            case K_ALU:
+                alu(d.a, d.b == R_IMM ? fetch() : d.b == R_M ? read(hl) : regs[d.b]);
+                break;
+            case K_INR:
+            case K_DCR:
+            {
+                uint8_t value = d.a == R_M ? read(hl) : regs[d.a];
+                uint8_t result = d.kind == K_INR ? value + 1 : value - 1;
+                bool half = d.kind == K_INR ? (result & 0x0f) == 0x00 : (result & 0x0f) != 0x0f;
+
+                flags = (flags & F_CY) | F_ONE | (half ? F_AC : 0) | _table.szp[result];
+                if(d.a == R_M) write(hl, result); else regs[d.a] = result;
+                break;
+            }
+            case K_INX:
+                set_pair(d.a, get_pair(d.a) + 1);
+                break;
+            case K_DCX:
+                set_pair(d.a, get_pair(d.a) - 1);
+                break;
+            case K_DAD:
+            {
+                uint32_t sum = (uint32_t)hl + get_pair(d.a);
+                flags = (flags & ~F_CY) | (sum > 0xffff ? F_CY : 0);
+                set_pair(P_HL, (uint16_t)sum);
+                break;
+            }
+            case K_LDAX:
+                regs[R_A] = read(get_pair(d.a));
+                break;
+            case K_STAX:
+                write(get_pair(d.a), regs[R_A]);
+                break;
+            case K_LDA:
+                regs[R_A] = read(fetch16());
+                break;
+            case K_STA:
+                write(fetch16(), regs[R_A]);
+                break;
+            case K_LHLD:
+            {
+                uint16_t address = fetch16();
+                regs[R_L] = read(address);
+                regs[R_H] = read(address + 1);
+                break;
+            }
+            case K_SHLD:
+            {
+                uint16_t address = fetch16();
+                write(address, regs[R_L]);
+                write(address + 1, regs[R_H]);
+                break;
+            }
+            case K_XCHG:
+            {
+                uint16_t de = get_pair(P_DE);
+                set_pair(P_DE, hl);
+                set_pair(P_HL, de);
+                break;
+            }
+            case K_XTHL:
+            {
+                uint16_t top = (uint16_t)(read(sp) | (read(sp + 1) << 8));
+                write(sp, regs[R_L]);
+                write(sp + 1, regs[R_H]);
+                set_pair(P_HL, top);
+                break;
+            }
+            case K_SPHL:
+                sp = hl;
+                break;
+            case K_PCHL:
+                pc = hl;
+                break;
+            case K_PUSH:
+                push(d.a == P_PSW ? (uint16_t)((regs[R_A] << 8) | flags) : get_pair(d.a));
+                break;
+            case K_POP:
+            {
+                uint16_t value = pop();
+                if(d.a == P_PSW)
+                {
+                    regs[R_A] = value >> 8;
+                    flags = (value & (F_S | F_Z | F_AC | F_P | F_CY)) | F_ONE;
+                }
+                else
+                {
+                    set_pair(d.a, value);
+                }
+                break;
+            }
+            case K_JMP:
+            {
+                uint16_t address = fetch16();
+                if(condition(d.a))
+                {
+                    pc = address;
+                    cycles += d.taken_cycles ? d.taken_cycles - d.cycles : 0;
+                }
+                break;
+            }
+            case K_CALL:
+            {
+                uint16_t address = fetch16();
+                if(condition(d.a))
+                {
+                    push(pc);
+                    pc = address;
+                    cycles += d.taken_cycles ? d.taken_cycles - d.cycles : 0;
+                }
+                break;
+            }
+            case K_RET:
+                if(condition(d.a))
+                {
+                    pc = pop();
+                    cycles += d.taken_cycles ? d.taken_cycles - d.cycles : 0;
+                }
+                break;
+            case K_RST:
+                push(pc);
+                pc = (uint16_t)(d.a * 8);
+                break;
+            case K_ROTATE:
+            {
+                uint8_t a = regs[R_A];
+                bool carry = (flags & F_CY) != 0;
+                bool out;
+
+                switch(d.a)
+                {
+                    case ROT_RLC: out = (a >> 7) != 0; a = (uint8_t)((a << 1) | out); break;
+                    case ROT_RRC: out = (a & 1) != 0; a = (uint8_t)((a >> 1) | (out << 7)); break;
+                    case ROT_RAL: out = (a >> 7) != 0; a = (uint8_t)((a << 1) | carry); break;
+                    default:      out = (a & 1) != 0; a = (uint8_t)((a >> 1) | (carry << 7)); break;
+                }
+
+                regs[R_A] = a;
+                flags = (flags & ~F_CY) | (out ? F_CY : 0);
+                break;
+            }
+            case K_DAA:
+            {
+                // Low digit first, the high digit is checked on the corrected value
+                unsigned a = regs[R_A];
+                bool half = false;
+                bool carry = (flags & F_CY) != 0;
+
+                if((a & 0x0f) > 9 || (flags & F_AC))
+                {
+                    half = (a & 0x0f) + 6 > 0x0f;
+                    a += 6;
+                }
+                if((a >> 4) > 9 || carry)
+                {
+                    a += 0x60;
+                }
+
+                carry = carry || a > 0xff;
+                regs[R_A] = (uint8_t)a;
+                flags = F_ONE | (carry ? F_CY : 0) | (half ? F_AC : 0) | _table.szp[regs[R_A]];
+                break;
+            }
+            case K_CMA:
+                regs[R_A] = (uint8_t)~regs[R_A];
+                break;
+            case K_CMC:
+                flags ^= F_CY;
+                break;
+            case K_STC:
+                flags |= F_CY;
+                break;
+            case K_HLT:
+                halted = true;
+                break;
+            case K_IN:
+                fetch();
+                regs[R_A] = 0xff;
+                break;
+            case K_OUT:
+                fetch();
+                break;
+            case K_EI:
+                interrupt_enable = true;
+                break;
+            case K_DI:
+                interrupt_enable = false;
+                break;
+            case K_RIM:
+                // No device drives SID and nothing is pending without interrupts
+                regs[R_A] = (interrupt_enable ? 0x08 : 0x00) | (interrupt_mask & 0x07);
+                break;
+            case K_SIM:
+                if(regs[R_A] & 0x08) interrupt_mask = regs[R_A] & 0x07;
+                if(regs[R_A] & 0x40) serial_output = (regs[R_A] & 0x80) != 0;
+                break;
+            case K_NOP:
+            case K_NONE:
+                break;
+        }
+    }
+}
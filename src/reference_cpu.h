@@ -0,0 +1,79 @@
+#pragma once
+#include "instruction_set.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace lib8085
+{
+    // Register indices in the order the 8085 opcode fields encode them
+    enum ReferenceRegister
+    {
+        R_B, R_C, R_D, R_E, R_H, R_L, R_M, R_A,
+        R_IMM
+    };
+
+    /*
+     * Independent 8085 model the differential tester checks Processor against.
+     *
+     * Opcodes are decoded through one table of operation kind and operand fields
+     * rather than a case per opcode, registers live in an array indexed like the
+     * opcode fields and flags are kept as a PSW byte built from lookup tables.
+     * Apart from the opcode enum nothing is shared with Processor.
+     *
+     * Without devices IN reads FFh and OUT is discarded, a halted step idles for
+     * one cycle, the same conventions Processor uses.
+     *
+     */
+    class ReferenceCpu
+    {
+        public:
+            struct Write
+            {
+                uint16_t address;
+                uint8_t value;
+            };
+
+            uint8_t regs[8];
+            uint8_t flags; // PSW layout S Z 0 AC 0 P 1 CY
+            uint16_t pc, sp;
+            bool interrupt_enable;
+            uint8_t interrupt_mask;
+            bool serial_output;
+            bool halted;
+            uint64_t cycles;
+
+            // Memory writes done by the last step
+            Write writes[2];
+            int write_count;
+
+            ReferenceCpu();
+
+            // Registers and flags to their reset state, memory is left alone
+            void reset();
+            // Zeroes every page written since the last clear
+            void clear_memory();
+
+            uint8_t read(uint16_t address) const;
+            void write(uint16_t address, uint8_t value);
+            const uint8_t* page(int page) const;
+
+            void step();
+
+            // Instruction length in bytes, 0 for bytes that aren't opcodes
+            static int length(uint8_t opcode);
+
+        private:
+            std::vector<uint8_t> _memory;
+            bool _dirty[256];
+
+            uint8_t fetch();
+            uint16_t fetch16();
+            uint16_t get_pair(int pair) const;
+            void set_pair(int pair, uint16_t value);
+            bool condition(int cond) const;
+            void push(uint16_t value);
+            uint16_t pop();
+            void alu(int op, uint8_t value);
+    };
+}
@@ -0,0 +1,419 @@
+#include "savestate.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace lib8085
+{
+    static const char _savestate_magic[4] = { 'R', '8', '5', 'S' };
+
+    // Header field offsets
+    enum
+    {
+        HDR_MAGIC             = 0,
+        HDR_VERSION           = 4,
+        HDR_PAGE_SIZE         = 6,
+        HDR_REGS              = 8,  // a, b, c, d, e, h, l
+        HDR_FLAGS             = 15, // PSW layout S Z - AC - P - CY
+        HDR_PC                = 16,
+        HDR_SP                = 18,
+        HDR_INTERRUPT_ENABLE  = 20,
+        HDR_INTERRUPT_MASK    = 21,
+        HDR_INTERRUPT_PENDING = 22,
+        HDR_STATE_BITS        = 23, // sod, halted, interrupt shadow
+        HDR_CYCLES            = 24,
+        HDR_PAGE_COUNT        = 32,
+        HDR_DEVICE_OFFSET     = 36,
+        HDR_DEVICE_SIZE       = 40,
+        HDR_PAGE_BITMAP       = 64
+    };
+
+    static void put_16(uint8_t* p, uint16_t v)
+    {
+        p[0] = (uint8_t)v;
+        p[1] = (uint8_t)(v >> 8);
+    }
+
+    static void put_32(uint8_t* p, uint32_t v)
+    {
+        for(int i = 0; i < 4; i ++)
+        {
+            p[i] = (uint8_t)(v >> (i * 8));
+        }
+    }
+
+    static void put_64(uint8_t* p, uint64_t v)
+    {
+        for(int i = 0; i < 8; i ++)
+        {
+            p[i] = (uint8_t)(v >> (i * 8));
+        }
+    }
+
+    static uint16_t get_16(const uint8_t* p)
+    {
+        return (uint16_t)(p[0] | (p[1] << 8));
+    }
+
+    static uint32_t get_32(const uint8_t* p)
+    {
+        uint32_t v = 0;
+        for(int i = 3; i >= 0; i --)
+        {
+            v = (v << 8) | p[i];
+        }
+        return v;
+    }
+
+    static uint64_t get_64(const uint8_t* p)
+    {
+        uint64_t v = 0;
+        for(int i = 7; i >= 0; i --)
+        {
+            v = (v << 8) | p[i];
+        }
+        return v;
+    }
+
+    static bool is_zero_page(const uint8_t* page)
+    {
+        for(size_t i = 0; i < SaveState::PAGE_SIZE; i ++)
+        {
+            if(page[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Read only view of a savestate file, unmapped once neither the SaveState
+    // nor a processor restored from it holds on to it
+    class SaveState::Mapping
+    {
+        public:
+            const uint8_t* data = nullptr;
+            size_t size = 0;
+#ifdef _WIN32
+            HANDLE file = INVALID_HANDLE_VALUE;
+            HANDLE mapping = nullptr;
+#endif
+
+            ~Mapping()
+            {
+#ifdef _WIN32
+                if(data)
+                {
+                    UnmapViewOfFile(data);
+                }
+                if(mapping)
+                {
+                    CloseHandle(mapping);
+                }
+                if(file != INVALID_HANDLE_VALUE)
+                {
+                    CloseHandle(file);
+                }
+#else
+                if(data)
+                {
+                    munmap(const_cast<uint8_t*>(data), size);
+                }
+#endif
+            }
+    };
+
+    SaveState::SaveState() : _data(nullptr), _size(0), _device_state(nullptr), _device_state_size(0)
+    {
+    }
+
+    SaveState::~SaveState()
+    {
+        close();
+    }
+
+    bool SaveState::save(const Processor& cpu, const char* path)
+    {
+        std::vector<uint8_t> header(HEADER_SIZE, 0);
+        uint8_t* h = header.data();
+
+        std::memcpy(h + HDR_MAGIC, _savestate_magic, sizeof(_savestate_magic));
+        put_16(h + HDR_VERSION, VERSION);
+        put_16(h + HDR_PAGE_SIZE, (uint16_t)PAGE_SIZE);
+
+        uint8_t regs[7] = { cpu.reg_a, cpu.reg_b, cpu.reg_c, cpu.reg_d, cpu.reg_e, cpu.reg_h, cpu.reg_l };
+        std::memcpy(h + HDR_REGS, regs, sizeof(regs));
+
+        h[HDR_FLAGS] = cpu.get_flags();
+
+        put_16(h + HDR_PC, cpu.program_counter);
+        put_16(h + HDR_SP, cpu.stack_pointer);
+
+        h[HDR_INTERRUPT_ENABLE]  = cpu.interrupt_enable ? 1 : 0;
+        h[HDR_INTERRUPT_MASK]    = cpu.interrupt_mask;
+        h[HDR_INTERRUPT_PENDING] = cpu.interrupt_pending;
+        h[HDR_STATE_BITS] = (cpu.serial_output ? 0x01 : 0) | (cpu.halted ? 0x02 : 0) | (cpu._interrupt_shadow ? 0x04 : 0);
+
+        put_64(h + HDR_CYCLES, cpu.cycles);
+
+        // ROM is configuration rather than state and is never stored
+        uint32_t page_count = 0;
+        for(size_t page = 0; page < PAGE_COUNT; page ++)
+        {
+            if(cpu.is_ram_page_used(page) && !is_zero_page(cpu.get_page(page)))
+            {
+                h[HDR_PAGE_BITMAP + page / 8] |= 1 << (page % 8);
+                page_count++;
+            }
+        }
+
+        std::vector<uint8_t> device_state;
+        if(cpu._bus)
+        {
+            cpu._bus->save_state(device_state);
+        }
+
+        put_32(h + HDR_PAGE_COUNT, page_count);
+        put_32(h + HDR_DEVICE_OFFSET, (uint32_t)(HEADER_SIZE + page_count * PAGE_SIZE));
+        put_32(h + HDR_DEVICE_SIZE, (uint32_t)device_state.size());
+
+        std::ofstream file(path, std::ios::out | std::ios::binary);
+
+        if(!file.good() || !file.is_open())
+        {
+            std::cerr << "Error writing savestate \'" << path << "\'\n";
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+        for(size_t page = 0; page < PAGE_COUNT; page ++)
+        {
+            if(h[HDR_PAGE_BITMAP + page / 8] & (1 << (page % 8)))
+            {
+                file.write(reinterpret_cast<const char*>(cpu.get_page(page)), PAGE_SIZE);
+            }
+        }
+
+        file.write(reinterpret_cast<const char*>(device_state.data()), device_state.size());
+
+        return file.good();
+    }
+
+    bool SaveState::load(const char* path)
+    {
+        close();
+
+        std::shared_ptr<Mapping> mapping = std::make_shared<Mapping>();
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+        if(file == INVALID_HANDLE_VALUE)
+        {
+            std::cerr << "Error reading savestate \'" << path << "\'\n";
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        GetFileSizeEx(file, &size);
+
+        mapping->file = file;
+        mapping->mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping->mapping ? MapViewOfFile(mapping->mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+
+        if(!view)
+        {
+            std::cerr << "Error mapping savestate \'" << path << "\'\n";
+            return false;
+        }
+
+        mapping->data = static_cast<const uint8_t*>(view);
+        mapping->size = (size_t)size.QuadPart;
+#else
+        int fd = open(path, O_RDONLY);
+
+        if(fd < 0)
+        {
+            std::cerr << "Error reading savestate \'" << path << "\'\n";
+            return false;
+        }
+
+        struct stat st;
+        void* view = MAP_FAILED;
+
+        if(fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+
+        // The mapping keeps the file alive
+        ::close(fd);
+
+        if(view == MAP_FAILED)
+        {
+            std::cerr << "Error mapping savestate \'" << path << "\'\n";
+            return false;
+        }
+
+        mapping->data = static_cast<const uint8_t*>(view);
+        mapping->size = (size_t)st.st_size;
+#endif
+
+        _mapping = mapping;
+        _data = mapping->data;
+        _size = mapping->size;
+
+        if(!parse_header())
+        {
+            std::cerr << "\'" << path << "\' is not a supported savestate\n";
+            close();
+            return false;
+        }
+
+        return true;
+    }
+
+    void SaveState::close()
+    {
+        // Processors restored from the state may still read from the mapping
+        _mapping.reset();
+        _data = nullptr;
+        _size = 0;
+        _device_state = nullptr;
+        _device_state_size = 0;
+    }
+
+    bool SaveState::is_loaded() const
+    {
+        return _data != nullptr;
+    }
+
+    bool SaveState::parse_header()
+    {
+        if(_size < HEADER_SIZE
+                || std::memcmp(_data + HDR_MAGIC, _savestate_magic, sizeof(_savestate_magic)) != 0
+                || get_16(_data + HDR_VERSION) != VERSION
+                || get_16(_data + HDR_PAGE_SIZE) != PAGE_SIZE)
+        {
+            return false;
+        }
+
+        uint32_t page_count = get_32(_data + HDR_PAGE_COUNT);
+        uint32_t device_offset = get_32(_data + HDR_DEVICE_OFFSET);
+        uint32_t device_size = get_32(_data + HDR_DEVICE_SIZE);
+
+        if(page_count > PAGE_COUNT
+                || device_offset != HEADER_SIZE + page_count * PAGE_SIZE
+                || (uint64_t)device_offset + device_size > _size)
+        {
+            return false;
+        }
+
+        // Resolve where each page lives once so restore only maps them
+        const uint8_t* page_data = _data + HEADER_SIZE;
+        uint32_t stored = 0;
+
+        for(size_t page = 0; page < PAGE_COUNT; page ++)
+        {
+            if(_data[HDR_PAGE_BITMAP + page / 8] & (1 << (page % 8)))
+            {
+                _pages[page] = page_data;
+                page_data += PAGE_SIZE;
+                stored++;
+            }
+            else
+            {
+                _pages[page] = nullptr;
+            }
+        }
+
+        if(stored != page_count)
+        {
+            return false;
+        }
+
+        _device_state = _data + device_offset;
+        _device_state_size = device_size;
+
+        return true;
+    }
+
+    bool SaveState::restore(Processor& cpu) const
+    {
+        if(!_data)
+        {
+            return false;
+        }
+
+        const uint8_t* regs = _data + HDR_REGS;
+        cpu.reg_a = regs[0];
+        cpu.reg_b = regs[1];
+        cpu.reg_c = regs[2];
+        cpu.reg_d = regs[3];
+        cpu.reg_e = regs[4];
+        cpu.reg_h = regs[5];
+        cpu.reg_l = regs[6];
+
+        cpu.set_flags(_data[HDR_FLAGS]);
+
+        cpu.program_counter = get_16(_data + HDR_PC);
+        cpu.stack_pointer   = get_16(_data + HDR_SP);
+
+        uint8_t state_bits = _data[HDR_STATE_BITS];
+        cpu.interrupt_enable  = _data[HDR_INTERRUPT_ENABLE] != 0;
+        cpu.interrupt_mask    = _data[HDR_INTERRUPT_MASK];
+        cpu.interrupt_pending = _data[HDR_INTERRUPT_PENDING];
+        cpu.serial_output     = (state_bits & 0x01) != 0;
+        cpu.halted            = (state_bits & 0x02) != 0;
+        cpu._interrupt_shadow = (state_bits & 0x04) != 0;
+        cpu._interrupt_requests.store(0);
+
+        cpu.cycles = get_64(_data + HDR_CYCLES);
+
+        // Stored pages are read in place until written. Pages the cpu never
+        // wrote and the state doesn't store are left alone
+        for(size_t page = 0; page < PAGE_COUNT; page ++)
+        {
+            if(cpu.is_rom_page(page))
+            {
+                continue;
+            }
+
+            if(_pages[page])
+            {
+                cpu.share_page(page, _pages[page]);
+            }
+            else if(cpu.is_ram_page_used(page))
+            {
+                cpu.release_page(page);
+            }
+        }
+
+        // Nothing reads from a mapping restored before anymore
+        cpu._shared_memory = _mapping;
+
+        if(cpu._bus)
+        {
+            if(!cpu._bus->load_state(_device_state, _device_state_size))
+            {
+                return false;
+            }
+            cpu._bus_event_cycle = cpu._bus->next_event_cycle();
+        }
+
+        return true;
+    }
+}
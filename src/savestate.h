@@ -0,0 +1,63 @@
+#pragma once
+#include "lib8085.h"
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+
+namespace lib8085
+{
+    /*
+     * Versioned binary snapshot of a Processor.
+     *
+     * Layout (little endian):
+     *   256 byte header   - magic "R85S", version, registers, flags, interrupt
+     *                       state, cycle count, bitmap of stored memory pages
+     *   stored pages      - 256 bytes each, all-zero RAM pages and ROM pages
+     *                       are left out
+     *   device state      - opaque blob produced by the attached IoBus
+     *
+     * Pages sit on 256 byte boundaries so a mapped file can be read in place.
+     *
+     */
+    class SaveState
+    {
+        public:
+            static const uint16_t VERSION    = 1;
+            static const size_t PAGE_SIZE    = MEM_PAGE_SIZE;
+            static const size_t PAGE_COUNT   = MEM_PAGE_COUNT;
+            static const size_t HEADER_SIZE  = 256;
+
+            SaveState();
+            ~SaveState();
+
+            SaveState(const SaveState&) = delete;
+            SaveState& operator=(const SaveState&) = delete;
+
+            static bool save(const Processor& cpu, const char* path);
+
+            // Maps the file, only the header is validated up front
+            bool load(const char* path);
+            void close();
+
+            // Copies registers and device state into cpu and maps the stored pages
+            // read only, a page is copied on its first write. cpu keeps the mapping
+            // alive until reset or restored again. Pages that were elided are cleared.
+            bool restore(Processor& cpu) const;
+
+            bool is_loaded() const;
+
+        private:
+            class Mapping;
+
+            std::shared_ptr<const Mapping> _mapping;
+            const uint8_t* _data;
+            size_t _size;
+
+            const uint8_t* _pages[PAGE_COUNT];
+            const uint8_t* _device_state;
+            size_t _device_state_size;
+
+            bool parse_header();
+    };
+}
@@ -0,0 +1,106 @@
+#include "source_map.h"
+
+#include <iomanip>
+#include <sstream>
+
+namespace lib8085
+{
+    SourceMap::SourceMap()
+    {
+    }
+
+    SourceMap::SourceMap(const Assembler& assembler, const std::string& code)
+        : _lines(assembler._source_lines), _labels(assembler.get_labels()), _program(assembler._program_instructions)
+    {
+        std::stringstream ss(code);
+        std::string line;
+
+        while(std::getline(ss, line))
+        {
+            _text.push_back(line);
+        }
+    }
+
+    bool SourceMap::empty() const
+    {
+        return _lines.empty() && _labels.empty();
+    }
+
+    int SourceMap::line(uint16_t address) const
+    {
+        std::map<uint16_t, int>::const_iterator it = _lines.find(address);
+        return it != _lines.end() ? it->second : 0;
+    }
+
+    std::string SourceMap::text(int line) const
+    {
+        if(line < 1 || (size_t)line > _text.size())
+        {
+            return std::string();
+        }
+
+        std::string text = _text[line - 1];
+        text = text.substr(0, text.find(';'));
+
+        size_t start = text.find_first_not_of(" \t\r");
+        if(start == std::string::npos)
+        {
+            return std::string();
+        }
+
+        return text.substr(start, text.find_last_not_of(" \t\r") - start + 1);
+    }
+
+    bool SourceMap::routine(uint16_t address, uint16_t& start) const
+    {
+        std::map<uint16_t, std::string>::const_iterator it = _labels.upper_bound(address);
+
+        if(it == _labels.begin())
+        {
+            return false;
+        }
+
+        start = (--it)->first;
+        return true;
+    }
+
+    std::string SourceMap::location(uint16_t address) const
+    {
+        uint16_t start;
+
+        if(!routine(address, start))
+        {
+            return format_address(address);
+        }
+
+        const std::string& label = _labels.at(start);
+        return address == start ? label : label + "+" + std::to_string(address - start);
+    }
+
+    const std::map<uint16_t, int>& SourceMap::lines() const
+    {
+        return _lines;
+    }
+
+    const std::map<uint16_t, std::string>& SourceMap::labels() const
+    {
+        return _labels;
+    }
+
+    size_t SourceMap::line_count() const
+    {
+        return _text.size();
+    }
+
+    const std::vector<uint8_t>& SourceMap::program() const
+    {
+        return _program;
+    }
+
+    std::string format_address(uint16_t address)
+    {
+        std::stringstream ss;
+        ss << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << address << "H";
+        return ss.str();
+    }
+}
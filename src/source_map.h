@@ -0,0 +1,52 @@
+#pragma once
+#include "assembler.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Maps addresses of an assembled program back to its source, the line each
+     * instruction came from and the labels. Programs loaded as binaries have an
+     * empty map and reports fall back to plain addresses.
+     *
+     */
+    class SourceMap
+    {
+        public:
+            SourceMap();
+            // code is the text the assembler was given
+            SourceMap(const Assembler& assembler, const std::string& code);
+
+            bool empty() const;
+
+            // Source line of the instruction starting at address, 0 when unknown
+            int line(uint16_t address) const;
+            // Line text without the comment and surrounding blanks
+            std::string text(int line) const;
+
+            // Nearest label at or before address as "loop+3", the address in hex without one
+            std::string location(uint16_t address) const;
+            // Address of the nearest label at or before address, false without one
+            bool routine(uint16_t address, uint16_t& start) const;
+
+            const std::map<uint16_t, int>& lines() const;
+            const std::map<uint16_t, std::string>& labels() const;
+            size_t line_count() const;
+
+            // Assembled bytes starting at address 0
+            const std::vector<uint8_t>& program() const;
+
+        private:
+            std::map<uint16_t, int> _lines;
+            std::map<uint16_t, std::string> _labels;
+            std::vector<uint8_t> _program;
+            std::vector<std::string> _text;
+    };
+
+    // Hex address the way the assembler writes it, 01A0H
+    std::string format_address(uint16_t address);
+}
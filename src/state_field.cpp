@@ -0,0 +1,114 @@
+#include "state_field.h"
+#include "assembler_util.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace lib8085
+{
+    struct TargetName
+    {
+        const char* name;
+        StateTarget target;
+        uint32_t max_value;
+    };
+
+    static const TargetName _target_names[] = {
+        { "A",  TARGET_A,  0xff },   { "B",  TARGET_B,  0xff },   { "C",  TARGET_C,  0xff },
+        { "D",  TARGET_D,  0xff },   { "E",  TARGET_E,  0xff },   { "H",  TARGET_H,  0xff },
+        { "L",  TARGET_L,  0xff },   { "BC", TARGET_BC, 0xffff }, { "DE", TARGET_DE, 0xffff },
+        { "HL", TARGET_HL, 0xffff }, { "SP", TARGET_SP, 0xffff }, { "PC", TARGET_PC, 0xffff },
+        { "S",  TARGET_SIGN, 1 },    { "Z",  TARGET_ZERO, 1 },    { "P",  TARGET_PARITY, 1 },
+        { "CY", TARGET_CARRY, 1 },   { "AC", TARGET_AUX_CARRY, 1 }
+    };
+
+    bool StateField::parse(const std::string& name, StateField& field)
+    {
+        std::string upper = name;
+        std::transform(upper.begin(), upper.end(), upper.begin(), [](unsigned char c) { return (char)std::toupper(c); });
+
+        if(upper.size() > 2 && upper.front() == '[' && upper.back() == ']')
+        {
+            uint32_t address;
+            if(!AssemblerUtil::parse_number(upper.substr(1, upper.size() - 2), address) || address > 0xffff)
+            {
+                return false;
+            }
+
+            field.target = TARGET_MEMORY;
+            field.address = (uint16_t)address;
+            field.max_value = 0xff;
+            return true;
+        }
+
+        for(const TargetName& t : _target_names)
+        {
+            if(upper == t.name)
+            {
+                field.target = t.target;
+                field.address = 0;
+                field.max_value = t.max_value;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    uint16_t StateField::read(const Processor& cpu) const
+    {
+        switch(target)
+        {
+            case TARGET_A: return cpu.reg_a;
+            case TARGET_B: return cpu.reg_b;
+            case TARGET_C: return cpu.reg_c;
+            case TARGET_D: return cpu.reg_d;
+            case TARGET_E: return cpu.reg_e;
+            case TARGET_H: return cpu.reg_h;
+            case TARGET_L: return cpu.reg_l;
+            case TARGET_BC: return (uint16_t)((cpu.reg_b << 8) | cpu.reg_c);
+            case TARGET_DE: return (uint16_t)((cpu.reg_d << 8) | cpu.reg_e);
+            case TARGET_HL: return (uint16_t)((cpu.reg_h << 8) | cpu.reg_l);
+            case TARGET_SP: return cpu.stack_pointer;
+            case TARGET_PC: return cpu.program_counter;
+            case TARGET_SIGN: return cpu.sign;
+            case TARGET_ZERO: return cpu.zero;
+            case TARGET_PARITY: return cpu.parity;
+            case TARGET_CARRY: return cpu.carry;
+            case TARGET_AUX_CARRY: return cpu.auxiliary_carry;
+            case TARGET_MEMORY: return cpu.read_mem(address);
+        }
+
+        return 0;
+    }
+
+    void StateField::write(Processor& cpu, uint16_t value) const
+    {
+        switch(target)
+        {
+            case TARGET_A: cpu.reg_a = (uint8_t)value; break;
+            case TARGET_B: cpu.reg_b = (uint8_t)value; break;
+            case TARGET_C: cpu.reg_c = (uint8_t)value; break;
+            case TARGET_D: cpu.reg_d = (uint8_t)value; break;
+            case TARGET_E: cpu.reg_e = (uint8_t)value; break;
+            case TARGET_H: cpu.reg_h = (uint8_t)value; break;
+            case TARGET_L: cpu.reg_l = (uint8_t)value; break;
+            case TARGET_BC: cpu.reg_b = value >> 8; cpu.reg_c = value & 0xff; break;
+            case TARGET_DE: cpu.reg_d = value >> 8; cpu.reg_e = value & 0xff; break;
+            case TARGET_HL: cpu.reg_h = value >> 8; cpu.reg_l = value & 0xff; break;
+            case TARGET_SP: cpu.stack_pointer = value; break;
+            case TARGET_PC: cpu.program_counter = value; break;
+            case TARGET_SIGN: cpu.sign = value != 0; break;
+            case TARGET_ZERO: cpu.zero = value != 0; break;
+            case TARGET_PARITY: cpu.parity = value != 0; break;
+            case TARGET_CARRY: cpu.carry = value != 0; break;
+            case TARGET_AUX_CARRY: cpu.auxiliary_carry = value != 0; break;
+            case TARGET_MEMORY: cpu.write_mem(address, (uint8_t)value); break;
+        }
+    }
+
+    int StateField::width() const
+    {
+        return max_value > 0xff ? 4 : 2;
+    }
+}
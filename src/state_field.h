@@ -0,0 +1,38 @@
+#pragma once
+#include "lib8085.h"
+
+#include <cstdint>
+#include <string>
+
+namespace lib8085
+{
+    enum StateTarget
+    {
+        TARGET_A, TARGET_B, TARGET_C, TARGET_D, TARGET_E, TARGET_H, TARGET_L,
+        TARGET_BC, TARGET_DE, TARGET_HL, TARGET_SP, TARGET_PC,
+        TARGET_SIGN, TARGET_ZERO, TARGET_PARITY, TARGET_CARRY, TARGET_AUX_CARRY,
+        TARGET_MEMORY
+    };
+
+    /*
+     * One piece of processor state named the way users write it:
+     * A-L, BC, DE, HL, SP, PC, the flags S, Z, P, CY, AC or a memory byte [2000H].
+     * Shared by the parameter sweep and the test runner.
+     *
+     */
+    struct StateField
+    {
+        StateTarget target = TARGET_A;
+        uint16_t address = 0;
+        uint32_t max_value = 0xff;
+
+        // Case insensitive, returns false for unknown names
+        static bool parse(const std::string& name, StateField& field);
+
+        uint16_t read(const Processor& cpu) const;
+        void write(Processor& cpu, uint16_t value) const;
+
+        // Hex digits needed to print a value
+        int width() const;
+    };
+}
@@ -0,0 +1,461 @@
+#include "sweep.h"
+#include "assembler_util.h"
+#include "memory_pool.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <map>
+#include <random>
+#include <sstream>
+
+namespace lib8085
+{
+    static bool parse_range(const std::string& str, uint32_t max_value, uint32_t& lo, uint32_t& hi, uint32_t& step)
+    {
+        step = 1;
+
+        std::string range = str;
+        size_t colon = range.find(':');
+        if(colon != std::string::npos)
+        {
+            if(!AssemblerUtil::parse_number(range.substr(colon + 1), step) || step == 0)
+            {
+                return false;
+            }
+            range = range.substr(0, colon);
+        }
+
+        size_t dots = range.find("..");
+        if(dots == std::string::npos)
+        {
+            if(!AssemblerUtil::parse_number(range, lo))
+            {
+                return false;
+            }
+            hi = lo;
+        }
+        else if(!AssemblerUtil::parse_number(range.substr(0, dots), lo)
+                || !AssemblerUtil::parse_number(range.substr(dots + 2), hi))
+        {
+            return false;
+        }
+
+        return lo <= hi && hi <= max_value;
+    }
+
+    // 2^24, far more than the distinct values of any field
+    static const uint32_t MAX_RANDOM_VALUES = 1 << 24;
+
+    struct ReportField
+    {
+        const char* name;
+        int width;
+        uint16_t (*get)(const ParameterSweep::FinalState&);
+    };
+
+    static const ReportField _report_fields[] = {
+        { "A",     2, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.reg_a; } },
+        { "B",     2, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.reg_b; } },
+        { "C",     2, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.reg_c; } },
+        { "D",     2, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.reg_d; } },
+        { "E",     2, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.reg_e; } },
+        { "H",     2, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.reg_h; } },
+        { "L",     2, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.reg_l; } },
+        { "FLAGS", 2, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.flags; } },
+        { "PC",    4, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.program_counter; } },
+        { "SP",    4, [](const ParameterSweep::FinalState& fs) -> uint16_t { return fs.stack_pointer; } }
+    };
+
+    static bool by_index(const std::pair<uint64_t, ParameterSweep::FinalState>& a, const std::pair<uint64_t, ParameterSweep::FinalState>& b)
+    {
+        return a.first < b.first;
+    }
+
+    static bool by_fewest_instructions(const std::pair<uint64_t, ParameterSweep::FinalState>& a, const std::pair<uint64_t, ParameterSweep::FinalState>& b)
+    {
+        return a.second.instructions != b.second.instructions ? a.second.instructions < b.second.instructions : a.first < b.first;
+    }
+
+    static bool by_most_instructions(const std::pair<uint64_t, ParameterSweep::FinalState>& a, const std::pair<uint64_t, ParameterSweep::FinalState>& b)
+    {
+        return a.second.instructions != b.second.instructions ? a.second.instructions > b.second.instructions : a.first < b.first;
+    }
+
+    // Keeps the first count runs in order, trimming only once twice as many piled up
+    template <typename Less>
+    static void keep_first(std::vector<std::pair<uint64_t, ParameterSweep::FinalState>>& runs, size_t count, Less less, bool now)
+    {
+        if(runs.size() > count && (now || runs.size() > 2 * count))
+        {
+            std::sort(runs.begin(), runs.end(), less);
+            runs.resize(count);
+        }
+    }
+
+    ParameterSweep::ParameterSweep(uint32_t seed) : _seed(seed)
+    {
+    }
+
+    bool ParameterSweep::add_variable(const std::string& spec, std::string& error)
+    {
+        size_t eq = spec.find('=');
+        if(eq == std::string::npos || eq == 0)
+        {
+            error = "Expected NAME=VALUES in \'" + spec + "\'";
+            return false;
+        }
+
+        Variable var;
+        var.name = spec.substr(0, eq);
+        std::transform(var.name.begin(), var.name.end(), var.name.begin(), [](unsigned char c) { return (char)std::toupper(c); });
+
+        if(!StateField::parse(var.name, var.field))
+        {
+            error = "Unknown register, flag or memory address \'" + var.name + "\'";
+            return false;
+        }
+
+        uint32_t max_value = var.field.max_value;
+
+        std::string values = spec.substr(eq + 1);
+
+        if(values.compare(0, 5, "rand:") == 0)
+        {
+            std::string count_str = values.substr(5);
+            uint32_t lo = 0, hi = max_value, step, count;
+
+            size_t colon = count_str.find(':');
+            if(colon != std::string::npos)
+            {
+                if(!parse_range(count_str.substr(colon + 1), max_value, lo, hi, step))
+                {
+                    error = "Invalid random range in \'" + spec + "\'";
+                    return false;
+                }
+                count_str = count_str.substr(0, colon);
+            }
+
+            if(!AssemblerUtil::parse_number(count_str, count) || count == 0)
+            {
+                error = "Invalid random count in \'" + spec + "\'";
+                return false;
+            }
+
+            // Checked before the values are drawn, they are all kept
+            if(count > MAX_RANDOM_VALUES)
+            {
+                error = "At most " + std::to_string(MAX_RANDOM_VALUES) + " random values in \'" + spec + "\'";
+                return false;
+            }
+            if(count > MAX_COMBINATIONS / combination_count())
+            {
+                error = "Sweeping \'" + spec + "\' as well would exceed " + std::to_string(MAX_COMBINATIONS) + " combinations";
+                return false;
+            }
+
+            // Seeded per variable so adding a variable doesn't change the others
+            std::mt19937 rng(_seed + (uint32_t)_variables.size() * 7919);
+            std::uniform_int_distribution<uint32_t> dist(lo, hi);
+
+            for(uint32_t i = 0; i < count; i ++)
+            {
+                var.values.push_back((uint16_t)dist(rng));
+            }
+        }
+        else
+        {
+            size_t start = 0;
+            while(start <= values.size())
+            {
+                size_t comma = values.find(',', start);
+                if(comma == std::string::npos)
+                {
+                    comma = values.size();
+                }
+
+                uint32_t lo, hi, step;
+                if(!parse_range(values.substr(start, comma - start), max_value, lo, hi, step))
+                {
+                    error = "Invalid value \'" + values.substr(start, comma - start) + "\' for " + var.name;
+                    return false;
+                }
+
+                for(uint32_t v = lo; v <= hi; v += step)
+                {
+                    var.values.push_back((uint16_t)v);
+                }
+
+                start = comma + 1;
+            }
+        }
+
+        // combination_count() is at most MAX_COMBINATIONS, so this can't overflow
+        if(var.values.size() > MAX_COMBINATIONS / combination_count())
+        {
+            error = "Sweeping \'" + spec + "\' as well would exceed " + std::to_string(MAX_COMBINATIONS) + " combinations";
+            return false;
+        }
+
+        _variables.push_back(var);
+        return true;
+    }
+
+    uint64_t ParameterSweep::combination_count() const
+    {
+        uint64_t count = 1;
+        for(const Variable& var : _variables)
+        {
+            count *= var.values.size();
+        }
+        return count;
+    }
+
+    void ParameterSweep::apply(Processor& cpu, uint64_t index) const
+    {
+        // Mixed radix decode, the last variable changes fastest
+        for(size_t i = _variables.size(); i-- > 0;)
+        {
+            const Variable& var = _variables[i];
+            uint16_t value = var.values[index % var.values.size()];
+            index /= var.values.size();
+
+            var.field.write(cpu, value);
+        }
+    }
+
+    void ParameterSweep::describe(uint64_t index, std::ostream& out) const
+    {
+        std::vector<std::string> parts(_variables.size());
+
+        for(size_t i = _variables.size(); i-- > 0;)
+        {
+            const Variable& var = _variables[i];
+            uint16_t value = var.values[index % var.values.size()];
+            index /= var.values.size();
+
+            std::stringstream ss;
+            ss << var.name << "=" << std::hex << std::uppercase << std::setfill('0')
+                << std::setw(var.field.width()) << value << "H";
+            parts[i] = ss.str();
+        }
+
+        for(size_t i = 0; i < parts.size(); i ++)
+        {
+            out << (i ? " " : "") << parts[i];
+        }
+    }
+
+    void ParameterSweep::add_run(Summary& summary, uint64_t index, const FinalState& fs) const
+    {
+        for(size_t i = 0; i < summary.values.size(); i ++)
+        {
+            summary.values[i][_report_fields[i].get(fs)]++;
+        }
+
+        if(!fs.halted)
+        {
+            summary.other_instructions[fs.instructions]++;
+            summary.not_halted.push_back({ index, fs });
+            keep_first(summary.not_halted, _options.max_outliers, by_index, false);
+            return;
+        }
+
+        summary.halted++;
+        summary.halted_instructions[fs.instructions]++;
+
+        summary.shortest.push_back({ index, fs });
+        keep_first(summary.shortest, _options.max_outliers, by_fewest_instructions, false);
+        summary.longest.push_back({ index, fs });
+        keep_first(summary.longest, _options.max_outliers, by_most_instructions, false);
+    }
+
+    void ParameterSweep::merge(Summary& summary, Summary& other) const
+    {
+        summary.halted += other.halted;
+
+        for(const auto& it : other.halted_instructions)
+        {
+            summary.halted_instructions[it.first] += it.second;
+        }
+        for(const auto& it : other.other_instructions)
+        {
+            summary.other_instructions[it.first] += it.second;
+        }
+
+        for(size_t i = 0; i < summary.values.size(); i ++)
+        {
+            for(size_t v = 0; v < summary.values[i].size(); v ++)
+            {
+                summary.values[i][v] += other.values[i][v];
+            }
+        }
+
+        summary.not_halted.insert(summary.not_halted.end(), other.not_halted.begin(), other.not_halted.end());
+        summary.shortest.insert(summary.shortest.end(), other.shortest.begin(), other.shortest.end());
+        summary.longest.insert(summary.longest.end(), other.longest.begin(), other.longest.end());
+
+        keep_first(summary.not_halted, _options.max_outliers, by_index, true);
+        keep_first(summary.shortest, _options.max_outliers, by_fewest_instructions, true);
+        keep_first(summary.longest, _options.max_outliers, by_most_instructions, true);
+    }
+
+    void ParameterSweep::run(const std::vector<uint8_t>& program, const Options& options)
+    {
+        _options = options;
+
+        const uint64_t count = combination_count();
+        unsigned threads = options.threads ? options.threads : default_thread_count();
+        threads = (unsigned)std::max<uint64_t>(1, std::min<uint64_t>(threads, count));
+
+        // One summary per worker, merged once every run is done
+        std::vector<Summary> summaries(threads);
+        for(Summary& summary : summaries)
+        {
+            for(const ReportField& field : _report_fields)
+            {
+                summary.values.push_back(std::vector<uint64_t>((size_t)1 << (field.width * 4), 0));
+            }
+        }
+
+        ProcessorPool pool;
+
+        parallel_for((size_t)count, [&](size_t index, unsigned worker)
+        {
+            ProcessorPool::Handle cpu = pool.acquire();
+            cpu->load_memory(0, program.data(), program.size());
+            apply(*cpu, index);
+
+            FinalState fs;
+            fs.instructions    = cpu->run(options.max_instructions);
+            fs.halted          = cpu->halted;
+            fs.reg_a           = cpu->reg_a;
+            fs.reg_b           = cpu->reg_b;
+            fs.reg_c           = cpu->reg_c;
+            fs.reg_d           = cpu->reg_d;
+            fs.reg_e           = cpu->reg_e;
+            fs.reg_h           = cpu->reg_h;
+            fs.reg_l           = cpu->reg_l;
+            fs.flags           = cpu->get_flags();
+            fs.program_counter = cpu->program_counter;
+            fs.stack_pointer   = cpu->stack_pointer;
+
+            add_run(summaries[worker], index, fs);
+        }, threads);
+
+        _summary = std::move(summaries[0]);
+        for(size_t i = 1; i < summaries.size(); i ++)
+        {
+            merge(_summary, summaries[i]);
+        }
+        keep_first(_summary.not_halted, _options.max_outliers, by_index, true);
+        keep_first(_summary.shortest, _options.max_outliers, by_fewest_instructions, true);
+        keep_first(_summary.longest, _options.max_outliers, by_most_instructions, true);
+    }
+
+    void ParameterSweep::print_report(std::ostream& out) const
+    {
+        const Summary& summary = _summary;
+        uint64_t runs = 0;
+        uint64_t min_ins = UINT64_MAX, max_ins = 0;
+        double sum = 0, sum_sq = 0;
+
+        for(const std::map<uint64_t, uint64_t>* instructions : { &summary.halted_instructions, &summary.other_instructions })
+        {
+            for(const auto& it : *instructions)
+            {
+                runs += it.second;
+                min_ins = std::min(min_ins, it.first);
+                max_ins = std::max(max_ins, it.first);
+                sum += (double)it.first * it.second;
+                sum_sq += (double)it.first * it.first * it.second;
+            }
+        }
+
+        if(runs == 0)
+        {
+            out << "No runs\n";
+            return;
+        }
+
+        double n = (double)runs;
+        double mean = sum / n;
+        double stddev = std::sqrt(std::max(0.0, sum_sq / n - mean * mean));
+
+        out << "Runs: " << runs << ", halted: " << summary.halted
+            << ", instruction budget exceeded: " << (runs - summary.halted) << "\n";
+        out << "Instructions: min " << min_ins << ", mean " << std::fixed << std::setprecision(1) << mean
+            << ", max " << max_ins << ", stddev " << stddev << "\n";
+        out << "Final state distribution:\n";
+
+        for(size_t f = 0; f < summary.values.size(); f ++)
+        {
+            const ReportField& field = _report_fields[f];
+            std::vector<std::pair<uint64_t, uint16_t>> top;
+            for(size_t v = 0; v < summary.values[f].size(); v ++)
+            {
+                if(summary.values[f][v])
+                {
+                    top.push_back({ summary.values[f][v], (uint16_t)v });
+                }
+            }
+            const size_t distinct = top.size();
+
+            std::sort(top.begin(), top.end(), [](const std::pair<uint64_t, uint16_t>& a, const std::pair<uint64_t, uint16_t>& b)
+            {
+                return a.first != b.first ? a.first > b.first : a.second < b.second;
+            });
+
+            out << "  " << std::left << std::setw(6) << std::setfill(' ') << field.name << std::right
+                << "distinct " << std::setw(5) << distinct << "  top:";
+
+            for(size_t i = 0; i < top.size() && i < 5; i ++)
+            {
+                out << " " << std::hex << std::uppercase << std::setfill('0') << std::setw(field.width) << top[i].second
+                    << "H x" << std::dec << top[i].first;
+            }
+            out << std::setfill(' ') << "\n";
+        }
+
+        // Runs that didn't halt or took unusually long or short
+        auto unusual = [&](uint64_t instructions)
+        {
+            return stddev > 0 && std::fabs((double)instructions - mean) > 3 * stddev;
+        };
+
+        uint64_t outlier_count = runs - summary.halted;
+        for(const auto& it : summary.halted_instructions)
+        {
+            outlier_count += unusual(it.first) ? it.second : 0;
+        }
+
+        // Only the most extreme halted runs were kept, listed with the first that didn't halt
+        std::vector<Run> outliers = summary.not_halted;
+        for(const std::vector<Run>* extremes : { &summary.shortest, &summary.longest })
+        {
+            for(const Run& run : *extremes)
+            {
+                if(unusual(run.second.instructions) && std::none_of(outliers.begin(), outliers.end(),
+                        [&](const Run& o) { return o.first == run.first; }))
+                {
+                    outliers.push_back(run);
+                }
+            }
+        }
+        std::sort(outliers.begin(), outliers.end(), by_index);
+
+        out << "Outliers: " << outlier_count << "\n";
+        for(size_t i = 0; i < outliers.size() && i < _options.max_outliers; i ++)
+        {
+            const FinalState& fs = outliers[i].second;
+
+            out << "  #" << outliers[i].first << " ";
+            describe(outliers[i].first, out);
+            out << " -> " << (fs.halted ? "halted" : "not halted") << " after " << fs.instructions
+                << " instructions, A=" << std::hex << std::uppercase << std::setfill('0') << std::setw(2) << (int)fs.reg_a
+                << "H PC=" << std::setw(4) << fs.program_counter << "H" << std::dec << std::setfill(' ') << "\n";
+        }
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include "lib8085.h"
+#include "state_field.h"
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Runs one program from many initial states.
+     *
+     * Each variable assigns a set of values to a register, register pair, flag
+     * or memory byte; the sweep runs every combination (cartesian product) in
+     * parallel. Final states are folded into per worker histograms as runs
+     * finish, only the runs reported as outliers are kept whole. Sweeps are
+     * limited to MAX_COMBINATIONS runs.
+     *
+     * Variable specs:
+     *   B=0..255          range
+     *   HL=2000H..2FFFH:10H range with step
+     *   C=1,2,4,10H..1FH  list of values and ranges
+     *   A=rand:100        100 random values (rand:N:lo..hi to limit the range)
+     *   [2050H]=0..9      memory byte
+     *
+     */
+    class ParameterSweep
+    {
+        public:
+            // 2^32, days of runs for any program worth sweeping
+            static const uint64_t MAX_COMBINATIONS = 1ull << 32;
+
+            struct Options
+            {
+                uint64_t max_instructions = 1000000;
+                unsigned threads = 0;
+                size_t max_outliers = 20;
+            };
+
+            struct FinalState
+            {
+                uint8_t reg_a, reg_b, reg_c, reg_d, reg_e, reg_h, reg_l;
+                uint8_t flags; // PSW layout
+                uint16_t program_counter, stack_pointer;
+                uint64_t instructions;
+                bool halted;
+            };
+
+            explicit ParameterSweep(uint32_t seed = 1);
+
+            // False when the spec is invalid or the sweep would exceed MAX_COMBINATIONS
+            bool add_variable(const std::string& spec, std::string& error);
+            uint64_t combination_count() const;
+
+            void run(const std::vector<uint8_t>& program, const Options& options);
+            void print_report(std::ostream& out) const;
+
+            // Prints the variable assignment of one combination, e.g. "B=05H C=10H"
+            void describe(uint64_t index, std::ostream& out) const;
+
+        private:
+            struct Variable
+            {
+                std::string name;
+                StateField field;
+                std::vector<uint16_t> values;
+            };
+
+            typedef std::pair<uint64_t, FinalState> Run;
+
+            // What the report needs of the runs one worker did
+            struct Summary
+            {
+                uint64_t halted = 0;
+                // Runs by instruction count, outliers can only be counted once the mean is known
+                std::map<uint64_t, uint64_t> halted_instructions;
+                std::map<uint64_t, uint64_t> other_instructions;
+                // Runs by final value, one table per reported field
+                std::vector<std::vector<uint64_t>> values;
+                // Lowest indices of the runs that didn't halt, the shortest and the longest halted runs
+                std::vector<Run> not_halted;
+                std::vector<Run> shortest;
+                std::vector<Run> longest;
+            };
+
+            uint32_t _seed;
+            Options _options;
+            std::vector<Variable> _variables;
+            Summary _summary;
+
+            void apply(Processor& cpu, uint64_t index) const;
+            void add_run(Summary& summary, uint64_t index, const FinalState& fs) const;
+            void merge(Summary& summary, Summary& other) const;
+    };
+}
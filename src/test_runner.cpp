@@ -0,0 +1,278 @@
+#include "test_runner.h"
+#include "assembler.h"
+#include "assembler_util.h"
+#include "memory_pool.h"
+#include "parallel.h"
+
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace lib8085
+{
+    static bool read_text(const std::string& path, std::string& text)
+    {
+        std::ifstream file(path, std::ios::in | std::ios::binary);
+
+        if(!file.is_open())
+        {
+            return false;
+        }
+
+        std::stringstream ss;
+        ss << file.rdbuf();
+        text = ss.str();
+
+        return true;
+    }
+
+    static bool parse_checks(const std::string& text, int line, std::vector<TestRunner::Check>& checks, std::string& error)
+    {
+        std::stringstream ss(text);
+        std::string pair;
+
+        while(ss >> pair)
+        {
+            if(pair.back() == ',')
+            {
+                pair.pop_back();
+            }
+
+            size_t eq = pair.find('=');
+            uint32_t value;
+            TestRunner::Check check;
+
+            if(eq == std::string::npos || eq == 0 || !StateField::parse(pair.substr(0, eq), check.field))
+            {
+                error = "Invalid annotation \'" + pair + "\' at line " + std::to_string(line);
+                return false;
+            }
+
+            if(!AssemblerUtil::parse_number(pair.substr(eq + 1), value) || value > check.field.max_value)
+            {
+                error = "Invalid value \'" + pair + "\' at line " + std::to_string(line);
+                return false;
+            }
+
+            check.name = pair.substr(0, eq);
+            check.value = (uint16_t)value;
+            check.line = line;
+            checks.push_back(check);
+        }
+
+        return true;
+    }
+
+    bool TestRunner::parse(const std::string& source, TestCase& test, std::string& error)
+    {
+        std::stringstream ss(source);
+        std::string line;
+        int line_number = 0;
+
+        while(std::getline(ss, line))
+        {
+            line_number++;
+
+            size_t comment = line.find(';');
+            if(comment == std::string::npos)
+            {
+                continue;
+            }
+
+            size_t start = line.find_first_not_of(" \t", comment + 1);
+            if(start == std::string::npos)
+            {
+                continue;
+            }
+
+            std::string text = line.substr(start);
+
+            if(text.compare(0, 7, "EXPECT:") == 0)
+            {
+                if(!parse_checks(text.substr(7), line_number, test.expect, error))
+                {
+                    return false;
+                }
+            }
+            else if(text.compare(0, 6, "SETUP:") == 0)
+            {
+                if(!parse_checks(text.substr(6), line_number, test.setup, error))
+                {
+                    return false;
+                }
+            }
+            else if(text.compare(0, 4, "MAX:") == 0)
+            {
+                uint32_t max;
+                std::stringstream max_ss(text.substr(4));
+                std::string max_str;
+
+                if(!(max_ss >> max_str) || !AssemblerUtil::parse_number(max_str, max) || max == 0)
+                {
+                    error = "Invalid instruction budget at line " + std::to_string(line_number);
+                    return false;
+                }
+
+                test.max_instructions = max;
+            }
+        }
+
+        return true;
+    }
+
+    void TestRunner::run_one(Processor& cpu, Result& result) const
+    {
+        std::string source;
+        TestCase test;
+
+        if(!read_text(result.path, source))
+        {
+            result.message = "Error reading file";
+            return;
+        }
+
+        if(!parse(source, test, result.message))
+        {
+            return;
+        }
+
+        if(test.expect.empty())
+        {
+            result.message = "No EXPECT annotations";
+            return;
+        }
+
+        Assembler assembler(source);
+        assembler.tokenize();
+
+        if(!assembler.parse() || assembler._program_instructions.empty())
+        {
+            result.message = "Assembling failed";
+
+            // The first error is the one worth fixing first
+            for(const Diagnostic& d : assembler.diagnostics().entries())
+            {
+                if(d.severity == SEVERITY_ERROR)
+                {
+                    result.message += ": line " + std::to_string(d.line) + ": " + d.message;
+                    break;
+                }
+            }
+            return;
+        }
+
+        const std::vector<uint8_t>& program = assembler._program_instructions;
+        cpu.load_memory(0, program.data(), program.size());
+
+        for(const Check& c : test.setup)
+        {
+            c.field.write(cpu, c.value);
+        }
+
+        uint64_t max_instructions = test.max_instructions ? test.max_instructions : _options.max_instructions;
+
+        while(!cpu.halted && cpu.program_counter < program.size() && result.instructions < max_instructions)
+        {
+            cpu.step();
+            result.instructions++;
+        }
+
+        if(!cpu.halted && cpu.program_counter < program.size())
+        {
+            result.message = "Did not finish within " + std::to_string(max_instructions) + " instructions";
+            return;
+        }
+
+        std::stringstream failures;
+
+        for(const Check& c : test.expect)
+        {
+            uint16_t actual = c.field.read(cpu);
+
+            if(actual != c.value)
+            {
+                failures << (failures.tellp() > 0 ? ", " : "") << c.name << " expected "
+                    << std::hex << std::uppercase << std::setfill('0')
+                    << std::setw(c.field.width()) << c.value << "H got "
+                    << std::setw(c.field.width()) << actual << "H (line " << std::dec << c.line << ")";
+            }
+        }
+
+        result.message = failures.str();
+        result.passed = result.message.empty();
+    }
+
+    void TestRunner::run(const std::vector<std::string>& paths, const Options& options)
+    {
+        _options = options;
+        _results.assign(paths.size(), Result());
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+        ProcessorPool pool;
+
+        parallel_for(paths.size(), [&](size_t index, unsigned worker)
+        {
+            Result& result = _results[index];
+            result.path = paths[index];
+
+            std::chrono::steady_clock::time_point test_start = std::chrono::steady_clock::now();
+
+            ProcessorPool::Handle cpu = pool.acquire();
+            run_one(*cpu, result);
+
+            result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - test_start).count();
+        }, options.threads);
+
+        _elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    void TestRunner::print_report(std::ostream& out) const
+    {
+        double total_ms = 0;
+
+        for(const Result& r : _results)
+        {
+            total_ms += r.milliseconds;
+
+            if(!r.passed || _options.verbose)
+            {
+                out << (r.passed ? "PASS " : "FAIL ") << r.path
+                    << " (" << r.instructions << " instructions, "
+                    << std::fixed << std::setprecision(3) << r.milliseconds << " ms)";
+                out.unsetf(std::ios_base::fixed);
+
+                if(!r.message.empty())
+                {
+                    out << ": " << r.message;
+                }
+                out << "\n";
+            }
+        }
+
+        size_t failed = failure_count();
+
+        out << (_results.size() - failed) << " passed, " << failed << " failed, "
+            << std::fixed << std::setprecision(1) << "test time " << total_ms << " ms, "
+            << "wall time " << _elapsed_ms << " ms\n";
+        out.unsetf(std::ios_base::fixed);
+    }
+
+    size_t TestRunner::failure_count() const
+    {
+        size_t failed = 0;
+
+        for(const Result& r : _results)
+        {
+            failed += r.passed ? 0 : 1;
+        }
+
+        return failed;
+    }
+
+    const std::vector<TestRunner::Result>& TestRunner::results() const
+    {
+        return _results;
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include "lib8085.h"
+#include "state_field.h"
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Assembles and runs annotated test programs in parallel.
+     *
+     * Annotations are comments holding NAME=VALUE pairs, NAME being a register,
+     * register pair, flag or memory byte (see StateField) and VALUE any number
+     * the assembler accepts:
+     *   ; EXPECT: A=57H CY=0       checked once the program stops
+     *   ; EXPECT: [2000H]=12H
+     *   ; SETUP: CY=1 HL=2000H     applied before the program starts
+     *   ; MAX: 5000                instruction budget for this file
+     *
+     * A program stops on HLT or when execution leaves the assembled code.
+     *
+     */
+    class TestRunner
+    {
+        public:
+            struct Options
+            {
+                uint64_t max_instructions = 100000;
+                unsigned threads = 0;
+                bool verbose = false;
+            };
+
+            struct Check
+            {
+                std::string name;
+                StateField field;
+                uint16_t value;
+                int line;
+            };
+
+            struct TestCase
+            {
+                std::vector<Check> setup;
+                std::vector<Check> expect;
+                uint64_t max_instructions = 0;
+            };
+
+            struct Result
+            {
+                std::string path;
+                bool passed = false;
+                std::string message;
+                uint64_t instructions = 0;
+                double milliseconds = 0;
+            };
+
+            // Reads the annotations of one source file, errors name the offending line
+            static bool parse(const std::string& source, TestCase& test, std::string& error);
+
+            void run(const std::vector<std::string>& paths, const Options& options);
+            void print_report(std::ostream& out) const;
+
+            size_t failure_count() const;
+            const std::vector<Result>& results() const;
+
+        private:
+            Options _options;
+            std::vector<Result> _results;
+            double _elapsed_ms = 0;
+
+            void run_one(Processor& cpu, Result& result) const;
+    };
+}
@@ -0,0 +1,88 @@
+#include "../memory_pool.h"
+#include "../lib8085.h"
+#include "../profiler.h"
+#include "../call_graph.h"
+#include "../coverage.h"
+#include "../trace.h"
+
+#include <iostream>
+#include <memory>
+#include <cstdio>
+
+using namespace lib8085;
+
+static const char* TRACE_PATH = "memory_pool_test.trace";
+
+static int failures = 0;
+
+static void check(bool condition, const char* what)
+{
+    if(!condition)
+    {
+        std::cerr << "FAIL " << what << "\n";
+        failures++;
+    }
+}
+
+// Counts A down from 5 and halts
+static const uint8_t PROGRAM[] = { MVI_A, 0x05, DCR_A, JNZ, 0x02, 0x00, HLT };
+
+// A processor released with instrumentation attached must not run into it once acquired again
+static void released_instrumentation()
+{
+    ProcessorPool pool;
+    Processor* first;
+
+    {
+        std::unique_ptr<Profiler> profiler(new Profiler());
+        std::unique_ptr<CallGraph> call_graph(new CallGraph());
+        std::unique_ptr<Coverage> coverage(new Coverage());
+        std::unique_ptr<TraceWriter> trace(new TraceWriter());
+
+        check(trace->open(TRACE_PATH), "trace opens");
+
+        ProcessorPool::Handle cpu = pool.acquire();
+        first = cpu.get();
+
+        cpu->attach_profiler(profiler.get());
+        cpu->attach_call_graph(call_graph.get());
+        cpu->attach_coverage(coverage.get());
+        cpu->attach_trace(trace.get());
+
+        cpu->load_memory(0, PROGRAM, sizeof(PROGRAM));
+        cpu->run(UINT64_MAX, UINT64_MAX);
+
+        check(cpu->halted, "instrumented run halts");
+        check(profiler->total_executions() > 0, "profiler records the run");
+
+        trace->close();
+        // The handle goes back to the pool after the instrumentation is destroyed
+        profiler.reset();
+        call_graph.reset();
+        coverage.reset();
+        trace.reset();
+    }
+
+    std::remove(TRACE_PATH);
+
+    ProcessorPool::Handle cpu = pool.acquire();
+
+    check(cpu.get() == first, "released processor is handed out again");
+    check(cpu->get_profiler() == nullptr, "profiler detached");
+    check(cpu->get_call_graph() == nullptr, "call graph detached");
+    check(cpu->get_coverage() == nullptr, "coverage detached");
+    check(cpu->get_trace() == nullptr, "trace detached");
+
+    cpu->load_memory(0, PROGRAM, sizeof(PROGRAM));
+    uint64_t instructions = cpu->run(UINT64_MAX, UINT64_MAX);
+
+    check(cpu->halted && instructions == 12, "reacquired processor runs the program");
+}
+
+int main()
+{
+    released_instrumentation();
+
+    std::cout << failures << " failed\n";
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,706 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace lib8085
+{
+    static const char _trace_magic[4] = { 'R', '8', '5', 'T' };
+    static const uint8_t _trace_version = 2;
+    static const char _trace_index_magic[4] = { 'R', '8', '5', 'X' };
+    static const uint8_t _trace_index_version = 1;
+
+    // type, raw size, packed size, record count, then the keyframe
+    static const size_t BLOCK_HEADER_SIZE = 1 + 4 + 4 + 4 + 8 + 8 + 8 + 2 + 2;
+    // instruction, cycles, block offset, checkpoint offset
+    static const size_t INDEX_ENTRY_SIZE = 8 * 4;
+
+    static const int HASH_BITS = 14;
+    static const size_t MIN_MATCH = 4;
+
+    static void put_le(std::vector<uint8_t>& out, uint64_t value, int bytes)
+    {
+        for(int i = 0; i < bytes; i ++)
+        {
+            out.push_back((uint8_t)(value >> (i * 8)));
+        }
+    }
+
+    static uint64_t get_le(const uint8_t* data, int bytes)
+    {
+        uint64_t value = 0;
+        for(int i = 0; i < bytes; i ++)
+        {
+            value |= (uint64_t)data[i] << (i * 8);
+        }
+        return value;
+    }
+
+    static void push_varint(std::vector<uint8_t>& out, uint64_t value)
+    {
+        while(value >= 0x80)
+        {
+            out.push_back((uint8_t)(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back((uint8_t)value);
+    }
+
+    static bool read_varint(const uint8_t* data, size_t size, size_t& offset, uint64_t& value)
+    {
+        value = 0;
+        for(int shift = 0; shift < 64; shift += 7)
+        {
+            if(offset >= size)
+            {
+                return false;
+            }
+
+            uint8_t byte = data[offset++];
+            value |= (uint64_t)(byte & 0x7f) << shift;
+
+            if(!(byte & 0x80))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static uint32_t hash4(const uint8_t* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, 4);
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // Byte oriented LZ77: (literal count, literals, match length - MIN_MATCH, offset) varint
+    // sequences, the last sequence has literals only
+    static void compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+    {
+        std::vector<int32_t> table((size_t)1 << HASH_BITS, -1);
+        size_t anchor = 0;
+        size_t i = 0;
+
+        while(i + MIN_MATCH <= size)
+        {
+            uint32_t hash = hash4(data + i);
+            int32_t candidate = table[hash];
+            table[hash] = (int32_t)i;
+
+            if(candidate < 0 || std::memcmp(data + candidate, data + i, MIN_MATCH) != 0)
+            {
+                i++;
+                continue;
+            }
+
+            size_t length = MIN_MATCH;
+            while(i + length < size && data[candidate + length] == data[i + length])
+            {
+                length++;
+            }
+
+            push_varint(out, i - anchor);
+            out.insert(out.end(), data + anchor, data + i);
+            push_varint(out, length - MIN_MATCH);
+            push_varint(out, i - candidate);
+
+            i += length;
+            anchor = i;
+
+            // Keeps matches chaining through repeated loop iterations
+            if(i + MIN_MATCH <= size && i >= 2)
+            {
+                table[hash4(data + i - 2)] = (int32_t)(i - 2);
+            }
+        }
+
+        if(anchor < size)
+        {
+            push_varint(out, size - anchor);
+            out.insert(out.end(), data + anchor, data + size);
+        }
+    }
+
+    static bool decompress(const uint8_t* data, size_t size, uint8_t* out, size_t out_size)
+    {
+        size_t in = 0;
+        size_t pos = 0;
+
+        while(pos < out_size)
+        {
+            uint64_t literals;
+            if(!read_varint(data, size, in, literals) || literals > out_size - pos || literals > size - in)
+            {
+                return false;
+            }
+
+            std::memcpy(out + pos, data + in, (size_t)literals);
+            in += (size_t)literals;
+            pos += (size_t)literals;
+
+            if(pos == out_size)
+            {
+                break;
+            }
+
+            uint64_t length, offset;
+            if(!read_varint(data, size, in, length) || !read_varint(data, size, in, offset))
+            {
+                return false;
+            }
+
+            length += MIN_MATCH;
+            if(offset == 0 || offset > pos || length > out_size - pos)
+            {
+                return false;
+            }
+
+            // Byte by byte, matches may overlap what they produce
+            for(size_t i = 0; i < length; i ++, pos ++)
+            {
+                out[pos] = out[pos - offset];
+            }
+        }
+
+        return in == size;
+    }
+
+    TraceWriter::TraceWriter()
+        : _closing(false), _failed(false), _file_bytes(0), _checkpoint_offset(UINT64_MAX), _state(), _instructions(0),
+          _raw_bytes(0), _blocks(0), _need_checkpoint(true)
+    {
+        new_block();
+    }
+
+    TraceWriter::~TraceWriter()
+    {
+        close();
+    }
+
+    bool TraceWriter::open(const char* path)
+    {
+        close();
+
+        _path = path;
+        _file.open(path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if(!_file.good() || !_file.is_open())
+        {
+            std::cerr << "Error writing trace \'" << path << "\'\n";
+            return false;
+        }
+
+        std::string index_path = _path + ".idx";
+        _index.open(index_path, std::ios::out | std::ios::binary | std::ios::trunc);
+
+        if(!_index.good() || !_index.is_open())
+        {
+            std::cerr << "Error writing trace index \'" << index_path << "\'\n";
+            _file.close();
+            return false;
+        }
+
+        _file.write(_trace_magic, sizeof(_trace_magic));
+        _file.write(reinterpret_cast<const char*>(&_trace_version), 1);
+        _index.write(_trace_index_magic, sizeof(_trace_index_magic));
+        _index.write(reinterpret_cast<const char*>(&_trace_index_version), 1);
+
+        _closing = false;
+        _failed = false;
+        _file_bytes = sizeof(_trace_magic) + 1;
+        _checkpoint_offset = UINT64_MAX;
+        _instructions = 0;
+        _raw_bytes = 0;
+        _blocks = 0;
+        _need_checkpoint = true;
+        new_block();
+
+        _thread = std::thread(&TraceWriter::write_blocks, this);
+
+        return true;
+    }
+
+    bool TraceWriter::close()
+    {
+        if(!_thread.joinable())
+        {
+            return !_failed;
+        }
+
+        if(_block.records)
+        {
+            submit();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _closing = true;
+        }
+        _ready.notify_one();
+        _thread.join();
+
+        _file.close();
+        _index.close();
+
+        if(_failed)
+        {
+            std::cerr << "Error writing trace \'" << _path << "\'\n";
+        }
+
+        return !_failed;
+    }
+
+    uint64_t TraceWriter::instruction_count() const
+    {
+        return _instructions;
+    }
+
+    uint64_t TraceWriter::raw_bytes() const
+    {
+        return _raw_bytes;
+    }
+
+    uint64_t TraceWriter::file_bytes() const
+    {
+        return _file_bytes;
+    }
+
+    void TraceWriter::write_blocks()
+    {
+        for(;;)
+        {
+            Block block;
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                _ready.wait(lock, [this] { return !_queue.empty() || _closing; });
+
+                if(_queue.empty())
+                {
+                    return;
+                }
+
+                block = std::move(_queue.front());
+                _queue.pop_front();
+            }
+            _space.notify_one();
+
+            if(!_failed)
+            {
+                write_block(block);
+            }
+        }
+    }
+
+    void TraceWriter::write_block(const Block& block)
+    {
+        std::vector<uint8_t> packed;
+        packed.reserve(block.size / 2);
+        compress(block.data.data(), block.size, packed);
+
+        // Stored as is when compression doesn't help, packed size equals raw size
+        const uint8_t* payload = packed.data();
+        if(packed.size() >= block.size)
+        {
+            packed.resize(block.size);
+            payload = block.data.data();
+        }
+
+        std::vector<uint8_t> header;
+        header.reserve(BLOCK_HEADER_SIZE);
+        header.push_back(block.type);
+        put_le(header, block.size, 4);
+        put_le(header, packed.size(), 4);
+        put_le(header, block.records, 4);
+        put_le(header, block.start.instruction, 8);
+        put_le(header, block.start.cycles, 8);
+        header.insert(header.end(), block.start.registers, block.start.registers + 8);
+        put_le(header, block.start.stack_pointer, 2);
+        put_le(header, block.start.program_counter, 2);
+
+        uint64_t offset = _file_bytes;
+
+        _file.write(reinterpret_cast<const char*>(header.data()), header.size());
+        _file.write(reinterpret_cast<const char*>(payload), packed.size());
+        _file_bytes += header.size() + packed.size();
+
+        if(block.type == BLOCK_MEMORY)
+        {
+            _checkpoint_offset = offset;
+        }
+        else
+        {
+            std::vector<uint8_t> entry;
+            entry.reserve(INDEX_ENTRY_SIZE);
+            put_le(entry, block.start.instruction, 8);
+            put_le(entry, block.start.cycles, 8);
+            put_le(entry, offset, 8);
+            put_le(entry, _checkpoint_offset, 8);
+
+            _index.write(reinterpret_cast<const char*>(entry.data()), entry.size());
+        }
+
+        if(!_file.good() || !_index.good())
+        {
+            _failed = true;
+        }
+    }
+
+    TraceReader::TraceReader()
+        : _offset(0), _records(0), _state(), _memory(MEM_PAGE_COUNT * MEM_PAGE_SIZE), _has_pending(false), _indexed(false),
+          _failed(false)
+    {
+    }
+
+    bool TraceReader::open(const char* path)
+    {
+        _path = path;
+        _file.open(path, std::ios::in | std::ios::binary);
+
+        if(!_file.good() || !_file.is_open())
+        {
+            std::cerr << "Error reading trace \'" << path << "\'\n";
+            return false;
+        }
+
+        char header[5];
+        _file.read(header, sizeof(header));
+
+        if(!_file.good()
+                || !std::equal(_trace_magic, _trace_magic + 4, header)
+                || (uint8_t)header[4] != _trace_version)
+        {
+            std::cerr << "\'" << path << "\' is not a supported trace file\n";
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TraceReader::failed() const
+    {
+        return _failed;
+    }
+
+    const std::vector<uint8_t>& TraceReader::memory() const
+    {
+        return _memory;
+    }
+
+    bool TraceReader::read_block()
+    {
+        uint8_t header[BLOCK_HEADER_SIZE];
+        _file.read(reinterpret_cast<char*>(header), sizeof(header));
+
+        if(_file.gcount() == 0)
+        {
+            return false;
+        }
+
+        if((size_t)_file.gcount() != sizeof(header))
+        {
+            _failed = true;
+            return false;
+        }
+
+        uint8_t type = header[0];
+        size_t raw_size = (size_t)get_le(header + 1, 4);
+        size_t packed_size = (size_t)get_le(header + 5, 4);
+        _records = (uint32_t)get_le(header + 9, 4);
+        _state.instruction = get_le(header + 13, 8);
+        _state.cycles = get_le(header + 21, 8);
+        std::copy(header + 29, header + 37, _state.registers);
+        _state.stack_pointer = (uint16_t)get_le(header + 37, 2);
+        _state.program_counter = (uint16_t)get_le(header + 39, 2);
+
+        bool valid = type == TraceWriter::BLOCK_RECORDS
+            ? raw_size <= TraceWriter::BLOCK_SIZE + TraceWriter::MAX_RECORD_SIZE
+            : type == TraceWriter::BLOCK_MEMORY && raw_size == _memory.size() && _records == 0;
+
+        if(!valid || packed_size > raw_size)
+        {
+            _failed = true;
+            return false;
+        }
+
+        std::vector<uint8_t> packed(packed_size);
+        _file.read(reinterpret_cast<char*>(packed.data()), packed_size);
+
+        if((size_t)_file.gcount() != packed_size)
+        {
+            _failed = true;
+            return false;
+        }
+
+        std::vector<uint8_t>& out = type == TraceWriter::BLOCK_MEMORY ? _memory : _data;
+        out.resize(raw_size);
+        _offset = 0;
+
+        if(packed_size == raw_size)
+        {
+            out = std::move(packed);
+        }
+        else if(!decompress(packed.data(), packed_size, out.data(), raw_size))
+        {
+            _failed = true;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool TraceReader::read_record(TraceRecord& record)
+    {
+        while(!_records)
+        {
+            if(_failed || !read_block())
+            {
+                return false;
+            }
+        }
+
+        if(!decode(record))
+        {
+            _failed = true;
+            return false;
+        }
+
+        _records--;
+        return true;
+    }
+
+    bool TraceReader::next(TraceRecord& record)
+    {
+        if(_has_pending)
+        {
+            record = _pending;
+            _has_pending = false;
+        }
+        else if(!read_record(record))
+        {
+            return false;
+        }
+
+        for(int i = 0; i < record.write_count; i ++)
+        {
+            _memory[(uint16_t)(record.write_address + i)] = record.write_values[i];
+        }
+
+        return true;
+    }
+
+    bool TraceReader::load_index()
+    {
+        std::ifstream file(_path + ".idx", std::ios::in | std::ios::binary);
+        char header[5];
+
+        if(!file.is_open() || !file.read(header, sizeof(header))
+                || !std::equal(_trace_index_magic, _trace_index_magic + 4, header)
+                || (uint8_t)header[4] != _trace_index_version)
+        {
+            return false;
+        }
+
+        uint8_t entry[INDEX_ENTRY_SIZE];
+
+        // A trailing partial entry is left over from a writer that didn't finish
+        while(file.read(reinterpret_cast<char*>(entry), sizeof(entry)))
+        {
+            _index.push_back(IndexEntry{ get_le(entry, 8), get_le(entry + 8, 8), get_le(entry + 16, 8), get_le(entry + 24, 8) });
+        }
+
+        return true;
+    }
+
+    void TraceReader::read_index()
+    {
+        if(!_indexed && !load_index())
+        {
+            scan_index();
+        }
+        _indexed = true;
+    }
+
+    void TraceReader::scan_index()
+    {
+        uint64_t offset = sizeof(_trace_magic) + 1;
+        uint64_t checkpoint = UINT64_MAX;
+        uint8_t header[BLOCK_HEADER_SIZE];
+
+        _file.clear();
+        _file.seekg(offset);
+
+        // Only the headers are read, payloads are skipped
+        while(_file.read(reinterpret_cast<char*>(header), sizeof(header)))
+        {
+            if(header[0] == TraceWriter::BLOCK_MEMORY)
+            {
+                checkpoint = offset;
+            }
+            else
+            {
+                _index.push_back(IndexEntry{ get_le(header + 13, 8), get_le(header + 21, 8), offset, checkpoint });
+            }
+
+            offset += sizeof(header) + get_le(header + 5, 4);
+            _file.seekg(offset);
+        }
+    }
+
+    template <typename Match>
+    bool TraceReader::seek_from(size_t entry, Match match)
+    {
+        if(_index[entry].checkpoint == UINT64_MAX)
+        {
+            return false;
+        }
+
+        _file.clear();
+        _file.seekg(_index[entry].checkpoint);
+        _records = 0;
+        _has_pending = false;
+        _failed = false;
+
+        TraceRecord record;
+        while(read_record(record))
+        {
+            if(match(record))
+            {
+                _pending = record;
+                _has_pending = true;
+                return true;
+            }
+
+            for(int i = 0; i < record.write_count; i ++)
+            {
+                _memory[(uint16_t)(record.write_address + i)] = record.write_values[i];
+            }
+        }
+
+        return false;
+    }
+
+    bool TraceReader::seek(uint64_t instruction)
+    {
+        read_index();
+
+        std::vector<IndexEntry>::const_iterator it = std::upper_bound(_index.begin(), _index.end(), instruction,
+            [](uint64_t value, const IndexEntry& e) { return value < e.instruction; });
+
+        if(it == _index.begin())
+        {
+            return false;
+        }
+
+        return seek_from(it - _index.begin() - 1, [instruction](const TraceRecord& r) { return r.instruction >= instruction; });
+    }
+
+    bool TraceReader::seek_cycle(uint64_t cycle)
+    {
+        read_index();
+
+        std::vector<IndexEntry>::const_iterator it = std::upper_bound(_index.begin(), _index.end(), cycle,
+            [](uint64_t value, const IndexEntry& e) { return value < e.cycles; });
+
+        if(it == _index.begin())
+        {
+            return false;
+        }
+
+        return seek_from(it - _index.begin() - 1, [cycle](const TraceRecord& r) { return r.after.cycles > cycle; });
+    }
+
+    bool TraceReader::decode(TraceRecord& record)
+    {
+        const uint8_t* data = _data.data();
+        size_t size = _data.size();
+
+        if(size - _offset < 3)
+        {
+            return false;
+        }
+
+        uint8_t kind = data[_offset++];
+        uint8_t opcode = data[_offset++];
+        uint8_t step = data[_offset++];
+
+        record.instruction = _state.instruction;
+        record.address = _state.program_counter;
+        record.opcode = opcode;
+        record.interrupt = (kind & TraceWriter::KIND_INTERRUPT) != 0;
+
+        uint16_t program_counter = (uint16_t)(_state.program_counter + (step & 0x03));
+        if(!(step & 0x03))
+        {
+            if(size - _offset < 2)
+            {
+                return false;
+            }
+            program_counter = (uint16_t)get_le(data + _offset, 2);
+            _offset += 2;
+        }
+
+        uint64_t cycles = step >> 2;
+        if(cycles == TraceWriter::STEP_CYCLES_ESCAPE && !read_varint(data, size, _offset, cycles))
+        {
+            return false;
+        }
+
+        if(kind & TraceWriter::KIND_REGISTERS)
+        {
+            if(_offset >= size)
+            {
+                return false;
+            }
+
+            uint8_t mask = data[_offset++];
+            for(int i = 0; i < 8; i ++)
+            {
+                if(mask & (1 << i))
+                {
+                    if(_offset >= size)
+                    {
+                        return false;
+                    }
+                    _state.registers[i] = data[_offset++];
+                }
+            }
+        }
+
+        if(kind & TraceWriter::KIND_SP)
+        {
+            if(size - _offset < 2)
+            {
+                return false;
+            }
+            _state.stack_pointer = (uint16_t)get_le(data + _offset, 2);
+            _offset += 2;
+        }
+
+        record.write_count = kind & TraceWriter::KIND_WRITES;
+        if(record.write_count)
+        {
+            if(record.write_count > 2 || size - _offset < 2u + record.write_count)
+            {
+                return false;
+            }
+
+            record.write_address = (uint16_t)get_le(data + _offset, 2);
+            _offset += 2;
+            for(int i = 0; i < record.write_count; i ++)
+            {
+                record.write_values[i] = data[_offset++];
+            }
+        }
+
+        _state.instruction++;
+        _state.cycles += cycles;
+        _state.program_counter = program_counter;
+
+        record.cycle_delta = (uint32_t)cycles;
+        record.after = _state;
+
+        return true;
+    }
+}
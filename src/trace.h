@@ -0,0 +1,450 @@
+#pragma once
+#include "lib8085.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace lib8085
+{
+    /*
+     * Registers, SP, PC and T-states of the processor at some point in a trace.
+     * Registers are in the order A F B C D E H L, F in PSW layout.
+     *
+     */
+    struct TraceState
+    {
+        uint64_t instruction;
+        uint64_t cycles;
+        uint8_t registers[8];
+        uint16_t stack_pointer;
+        uint16_t program_counter;
+
+        void capture(const Processor& cpu, uint64_t instruction_number)
+        {
+            instruction = instruction_number;
+            cycles = cpu.cycles;
+            registers[0] = cpu.reg_a;
+            registers[1] = cpu.get_flags();
+            registers[2] = cpu.reg_b;
+            registers[3] = cpu.reg_c;
+            registers[4] = cpu.reg_d;
+            registers[5] = cpu.reg_e;
+            registers[6] = cpu.reg_h;
+            registers[7] = cpu.reg_l;
+            stack_pointer = cpu.stack_pointer;
+            program_counter = cpu.program_counter;
+        }
+
+        bool matches(const Processor& cpu) const
+        {
+            TraceState other;
+            other.capture(cpu, instruction);
+
+            return cycles == other.cycles && stack_pointer == other.stack_pointer
+                && program_counter == other.program_counter
+                && std::equal(registers, registers + 8, other.registers);
+        }
+    };
+
+    /*
+     * One traced instruction, or one interrupt entry, with the state after it.
+     *
+     */
+    struct TraceRecord
+    {
+        // Counted from the start of the trace
+        uint64_t instruction;
+        uint16_t address;
+        uint8_t opcode;
+        // The processor entered an interrupt handler instead of executing opcode
+        bool interrupt;
+        uint32_t cycle_delta;
+        TraceState after;
+        // Writes go to write_address and the byte after it
+        uint8_t write_count;
+        uint16_t write_address;
+        uint8_t write_values[2];
+    };
+
+    /*
+     * Streams every instruction run() executes to a binary trace file.
+     *
+     * Each record holds the opcode and only what changed: registers that differ
+     * from the previous record, SP when it moved, PC when it didn't advance by
+     * 1-3 bytes, the T-state delta and the bytes the instruction wrote. Records
+     * are collected in blocks that start from a full register keyframe so every
+     * block decodes on its own. Full blocks go to a background thread that
+     * compresses and writes them, the run loop only waits when QUEUE_DEPTH
+     * blocks are already pending.
+     *
+     * A copy of memory is written before the first block, every
+     * CHECKPOINT_BLOCKS blocks and whenever the processor was changed between
+     * runs. Next to the trace goes an index file, path + ".idx", with the
+     * instruction number, T-states and file offset of every block and of the
+     * memory checkpoint before it, so readers can seek without decoding the
+     * whole trace.
+     *
+     * What run() calls is defined here so the processor doesn't link against
+     * the file side.
+     *
+     */
+    class TraceWriter
+    {
+        public:
+            // Raw record bytes per block
+            static const size_t BLOCK_SIZE = 1 << 16;
+            static const size_t QUEUE_DEPTH = 8;
+            static const size_t MAX_RECORD_SIZE = 32;
+            static const size_t CHECKPOINT_BLOCKS = 64;
+
+            enum BlockType : uint8_t
+            {
+                BLOCK_RECORDS,
+                BLOCK_MEMORY
+            };
+
+            // Record layout: kind, opcode, step, [PC], [cycle varint], [register mask, registers], [SP], [writes]
+            enum Kind : uint8_t
+            {
+                KIND_WRITES    = 0x03, // Number of bytes written, the second goes to the address after the first
+                KIND_SP        = 0x04,
+                KIND_REGISTERS = 0x08,
+                KIND_INTERRUPT = 0x10
+            };
+
+            // step byte: bits 0-1 PC advance (0 = PC follows), bits 2-7 T-states (63 = varint follows)
+            static const uint8_t STEP_CYCLES_ESCAPE = 63;
+
+            TraceWriter();
+            ~TraceWriter();
+
+            TraceWriter(const TraceWriter&) = delete;
+            TraceWriter& operator=(const TraceWriter&) = delete;
+
+            bool open(const char* path);
+            // Writes the last partial block and waits for the writer thread, false if anything failed
+            bool close();
+
+            uint64_t instruction_count() const;
+            uint64_t raw_bytes() const;
+            uint64_t file_bytes() const;
+
+            // Called by Processor::run before a run, starts a new block with a memory
+            // checkpoint when the processor was changed since the last record
+            void begin(const Processor& cpu)
+            {
+                if(_need_checkpoint || !_state.matches(cpu))
+                {
+                    if(_block.records)
+                    {
+                        submit();
+                    }
+                    _block.start.capture(cpu, _instructions);
+                    _state = _block.start;
+                    checkpoint(cpu);
+                }
+            }
+
+            // Called by Processor::run after every instruction with the address, opcode and SP it started with
+            void record(const Processor& cpu, uint16_t address, uint8_t opcode, uint16_t stack_pointer, bool interrupted)
+            {
+                uint8_t* out = _block.data.data() + _block.size;
+                uint8_t* p = out + 3;
+                uint8_t kind = interrupted ? KIND_INTERRUPT : 0;
+
+                uint16_t advance = (uint16_t)(cpu.program_counter - address);
+                uint64_t cycles = cpu.cycles - _state.cycles;
+                uint8_t step = (uint8_t)(advance >= 1 && advance <= 3 && !interrupted ? advance : 0);
+
+                if(!(step & 0x03))
+                {
+                    *p++ = (uint8_t)cpu.program_counter;
+                    *p++ = (uint8_t)(cpu.program_counter >> 8);
+                }
+
+                if(cycles < STEP_CYCLES_ESCAPE)
+                {
+                    step |= (uint8_t)(cycles << 2);
+                }
+                else
+                {
+                    step |= STEP_CYCLES_ESCAPE << 2;
+                    for(uint64_t value = cycles; ; value >>= 7)
+                    {
+                        if(value < 0x80)
+                        {
+                            *p++ = (uint8_t)value;
+                            break;
+                        }
+                        *p++ = (uint8_t)(value | 0x80);
+                    }
+                }
+
+                uint8_t registers[8] = { cpu.reg_a, cpu.get_flags(), cpu.reg_b, cpu.reg_c, cpu.reg_d, cpu.reg_e, cpu.reg_h, cpu.reg_l };
+                uint8_t mask = 0;
+                uint8_t* mask_at = p++;
+
+                for(int i = 0; i < 8; i ++)
+                {
+                    if(registers[i] != _state.registers[i])
+                    {
+                        mask |= 1 << i;
+                        *p++ = registers[i];
+                        _state.registers[i] = registers[i];
+                    }
+                }
+
+                if(mask)
+                {
+                    kind |= KIND_REGISTERS;
+                    *mask_at = mask;
+                }
+                else
+                {
+                    p--;
+                }
+
+                if(cpu.stack_pointer != _state.stack_pointer)
+                {
+                    kind |= KIND_SP;
+                    *p++ = (uint8_t)cpu.stack_pointer;
+                    *p++ = (uint8_t)(cpu.stack_pointer >> 8);
+                }
+
+                uint16_t write_address = 0;
+                int writes = interrupted ? 2 : written(cpu, address, opcode, stack_pointer, write_address);
+
+                if(interrupted)
+                {
+                    write_address = cpu.stack_pointer;
+                }
+
+                if(writes)
+                {
+                    kind |= (uint8_t)writes;
+                    *p++ = (uint8_t)write_address;
+                    *p++ = (uint8_t)(write_address >> 8);
+                    for(int i = 0; i < writes; i ++)
+                    {
+                        *p++ = cpu.read_mem((uint16_t)(write_address + i));
+                    }
+                }
+
+                out[0] = kind;
+                out[1] = opcode;
+                out[2] = step;
+
+                _block.size += p - out;
+                _block.records++;
+                _instructions++;
+                _state.instruction = _instructions;
+                _state.cycles = cpu.cycles;
+                _state.stack_pointer = cpu.stack_pointer;
+                _state.program_counter = cpu.program_counter;
+
+                if(_block.size >= BLOCK_SIZE)
+                {
+                    submit();
+
+                    if(_need_checkpoint)
+                    {
+                        checkpoint(cpu);
+                    }
+                }
+            }
+
+        private:
+            struct Block
+            {
+                BlockType type;
+                // State before the first record
+                TraceState start;
+                std::vector<uint8_t> data;
+                size_t size;
+                uint32_t records;
+            };
+
+            std::string _path;
+            std::ofstream _file;
+            std::ofstream _index;
+            std::thread _thread;
+            std::mutex _mutex;
+            std::condition_variable _ready;
+            std::condition_variable _space;
+            std::deque<Block> _queue;
+            bool _closing;
+            std::atomic<bool> _failed;
+            std::atomic<uint64_t> _file_bytes;
+            // Offset of the last memory checkpoint, writer thread only
+            uint64_t _checkpoint_offset;
+
+            Block _block;
+            TraceState _state;
+            uint64_t _instructions;
+            uint64_t _raw_bytes;
+            uint64_t _blocks;
+            bool _need_checkpoint;
+
+            void write_blocks();
+            void write_block(const Block& block);
+
+            // Bytes the instruction wrote, how many and where
+            static int written(const Processor& cpu, uint16_t address, uint8_t opcode, uint16_t stack_pointer, uint16_t& write_address)
+            {
+                switch(opcode)
+                {
+                    case MOV_M_A: case MOV_M_B: case MOV_M_C: case MOV_M_D: case MOV_M_E: case MOV_M_H: case MOV_M_L:
+                    case MVI_M: case INR_M: case DCR_M: case STAX_H:
+                        write_address = (uint16_t)((cpu.reg_h << 8) | cpu.reg_l);
+                        return 1;
+                    case STAX_B:
+                        write_address = (uint16_t)((cpu.reg_b << 8) | cpu.reg_c);
+                        return 1;
+                    case STAX_D:
+                        write_address = (uint16_t)((cpu.reg_d << 8) | cpu.reg_e);
+                        return 1;
+                    case STA: case SHLD:
+                        write_address = (uint16_t)(cpu.read_mem((uint16_t)(address + 1)) | (cpu.read_mem((uint16_t)(address + 2)) << 8));
+                        return opcode == STA ? 1 : 2;
+                    case XTHL:
+                        write_address = cpu.stack_pointer;
+                        return 2;
+                    case PUSH_B: case PUSH_D: case PUSH_H: case PUSH_PSW:
+                    case CALL: case CC: case CNC: case CZ: case CNZ: case CP: case CM: case CPE: case CPO:
+                    case RST_0: case RST_1: case RST_2: case RST_3: case RST_4: case RST_5: case RST_6: case RST_7:
+                        // Conditional calls that aren't taken leave the stack where it was
+                        if(cpu.stack_pointer == (uint16_t)(stack_pointer - 2))
+                        {
+                            write_address = cpu.stack_pointer;
+                            return 2;
+                        }
+                        return 0;
+                }
+                return 0;
+            }
+
+            void new_block()
+            {
+                _block.type = BLOCK_RECORDS;
+                _block.start = _state;
+                _block.data.assign(BLOCK_SIZE + MAX_RECORD_SIZE, 0);
+                _block.size = 0;
+                _block.records = 0;
+            }
+
+            void push(Block&& block)
+            {
+                {
+                    std::unique_lock<std::mutex> lock(_mutex);
+                    _space.wait(lock, [this] { return _queue.size() < QUEUE_DEPTH; });
+
+                    _queue.push_back(std::move(block));
+                }
+                _ready.notify_one();
+            }
+
+            // Hands the full block to the writer thread
+            void submit()
+            {
+                _raw_bytes += _block.size;
+                push(std::move(_block));
+                new_block();
+
+                if(++_blocks % CHECKPOINT_BLOCKS == 0)
+                {
+                    _need_checkpoint = true;
+                }
+            }
+
+            // Memory as it is before the next record
+            void checkpoint(const Processor& cpu)
+            {
+                Block block;
+                block.type = BLOCK_MEMORY;
+                block.start = _state;
+                block.data.resize(MEM_PAGE_COUNT * MEM_PAGE_SIZE);
+                block.size = block.data.size();
+                block.records = 0;
+
+                for(size_t page = 0; page < MEM_PAGE_COUNT; page ++)
+                {
+                    const uint8_t* data = cpu.get_page(page);
+                    std::copy(data, data + MEM_PAGE_SIZE, block.data.data() + page * MEM_PAGE_SIZE);
+                }
+
+                push(std::move(block));
+                _need_checkpoint = false;
+            }
+    };
+
+    /*
+     * Decodes a trace file written by TraceWriter record by record, keeping
+     * memory up to date from the checkpoints and the recorded writes.
+     *
+     * seek() and seek_cycle() load the index written with the trace, or
+     * rebuild it from the block headers when it is missing, then decode
+     * forward from the closest memory checkpoint.
+     *
+     */
+    class TraceReader
+    {
+        public:
+            TraceReader();
+
+            bool open(const char* path);
+
+            // False at the end of the trace or when a block is damaged, see failed()
+            bool next(TraceRecord& record);
+            bool failed() const;
+
+            // Makes next() return the given instruction, false when the trace is shorter
+            bool seek(uint64_t instruction);
+            // Makes next() return the instruction that was running at T-state cycle
+            bool seek_cycle(uint64_t cycle);
+
+            // Memory before the record next() returns
+            const std::vector<uint8_t>& memory() const;
+
+        private:
+            struct IndexEntry
+            {
+                uint64_t instruction;
+                uint64_t cycles;
+                uint64_t offset;
+                uint64_t checkpoint;
+            };
+
+            std::string _path;
+            std::ifstream _file;
+            std::vector<uint8_t> _data;
+            size_t _offset;
+            uint32_t _records;
+            TraceState _state;
+            std::vector<uint8_t> _memory;
+            TraceRecord _pending;
+            bool _has_pending;
+            std::vector<IndexEntry> _index;
+            bool _indexed;
+            bool _failed;
+
+            bool read_block();
+            bool read_record(TraceRecord& record);
+            bool decode(TraceRecord& record);
+
+            // Loads the index file once, rebuilds it from the trace when missing
+            void read_index();
+            bool load_index();
+            void scan_index();
+            // Reads forward from the checkpoint of entry until match(record) holds
+            template <typename Match>
+            bool seek_from(size_t entry, Match match);
+    };
+}